@@ -0,0 +1,201 @@
+#include "acktracker.h"
+#include "logger.h"
+#include "plcframes.h"
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+int64_t steadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+int64_t AckTracker::nowMs() {
+    return steadyNowUs() / 1000;
+}
+
+void AckTracker::setOptions(const Options& opt) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    opt_ = opt;
+    opt_.window = std::max<size_t>(1, opt_.window);
+    opt_.timeoutMs = std::max(1, opt_.timeoutMs);
+    opt_.maxRetries = std::max(0, opt_.maxRetries);
+    inflight_.reserve(opt_.window);
+}
+
+bool AckTracker::parseKey(std::string_view frame, int& station, int& order) {
+    return plcframes::findKey(frame, station, order);
+}
+
+bool AckTracker::sendTracked(int station, int order, const std::string& frame, int64_t originNs) {
+    uint32_t key = makeKey(station, order);
+    int64_t nowUs = steadyNowUs();
+    Entry evicted;
+    uint32_t evictedKey = 0;
+    bool haveEvicted = false;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto it = inflight_.find(key);
+        if (it != inflight_.end()) {                                    //序列号回绕到仍在途的报文, 旧报文按未应答处理
+            evicted = std::move(it->second);
+            evictedKey = key;
+            haveEvicted = true;
+            inflight_.erase(it);
+        }
+        else if (inflight_.size() >= opt_.window) {                     //窗口满, 挤出最早的一条
+            auto oldest = std::min_element(inflight_.begin(), inflight_.end(), [](const auto& a, const auto& b) {
+                return a.second.regUs < b.second.regUs;
+            });
+            evicted = std::move(oldest->second);
+            evictedKey = oldest->first;
+            haveEvicted = true;
+            inflight_.erase(oldest);
+        }
+        Entry& e = inflight_[key];
+        e.frame = frame;
+        e.station = station;
+        e.originNs = originNs;
+        e.regUs = nowUs;
+        e.firstSendUs = 0;
+        e.lastSendMs = nowUs / 1000;
+        e.retries = 0;
+        e.sends = 0;
+    }
+    tracked_.fetch_add(1, std::memory_order_relaxed);
+    if (haveEvicted) giveUp(evictedKey, evicted, "evicted from window");
+    bool sent = deliver(Resend{ key, frame, station, originNs, nowUs, true }, nowUs / 1000, false);
+    if (!sent) deferred_.fetch_add(1, std::memory_order_relaxed);      //链路断开, 登记保留, 连接恢复后由 resendAll() 发出
+    return sent;
+}
+
+// 交给发送回调, 成功后记入登记(按登记时间确认仍是同一条, 期间可能已应答或被挤出); 失败不改登记, 不消耗重传次数
+bool AckTracker::deliver(const Resend& r, int64_t nowMs, bool timeout) {
+    if (!send_ || !send_(r.frame, r.first ? r.station : 0, r.first ? r.originNs : 0)) return false;
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = inflight_.find(r.key);
+    if (it == inflight_.end() || it->second.regUs != r.regUs) return true;
+    Entry& e = it->second;
+    if (e.sends == 0) e.firstSendUs = steadyNowUs();
+    else if (timeout) {
+        ++e.retries;
+        retransmits_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else replayed_.fetch_add(1, std::memory_order_relaxed);
+    ++e.sends;
+    e.lastSendMs = nowMs;
+    return true;
+}
+
+bool AckTracker::onAck(std::string_view frame) {
+    int station = 0;
+    int order = 0;
+    if (!parseKey(frame, station, order)) {
+        unmatched_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    int64_t nowUs = steadyNowUs();
+    int sends = 0;
+    int64_t firstSendUs = 0;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto it = inflight_.find(makeKey(station, order));
+        if (it == inflight_.end()) {
+            unmatched_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        sends = it->second.sends;
+        firstSendUs = it->second.firstSendUs;
+        inflight_.erase(it);
+    }
+    acked_.fetch_add(1, std::memory_order_relaxed);
+    if (sends == 1) rtt_.record(nowUs - firstSendUs);
+    else if (sends > 1) ackedAfterRetry_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AckTracker::tick(int64_t nowMs) {
+    std::vector<std::pair<uint32_t, Entry>> expired;
+    std::vector<std::pair<uint32_t, Entry>> noAck;
+    resend_.clear();
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (auto it = inflight_.begin(); it != inflight_.end();) {
+            Entry& e = it->second;
+            if (opt_.ttlMs > 0 && nowMs - e.regUs / 1000 >= opt_.ttlMs) {      //包裹已过 TTL, 不再发送
+                expired.emplace_back(it->first, std::move(e));
+                it = inflight_.erase(it);
+                continue;
+            }
+            if (nowMs - e.lastSendMs < opt_.timeoutMs) {
+                ++it;
+                continue;
+            }
+            if (e.sends > 0 && e.retries >= opt_.maxRetries) {            //发出过且重发用尽
+                noAck.emplace_back(it->first, std::move(e));
+                it = inflight_.erase(it);
+                continue;
+            }
+            e.lastSendMs = nowMs;                                       //发送失败时下一个超时周期再试
+            resend_.push_back(Resend{ it->first, e.frame, e.station, e.originNs, e.regUs, e.sends == 0 });
+            ++it;
+        }
+    }
+    std::sort(resend_.begin(), resend_.end(), [](const Resend& a, const Resend& b) { return a.regUs < b.regUs; });
+    for (const Resend& r : resend_) deliver(r, nowMs, true);
+    for (const auto& x : expired) giveUp(x.first, x.second, "expired");
+    for (const auto& x : noAck) giveUp(x.first, x.second, "no ack");
+}
+
+void AckTracker::resendAll() {
+    int64_t now = nowMs();
+    resend_.clear();
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (const auto& kv : inflight_) {
+            const Entry& e = kv.second;
+            resend_.push_back(Resend{ kv.first, e.frame, e.station, e.originNs, e.regUs, e.sends == 0 });
+        }
+    }
+    std::sort(resend_.begin(), resend_.end(), [](const Resend& a, const Resend& b) { return a.regUs < b.regUs; });
+    size_t sent = 0;
+    for (const Resend& r : resend_) {
+        if (!deliver(r, now, false)) break;                              //连接又断开, 剩下的等下一次连接
+        ++sent;
+    }
+    if (!resend_.empty()) {
+        Logger::getInstance().Log("----[AckTracker] [" + name_ + "] resendAll() replay inflight frames: [" + std::to_string(sent)
+                                  + "/" + std::to_string(resend_.size()) + "]");
+    }
+}
+
+void AckTracker::clear() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    inflight_.clear();
+}
+
+void AckTracker::giveUp(uint32_t key, const Entry& e, const char* reason) {
+    unacked_.fetch_add(1, std::memory_order_relaxed);
+    Logger::getInstance().Log("----[AckTracker] [" + name_ + "] unacked frame: [" + e.frame + "] station:[" + std::to_string(key / 10000)
+                              + "] order:[" + std::to_string(key % 10000) + "] sends:[" + std::to_string(e.sends)
+                              + "] retries:[" + std::to_string(e.retries)
+                              + "] age_ms:[" + std::to_string(nowMs() - e.regUs / 1000) + "] " + reason);
+}
+
+AckTracker::Stats AckTracker::stats() const {
+    Stats s;
+    s.tracked = tracked_.load(std::memory_order_relaxed);
+    s.acked = acked_.load(std::memory_order_relaxed);
+    s.ackedAfterRetry = ackedAfterRetry_.load(std::memory_order_relaxed);
+    s.retransmits = retransmits_.load(std::memory_order_relaxed);
+    s.replayed = replayed_.load(std::memory_order_relaxed);
+    s.deferred = deferred_.load(std::memory_order_relaxed);
+    s.unacked = unacked_.load(std::memory_order_relaxed);
+    s.unmatched = unmatched_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        s.inflight = inflight_.size();
+    }
+    return s;
+}
@@ -0,0 +1,112 @@
+#ifndef ACKTRACKER_H
+#define ACKTRACKER_H
+
+// PLC 应答匹配: 发出的 STD/GK 报文按 (供包台, 序列号) 登记, 收到 PLC 的 AK 应答后销账并记录往返时延
+// 在途窗口有上限, 窗口满时最早的一条按未应答处理并腾出位置, 不阻塞发送
+// tick() 定时检查超时: 未超过重传次数的报文原样重发, 重传用尽仍无应答的报文计入 unacked 并输出日志
+// 发送回调返回 false(链路断开)不消耗重传次数, 登记照常保留; 连接恢复后由 resendAll() 按登记顺序整窗重发,
+// 断线期间的报文不会在链路恢复前被判为无应答. 登记超过 ttlMs 的报文按过期放弃
+// 发出过不止一次的报文收到应答时不计往返时延(无法区分应答对应哪一次发送)
+// 所有接口线程安全, 发送回调在锁外调用
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "latencyhistogram.h"
+
+class AckTracker {
+public:
+    struct Options {
+        int timeoutMs = 500;                // 发送后等待应答的时间
+        int maxRetries = 2;                 // 超时重发次数, 0 为只统计不重发
+        size_t window = 256;                // 在途报文上限
+        int64_t ttlMs = 0;                  // 登记后超过此时间仍无应答即放弃(包裹 TTL), 0 为不限
+    };
+    // station/originNs 只在第一次成功发送时给出, 重发时为 0, 供发送端统计第一次写出的延时
+    using SendFn = std::function<bool(const std::string& frame, int station, int64_t originNs)>;
+
+    struct Stats {
+        uint64_t tracked = 0;               // 登记的报文数
+        uint64_t acked = 0;                 // 收到应答的报文数
+        uint64_t ackedAfterRetry = 0;       // 其中经过重发才收到应答的
+        uint64_t retransmits = 0;           // 超时重发次数
+        uint64_t replayed = 0;              // 连接恢复后整窗重发的报文数
+        uint64_t deferred = 0;              // 登记时链路断开、等连接恢复再发的报文数
+        uint64_t unacked = 0;               // 重发用尽仍无应答, 或被挤出窗口的报文数
+        uint64_t unmatched = 0;             // 找不到对应在途报文的应答(重复应答或已放弃的报文)
+        uint64_t inflight = 0;              // 当前在途报文数
+    };
+
+    explicit AckTracker(const std::string& name) : name_(name) {}
+    AckTracker(const AckTracker&) = delete;
+    AckTracker& operator=(const AckTracker&) = delete;
+
+    void setOptions(const Options& opt);
+    void setSend(SendFn fn) { send_ = std::move(fn); }
+    const std::string& name() const { return name_; }
+
+    // 从报文中取 D<供包台2位>ID<序列号4位>, 如 "AKD01ID000100000" -> (1, 1)
+    static bool parseKey(std::string_view frame, int& station, int& order);
+
+    // 登记并发送, 返回本次是否发出; 发送失败(未连接)时照常登记, 连接恢复后由 resendAll() 发出; originNs 原样交给发送回调
+    bool sendTracked(int station, int order, const std::string& frame, int64_t originNs = 0);
+    // 收到一帧应答(不含 '#'), 匹配到在途报文返回 true
+    bool onAck(std::string_view frame);
+    // 定时调用, 处理超时重发
+    void tick(int64_t nowMs);
+    // 连接建立后调用(引擎 onConnected): 在途报文按登记顺序全部重发, 断线时留在旧连接里的报文由这里补上
+    void resendAll();
+    // 连接停止时丢弃全部在途报文, 不计入 unacked
+    void clear();
+
+    Stats stats() const;
+    LatencyHistogram::Summary takeRtt() { return rtt_.takeSummary(); }     // 发送到收到应答的往返时延
+
+    static int64_t nowMs();
+
+private:
+    struct Entry {
+        std::string frame;
+        int station = 0;
+        int64_t originNs = 0;
+        int64_t regUs = 0;                  // 登记时间, 决定重发顺序和窗口挤出, ttlMs 从这里算
+        int64_t firstSendUs = 0;            // 第一次成功发出的时间, 往返时延从这里算
+        int64_t lastSendMs = 0;             // 最近一次尝试发送的时间, 超时从这里算
+        int retries = 0;                    // 已消耗的超时重发次数
+        int sends = 0;                      // 成功交给发送回调的次数
+    };
+    struct Resend {
+        uint32_t key;
+        std::string frame;
+        int station;
+        int64_t originNs;
+        int64_t regUs;
+        bool first;                         // 还没有成功发出过
+    };
+    static uint32_t makeKey(int station, int order) { return static_cast<uint32_t>(station) * 10000u + static_cast<uint32_t>(order); }
+    void giveUp(uint32_t key, const Entry& e, const char* reason);
+    bool deliver(const Resend& r, int64_t nowMs, bool timeout);
+
+    std::string name_;
+    Options opt_;
+    SendFn send_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, Entry> inflight_;      // 由 mutex_ 保护
+    std::vector<Resend> resend_;                        // tick/resendAll 中收集待发报文, 只在引擎线程使用
+    LatencyHistogram rtt_;
+    std::atomic<uint64_t> tracked_{ 0 };
+    std::atomic<uint64_t> acked_{ 0 };
+    std::atomic<uint64_t> ackedAfterRetry_{ 0 };
+    std::atomic<uint64_t> retransmits_{ 0 };
+    std::atomic<uint64_t> replayed_{ 0 };
+    std::atomic<uint64_t> deferred_{ 0 };
+    std::atomic<uint64_t> unacked_{ 0 };
+    std::atomic<uint64_t> unmatched_{ 0 };
+};
+
+#endif // ACKTRACKER_H
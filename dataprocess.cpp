@@ -1,48 +1,122 @@
 #include "DataProcess.h"
 #include "Logger.h"
-#include <QtConcurrent/QtConcurrent>
-#include <sstream>
+#include "plcframes.h"
 #include "sqlconnectionpool.h"
-extern std::tuple<std::string, std::string, int> splitUdpMessage(const std::string& msg);
+#include <cstdio>
 extern std::string getCurrentTime();
 DataProcess::DataProcess()                      //开服务,并初始化程序中的资源以及设置
 {
     try {
-        _udpSupplyReceiver = new UdpReceiver(3011, "192.168.2.98");             //接收拱包信息
-        _udpSupplyReceiver->setCallback([this](const std::vector<uint8_t>& data, const std::string& ip, uint16_t port)
-                                        {
-                                            const std::string& text = std::string(data.begin(), data.end());
-                                            supplyRaw r{text};
-                                            if(!supplyRing.try_push(r)){
-                                                supplyRingDrops.fetch_add(1,std::memory_order_relaxed);
-                                            }
-                                        });
-        _udpSupplyReceiver->start();
-        startSupplyWorker();
+        if(!load_RuntimeConfig("config.json", m_config)){
+            Logger::getInstance().Log("----[DataProcess] DataProcess() failed to read config.json, use default runtime config");
+        }
+        unloadRing.set_wait_strategy(parseRingWaitStrategy(m_config.unloadWait));
+        slotStatusRing.set_wait_strategy(parseRingWaitStrategy(m_config.slotStatusWait));
+        openSpill(unloadSpill, "unload");
+        openSpill(slotStatusSpill, "slot_status");
+        m_parcelState.configure(m_config.parcelStateShards, static_cast<size_t>(std::max(1, m_config.parcelStateQueue)));
+        m_parcelState.setExpiry(static_cast<int64_t>(std::max(0, m_config.parcelTtlSec)) * 1000,
+                                [this](const ParcelStateService::ExpiredParcel& parcel){ onParcelExpired(parcel); },
+                                static_cast<size_t>(std::max(0, m_config.expiryMaxPerTick)));
+        m_parcelState.setOnUnloaded([this](const UnloadRecord& rec, const ParcelStateService::UnloadLookup& parcel){ onParcelUnloaded(rec, parcel); });
+        m_parcelState.start();                                                          //包裹状态在停止/运行之间保留, 只在清理资源时停止
+        startSupplyShards();                                                            //接收拱包信息
         m_recvPdaServer = new QtTcpServer(this);                                        //接收PDA消息
         if (!m_recvPdaServer->start(m_recvPdaPort)) {
             Logger::getInstance().Log("----[DataProcess] DataProcess() Failed to start pda TCP server on port " + std::to_string(m_recvPdaPort));
         }
         connect(m_recvPdaServer, &QtTcpServer::messageReceived, this, &DataProcess::onPdaTCPServerRecv, Qt::QueuedConnection);
+        qRegisterMetaType<WaybillCode>("WaybillCode");                                  //单号跨线程传给请求类及格口结果回传
         connect(&m_requestAPI,&JTRequest::slotResult,this, &DataProcess::onTerminalCodeRecv, Qt::QueuedConnection);
-        m_supplyIDToOrder.resize(12);                       //初始化每个供包台的序列号
-        for(int i = 0; i<12;++i){
-            m_supplyIDToOrder[i] = 0;
+        for(int i = 0; i<kStationCount;++i){                //初始化每个供包台的序列号
+            m_supplyIDToOrder[i].store(0, std::memory_order_relaxed);
         }
         dbInit();
-        m_plc_unloadClient.onRawData = [this](const QByteArray& data){
-            receiveRaw r{data};
-            if(!unloadRing.try_push(r)){
-                unloadRingDrops.fetch_add(1,std::memory_order_relaxed);
-            }
-        };
-        m_plc_slotStatusClient.onRawData = [this](const QByteArray& data){
-            receiveRaw r{data};
-            if(!slotStatusRing.try_push(r)){
-                slotStatusRingDrops.fetch_add(1,std::memory_order_relaxed);
+        PlcIoEngine::Options plcOpt;
+        plcOpt.reconnectMs = std::max(100, m_config.plcReconnectMs);
+        plcOpt.reconnectMaxMs = std::max(plcOpt.reconnectMs, m_config.plcReconnectMaxMs);
+        plcOpt.connectTimeoutMs = std::max(100, m_config.plcConnectTimeoutMs);
+        plcOpt.heartbeatMs = std::max(0, m_config.plcHeartbeatMs);
+        plcOpt.heartbeat = m_config.plcHeartbeat;
+        plcOpt.heartbeatEcho = m_config.plcHeartbeatEcho && !m_config.plcHeartbeat.empty();
+        plcOpt.heartbeatTimeoutMs = std::max(50, m_config.plcHeartbeatTimeoutMs);
+        plcOpt.keepaliveIdleMs = std::max(0, m_config.plcKeepaliveIdleMs);
+        plcOpt.keepaliveIntervalMs = std::max(1, m_config.plcKeepaliveIntervalMs);
+        plcOpt.userTimeoutMs = std::max(0, m_config.plcUserTimeoutMs);
+        m_plcEngine.setOptions(plcOpt);
+        AckTracker::Options ackOpt;
+        ackOpt.timeoutMs = std::max(10, m_config.ackTimeoutMs);
+        ackOpt.maxRetries = std::max(0, m_config.ackRetries);
+        ackOpt.window = static_cast<size_t>(std::max(1, m_config.ackWindow));
+        ackOpt.ttlMs = static_cast<int64_t>(std::max(0, m_config.parcelTtlSec)) * 1000;
+        m_supplyAck.setOptions(ackOpt);
+        m_slotAck.setOptions(ackOpt);
+        //STD/GK 只写给当前连接, 断线时由 AckTracker 保留并在重连后整窗重发, 引擎不再另外保留一份
+        m_supplyAck.setSend([this](const std::string& frame, int station, int64_t originNs){ return m_plcEngine.send(m_connSupply, frame, originNs, station, PlcIoEngine::kThisConnection); });
+        m_slotAck.setSend([this](const std::string& frame, int station, int64_t originNs){ return m_plcEngine.send(m_connSendSlot, frame, originNs, station, PlcIoEngine::kThisConnection); });
+        m_plcEngine.setTicker(std::max(10, ackOpt.timeoutMs / 5), [this](int64_t nowMs){                   //引擎线程定时检查应答超时
+            m_supplyAck.tick(nowMs);
+            m_slotAck.tick(nowMs);
+        });
+        m_connSupply = m_plcEngine.addConnection("supply", m_plc_ip, m_plc_supply, [this](const char* p, size_t n){             //回调在引擎线程, 按'#'分帧后转到主线程处理
+            m_supplyDecoder.feed(p, n, [this](std::string_view f){
+                if(classifyPlcFrame(f) == PlcFrameKind::Ack) m_supplyAck.onAck(f);                         //在引擎线程销账, 往返时延不含排队到主线程的时间
+                QMetaObject::invokeMethod(this, "onPLCSupplyRecv", Qt::QueuedConnection, Q_ARG(QByteArray, QByteArray(f.data(), static_cast<int>(f.size()))));
+            });
+        });
+        m_connSendSlot = m_plcEngine.addConnection("send slot", m_plc_ip, m_plc_sendSlot, [this](const char* p, size_t n){
+            m_sendSlotDecoder.feed(p, n, [this](std::string_view f){
+                PlcFrameKind kind = classifyPlcFrame(f);
+                if(kind == PlcFrameKind::Ack || kind == PlcFrameKind::SlotCommand) m_slotAck.onAck(f);     //GK 的应答为 AK 或原样回传
+                QMetaObject::invokeMethod(this, "onPLCSendSlotRecv", Qt::QueuedConnection, Q_ARG(QByteArray, QByteArray(f.data(), static_cast<int>(f.size()))));
+            });
+        });
+        m_unloadDecoder.setRepeatWindowMs(m_config.unloadRepeatWindowMs);
+        m_connUnload = m_plcEngine.addConnection("unload", m_plc_ip, m_plc_unload, [this](const char* p, size_t n){           //整帧写入ring槽位, 带接收时间用于统计回复延时
+            int64_t rxNs = PlcIoEngine::nowNs();
+            m_unloadDecoder.feed(p, n, [this, rxNs](std::string_view f){
+                if(!pushPlcFrame(unloadRing, unloadSpill, f, rxNs, m_unloadDecoder.lastRepeated())) unloadRingDrops.fetch_add(1,std::memory_order_relaxed);
+            });
+        });
+        m_connSlotStatus = m_plcEngine.addConnection("slot status", m_plc_ip, m_plc_slotStatus, [this](const char* p, size_t n){
+            m_slotStatusDecoder.feed(p, n, [this](std::string_view f){
+                if(!pushPlcFrame(slotStatusRing, slotStatusSpill, f)) slotStatusRingDrops.fetch_add(1,std::memory_order_relaxed);
+            });
+        });
+        m_plcEngine.setOnConnected(m_connSupply, [this](){                                 //重连后丢弃旧连接的半帧, 在途 STD 按登记顺序重发
+            m_supplyDecoder.reset();
+            m_supplyAck.resendAll();
+        });
+        m_plcEngine.setOnConnected(m_connSendSlot, [this](){
+            m_sendSlotDecoder.reset();
+            m_slotAck.resendAll();
+        });
+        m_plcEngine.setOnConnected(m_connUnload, [this](){ m_unloadDecoder.reset(); });
+        m_plcEngine.setOnConnected(m_connSlotStatus, [this](){ m_slotStatusDecoder.reset(); });
+        m_plcEngine.setOnWire(m_connSupply, [this](int station, int64_t originNs, int64_t wireNs){             //读码到 STD/GK 整条交给内核的延时, 按供包台统计
+            recordScanLatency(m_scanToStdHist, station, wireNs - originNs);
+        });
+        m_plcEngine.setOnWire(m_connSendSlot, [this](int station, int64_t originNs, int64_t wireNs){
+            recordScanLatency(m_scanToGkHist, station, wireNs - originNs);
+            recordGkWire(station, wireNs - originNs);
+        });
+        m_plcEngine.setOnDrained(m_connSendSlot, [this](){ m_slotScheduler.kick(); });              //2062 待发数据写完, 调度线程取下一批
+        m_slotScheduler.setReady([this](){ return m_plcEngine.pendingBytes(m_connSendSlot) == 0; });  //写者忙时 GK 留在堆中按截止时间排序
+        m_slotScheduler.setSend([this](const SlotScheduler::Command& cmd){                  //按截止时间顺序写入 2062 发送队列
+            int station = 0;
+            int order = 0;
+            int64_t originNs = scanOriginNs(cmd.scanNs);
+            if(AckTracker::parseKey(cmd.frame, station, order)) return m_slotAck.sendTracked(station, order, cmd.frame, originNs);     //未连接时登记保留, 重连后重发
+            return m_plcEngine.send(m_connSendSlot, cmd.frame, originNs, cmd.stationId, frameExpireNs(originNs));
+        });
+        m_slotScheduler.setOnSent([this](const SlotScheduler::Command& cmd, bool sent, int64_t){
+            if(!sent){
+                Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() not sent now, tracked GK resend on reconnect, untracked dropped: ["+cmd.frame+"]");
+                return;
             }
-        };
-        connect(&m_plc_supplyClient, &SocketClient::dataReceived, this, &DataProcess::onPLCSupplyRecv);
+            Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() send message: ["+cmd.frame+"]");
+        });
+        startStatsThread();
     }
     catch (...) {}
 }
@@ -97,6 +171,14 @@ void DataProcess::dbInit(){
                 m_slotTodeliveryCodeMap[slot_id] = row[1];              //初始化格口对应的派件员编码， 进港
             }
         }
+        auto arrival_exception = arrival_terminalCodeToSlotMap.find("异常格");
+        m_arrivalExceptionSlot = arrival_exception != arrival_terminalCodeToSlotMap.end() ? arrival_exception->second : 0;
+        auto depature_exception = depature_terminalCodeToSlotMap.find("异常格");
+        m_departureExceptionSlot = depature_exception != depature_terminalCodeToSlotMap.end() ? depature_exception->second : 0;
+        if(m_arrivalExceptionSlot <= 0 || m_departureExceptionSlot <= 0){                                 //未配置时异常件只上件不下发格口, 由线体循环
+            Logger::getInstance().Log("----[DataProcess] dbInit() exception slot not configured, arrival: [" + std::to_string(m_arrivalExceptionSlot)
+                                      + "] departure: [" + std::to_string(m_departureExceptionSlot) + "], no-read parcels will not be sent a slot");
+        }
     }catch(...){}
 }
 void DataProcess::setOperateType(int type){                                             //设置操作模式
@@ -106,484 +188,754 @@ void DataProcess::setOperateType(int type){
 int DataProcess::getOperateType(){
     return m_operateType;
 }
-void DataProcess::startSupplyWorker(){                                                  //接收供包信息
+static int64_t steadyNowUs(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static void atomicMax(std::atomic<uint64_t>& target, uint64_t value){
+    uint64_t cur = target.load(std::memory_order_relaxed);
+    while(value > cur && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed)){}
+}
+void DataProcess::startSupplyShards(){                                                  //一个接收socket, 按供包台号把报文分发到各处理分片
+    int shards = std::clamp(m_config.supplyShards, 1, kStationCount);
     supplyWorkerRunning = true;
-    supplyWorkerThread = std::thread([this](){
+    size_t batch = static_cast<size_t>(std::clamp(m_config.supplyBatch, 1, 64));
+    for(int i = 0; i < shards; ++i){
+        auto shard = std::make_unique<SupplyShard>();
+        shard->index = i;
+        if(m_config.dedupWindowMs > 0){                                                 //重复读码抑制, 同一供包台固定在一个分片, 分片内去重即可
+            shard->dedup = std::make_unique<ScanDedup>(static_cast<size_t>(std::max(16, m_config.dedupCapacity)), m_config.dedupWindowMs);
+        }
+        shard->ring.set_wait_strategy(parseRingWaitStrategy(m_config.supplyWait));
+        openSpill(shard->spill, "supply_" + std::to_string(i));
+        m_supplyShards.push_back(std::move(shard));
+    }
+    m_supplyReceiver.setRxTimestamps(m_config.rxTimestamps);
+    if(shards == 1){                                                                    //单分片: 报文直接写入ring槽位, 不做拷贝
+        SupplyShard* sh = m_supplyShards.front().get();
+        m_supplyReceiver.setSlotSink([sh](UdpReceiver::RecvSlot* out, size_t max) -> size_t
+                                     {
+                                         if(sh->spill.active()) return 0;                                     //溢出文件有积压, 新报文继续写文件
+                                         size_t n = sh->ring.try_reserve_bulk(sh->reserved, std::min<size_t>(max, 64));
+                                         for(size_t k = 0; k < n; ++k){
+                                             out[k] = UdpReceiver::RecvSlot{reinterpret_cast<uint8_t*>(sh->reserved[k]->data), kSupplyMaxLen, &sh->reserved[k]->len, &sh->reserved[k]->rxNs};
+                                         }
+                                         return n;
+                                     },
+                                     [sh](size_t n){
+                                         int64_t now = steadyNowUs();
+                                         for(size_t k = 0; k < n; ++k) sh->reserved[k]->recvUs = now;
+                                         sh->received.fetch_add(n, std::memory_order_relaxed);
+                                         sh->ring.commit(n);
+                                     },
+                                     [sh](const UdpReceiver::Datagram* msgs, size_t count){             //ring已满或溢出文件有积压
+                                         for(size_t k = 0; k < count; ++k) spillSupply(*sh, msgs[k]);
+                                         sh->ring.wake();
+                                     }, batch);
+    }
+    else{                                                                               //多分片: 接收线程只解析供包台号, 拷贝到对应分片的ring
+        m_supplyReceiver.setBatchCallback([this](const UdpReceiver::Datagram* msgs, size_t count){
+                                              dispatchSupplyBatch(msgs, count);
+                                          }, batch, kSupplyMaxLen + 1);
+    }
+    for(auto& sh : m_supplyShards){
+        startSupplyWorker(*sh);
+    }
+    if(!m_supplyReceiver.start()){
+        Logger::getInstance().Log("----[DataProcess] startSupplyShards() failed to start udp receiver");
+    }
+    Logger::getInstance().Log("----[DataProcess] startSupplyShards() supply shards: [" + std::to_string(shards) + "]");
+}
+void DataProcess::spillSupply(SupplyShard& shard, const UdpReceiver::Datagram& msg){   //写入溢出文件, 记录为 [接收时间][报文]
+    if(msg.len == 0 || msg.len > kSupplyMaxLen) return;
+    shard.received.fetch_add(1, std::memory_order_relaxed);
+    if(!shard.spill.append(msg.data, static_cast<uint32_t>(msg.len), &msg.rxNs, sizeof(int64_t))) shard.drops.fetch_add(1, std::memory_order_relaxed);
+}
+void DataProcess::dispatchSupplyBatch(const UdpReceiver::Datagram* msgs, size_t count){        //接收线程: 按供包台号分组, 每个分片一次reserve/commit, 分片内保持到达顺序
+    const size_t shards = m_supplyShards.size();
+    uint8_t index[kStationCount][64];
+    size_t used[kStationCount] = {};
+    for(size_t k = 0; k < count && k < 64; ++k){
+        int station = peekScanStation(std::string_view(reinterpret_cast<const char*>(msgs[k].data), msgs[k].len));
+        size_t target = station > 0 ? static_cast<size_t>(station - 1) % shards : 0;        //无法确定供包台的报文由分片0解析并记录
+        index[target][used[target]++] = static_cast<uint8_t>(k);
+    }
+    int64_t now = steadyNowUs();
+    for(size_t s = 0; s < shards; ++s){
+        if(used[s] == 0) continue;
+        SupplyShard& sh = *m_supplyShards[s];
+        size_t n = sh.spill.active() ? 0 : sh.ring.try_reserve_bulk(sh.reserved, used[s]);   //溢出文件有积压时新报文继续写文件
+        size_t published = 0;
+        for(size_t k = 0; k < n; ++k){
+            const UdpReceiver::Datagram& msg = msgs[index[s][k]];
+            supplyRaw* slot = sh.reserved[k];
+            slot->len = msg.len <= kSupplyMaxLen ? static_cast<uint32_t>(msg.len) : 0;     //超长报文占位, 处理线程跳过
+            if(slot->len) std::memcpy(slot->data, msg.data, slot->len);
+            slot->rxNs = msg.rxNs;
+            slot->recvUs = now;
+            ++published;
+        }
+        if(published){
+            sh.received.fetch_add(published, std::memory_order_relaxed);
+            sh.ring.commit(published);
+        }
+        if(n < used[s]){
+            for(size_t k = n; k < used[s]; ++k) spillSupply(sh, msgs[index[s][k]]);
+            sh.ring.wake();
+        }
+    }
+}
+void DataProcess::startSupplyWorker(SupplyShard& shard){                                //处理供包信息, 同一供包台的报文固定在一个分片内, 保证供包台内顺序
+    SupplyShard* sh = &shard;
+    sh->worker = std::thread([this, sh](){
         const size_t BATCH = 256;
-        supplyRaw batch[BATCH];
-        Logger::getInstance().Log("----[DataProcess] startSupplyWorker() start receive supply thread!");
+        supplyRaw* batch[BATCH];                                //直接指向ring中的槽位, 处理完再归还
+        Logger::getInstance().Log("----[DataProcess] startSupplyWorker() start receive supply thread! shard: [" + std::to_string(sh->index) + "]");
         while (supplyWorkerRunning) {
-            size_t n = supplyRing.pop_bulk(batch, BATCH);
-            if(n == 0){                                         //空闲
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
-                continue;
+            size_t n = 0;
+            if(sh->spill.active()){                                     //溢出文件有积压: 先处理ring中较早的报文, ring空后按顺序读回
+                n = sh->ring.peek_bulk(batch, BATCH);
+                if(n == 0){
+                    size_t drained = sh->spill.drain([this, sh](const char* p, uint32_t len){
+                        if(len < sizeof(int64_t)) return;
+                        int64_t rxNs = 0;
+                        std::memcpy(&rxNs, p, sizeof(rxNs));
+                        ingestSupplyMessage(*sh, std::string_view(p + sizeof(rxNs), len - sizeof(rxNs)), rxNs);
+                    }, BATCH);
+                    sh->processed.fetch_add(drained, std::memory_order_relaxed);
+                    continue;
+                }
+            }
+            else{
+                n = sh->ring.wait_peek_bulk(batch, BATCH, supplyWorkerRunning);     //空闲时按配置的等待方式等待
             }
+            if(n == 0) continue;
             for (size_t i =0;i<n;++i){
-                const std::string& data = batch[i].data;
-                onSupplyUDPServerRecv(data);
+                if(batch[i]->len == 0) continue;                //超长报文, 已在接收线程丢弃
+                ingestSupplyMessage(*sh, batch[i]->view(), batch[i]->rxNs);
+                uint64_t latency = static_cast<uint64_t>(std::max<int64_t>(0, steadyNowUs() - batch[i]->recvUs));
+                sh->latencySumUs.fetch_add(latency, std::memory_order_relaxed);
+                atomicMax(sh->latencyMaxUs, latency);
             }
+            sh->processed.fetch_add(n, std::memory_order_relaxed);
+            sh->ring.release(n);
         }
     });
 }
 void DataProcess::stopSupplyWorker(){                                                   //停止接收
     supplyWorkerRunning = false;
-    if(supplyWorkerThread.joinable()) supplyWorkerThread.join();
+    for(auto& sh : m_supplyShards){
+        sh->ring.wake();
+        if(sh->worker.joinable()) sh->worker.join();
+    }
+}
+void DataProcess::startStatsThread(){                                                   //定时输出统计信息
+    if(m_config.statsIntervalSec <= 0 || m_statsRunning.load()) return;
+    m_statsRunning.store(true);
+    m_statsThread = std::thread([this](){
+        auto next = std::chrono::steady_clock::now() + std::chrono::seconds(m_config.statsIntervalSec);
+        while(m_statsRunning.load()){
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if(std::chrono::steady_clock::now() < next) continue;
+            next += std::chrono::seconds(m_config.statsIntervalSec);
+            try{
+                reportStats();
+            }catch(...){}
+        }
+    });
+}
+void DataProcess::stopStatsThread(){
+    m_statsRunning.store(false);
+    if(m_statsThread.joinable()) m_statsThread.join();
+}
+template<typename T>
+static void logRingWake(const std::string& name, SpscRing<T>& ring){                     //消费者唤醒延迟及占用高水位
+    uint64_t wakeups = ring.wakeups();
+    uint64_t avgNs = wakeups ? ring.wake_latency_sum_ns() / wakeups : 0;
+    Logger::getInstance().Log("----[DataProcess] reportStats() ring [" + name
+                              + "] capacity:[" + std::to_string(ring.capacity())
+                              + "] high_water:[" + std::to_string(ring.take_high_water_mark())
+                              + "] wakeups:[" + std::to_string(wakeups)
+                              + "] wake_avg_ns:[" + std::to_string(avgNs)
+                              + "] wake_max_ns:[" + std::to_string(ring.take_wake_latency_max_ns()) + "]");
+}
+void DataProcess::openSpill(SpillQueue& spill, const std::string& name){              //按配置打开ring的溢出文件, 未开启时ring满直接丢弃
+    if(m_config.overflowPolicy != "spill") return;
+    std::string path = m_config.spillDir + "/" + name + ".spill";
+    if(!spill.open(path, static_cast<size_t>(std::max(1, m_config.spillMb)) << 20)){
+        Logger::getInstance().Log("----[DataProcess] openSpill() failed to open spill file: [" + path + "], overflow messages will be dropped");
+    }
+}
+void DataProcess::logSpill(const std::string& name, const SpillQueue& spill, uint64_t drops){  //溢出文件积压及读回速率
+    if(!spill.isOpen() && drops == 0) return;
+    uint64_t drained = spill.drained();
+    uint64_t last = m_spillDrainedAtReport[&spill];
+    m_spillDrainedAtReport[&spill] = drained;
+    uint64_t rate = (drained - last) / static_cast<uint64_t>(std::max(1, m_config.statsIntervalSec));
+    Logger::getInstance().Log("----[DataProcess] reportStats() spill [" + name
+                              + "] depth:[" + std::to_string(spill.depth())
+                              + "] bytes:[" + std::to_string(spill.bytes())
+                              + "] spilled:[" + std::to_string(spill.spilled())
+                              + "] drained:[" + std::to_string(drained)
+                              + "] drain_per_s:[" + std::to_string(rate)
+                              + "] drops:[" + std::to_string(drops) + "]");
+}
+template<typename T>
+void DataProcess::logStage(PipelineStage<T>& stage){                                        //流水线各级队列深度、背压及处理耗时
+    typename PipelineStage<T>::Stats st = stage.stats();
+    Logger::getInstance().Log("----[DataProcess] reportStats() stage [" + stage.name()
+                              + "] depth:[" + std::to_string(st.depth)
+                              + "] max_depth:[" + std::to_string(st.maxDepth)
+                              + "] pushed:[" + std::to_string(st.pushed)
+                              + "] processed:[" + std::to_string(st.processed)
+                              + "] errors:[" + std::to_string(st.errors)
+                              + "] backpressure:[" + std::to_string(st.backpressure)
+                              + "] rejected:[" + std::to_string(st.rejected)
+                              + "] overflowed:[" + std::to_string(st.overflowed)
+                              + "] queue_wait " + LatencyHistogram::format(stage.takeQueueWait())
+                              + " service " + LatencyHistogram::format(stage.takeService())
+                              + " blocked " + LatencyHistogram::format(stage.takeBlocked()));
+}
+void DataProcess::logAckStats(AckTracker& tracker){                                       //PLC 应答匹配、重发及往返时延
+    AckTracker::Stats st = tracker.stats();
+    Logger::getInstance().Log("----[DataProcess] reportStats() ack [" + tracker.name()
+                              + "] tracked:[" + std::to_string(st.tracked)
+                              + "] acked:[" + std::to_string(st.acked)
+                              + "] acked_after_retry:[" + std::to_string(st.ackedAfterRetry)
+                              + "] retransmits:[" + std::to_string(st.retransmits)
+                              + "] replayed:[" + std::to_string(st.replayed)
+                              + "] deferred:[" + std::to_string(st.deferred)
+                              + "] unacked:[" + std::to_string(st.unacked)
+                              + "] unmatched:[" + std::to_string(st.unmatched)
+                              + "] inflight:[" + std::to_string(st.inflight)
+                              + "] rtt " + LatencyHistogram::format(tracker.takeRtt()));
+}
+void DataProcess::reportStats(){
+    Logger::getInstance().Log("----[DataProcess] reportStats() supply receiver recv:[" + std::to_string(m_supplyReceiver.datagramCount())
+                              + "] batches:[" + std::to_string(m_supplyReceiver.batchCount())
+                              + "] kernel_ts:[" + std::to_string(m_supplyReceiver.kernelTimestampCount()) + "]");
+    for(auto& sh : m_supplyShards){
+        uint64_t processed = sh->processed.load(std::memory_order_relaxed);
+        uint64_t sumUs = sh->latencySumUs.load(std::memory_order_relaxed);
+        uint64_t maxUs = sh->latencyMaxUs.exchange(0, std::memory_order_relaxed);          //最大值按统计周期重置
+        Logger::getInstance().Log("----[DataProcess] reportStats() supply shard [" + std::to_string(sh->index)
+                                  + "] recv:[" + std::to_string(sh->received.load(std::memory_order_relaxed))
+                                  + "] processed:[" + std::to_string(processed)
+                                  + "] drops:[" + std::to_string(sh->drops.load(std::memory_order_relaxed))
+                                  + "] backlog:[" + std::to_string(sh->ring.size_approx())
+                                  + "] avg_us:[" + std::to_string(processed ? sumUs / processed : 0)
+                                  + "] max_us:[" + std::to_string(maxUs)
+                                  + "] dup_suppressed:[" + std::to_string(sh->dedup ? sh->dedup->suppressed() : 0)
+                                  + "] dup_live:[" + std::to_string(sh->dedup ? sh->dedup->live() : 0)
+                                  + "] exceptions:[" + std::to_string(sh->exceptions.load(std::memory_order_relaxed)) + "]");
+        logRingWake("supply shard " + std::to_string(sh->index), sh->ring);
+        logSpill("supply shard " + std::to_string(sh->index), sh->spill, sh->drops.load(std::memory_order_relaxed));
+    }
+    logRingWake("unload", unloadRing);
+    logSpill("unload", unloadSpill, unloadRingDrops.load(std::memory_order_relaxed));
+    logRingWake("slot status", slotStatusRing);
+    logSpill("slot status", slotStatusSpill, slotStatusRingDrops.load(std::memory_order_relaxed));
+    for(size_t i = 0; i < m_plcEngine.connectionCount(); ++i){                               //PLC 连接状态及收发计数
+        PlcIoEngine::ConnStats cs = m_plcEngine.stats(static_cast<int>(i));
+        const PlcFrameDecoder* dec = plcDecoder(static_cast<int>(i));
+        Logger::getInstance().Log("----[DataProcess] reportStats() plc [" + cs.name
+                                  + "] state:[" + PlcIoEngine::stateName(cs.state)
+                                  + "] bytes_in:[" + std::to_string(cs.bytesIn)
+                                  + "] frames_in:[" + std::to_string(cs.framesIn)
+                                  + "] bytes_out:[" + std::to_string(cs.bytesOut)
+                                  + "] frames_out:[" + std::to_string(cs.framesOut)
+                                  + "] connects:[" + std::to_string(cs.connects)
+                                  + "] connect_failures:[" + std::to_string(cs.connectFailures)
+                                  + "] disconnects:[" + std::to_string(cs.disconnects)
+                                  + "] reconnects:[" + std::to_string(cs.reconnects)
+                                  + "] uptime_s:[" + std::to_string(cs.uptimeMs / 1000)
+                                  + "] heartbeats:[" + std::to_string(cs.heartbeatsSent)
+                                  + "] heartbeat_timeouts:[" + std::to_string(cs.heartbeatTimeouts)
+                                  + "] send_drops:[" + std::to_string(cs.sendDrops)
+                                  + "] unsent_drops:[" + std::to_string(cs.unsentDrops)
+                                  + "] carried_over:[" + std::to_string(cs.carriedOver)
+                                  + "] pending_bytes:[" + std::to_string(cs.pendingBytes)
+                                  + "] queued:[" + std::to_string(cs.queuedFrames)
+                                  + "] queue_overflows:[" + std::to_string(cs.queueOverflows)
+                                  + "] flushes:[" + std::to_string(cs.flushes)
+                                  + "] decoded:[" + std::to_string(dec ? dec->frames() : 0)
+                                  + "] reassembled:[" + std::to_string(dec ? dec->reassembled() : 0)
+                                  + "] oversized:[" + std::to_string(dec ? dec->oversized() : 0)
+                                  + "] repeats:[" + std::to_string(dec ? dec->repeats() : 0)
+                                  + "] enqueue_to_wire " + LatencyHistogram::format(m_plcEngine.takeWireLatency(static_cast<int>(i)))
+                                  + " heartbeat_rtt " + LatencyHistogram::format(m_plcEngine.takeHeartbeatRtt(static_cast<int>(i))));
+    }
+    logAckStats(m_supplyAck);
+    logAckStats(m_slotAck);
+    Logger::getInstance().Log("----[DataProcess] reportStats() unload ack sent:[" + std::to_string(m_unloadAcks.load(std::memory_order_relaxed))
+                              + "] dropped:[" + std::to_string(m_unloadAckDrops.load(std::memory_order_relaxed))
+                              + "] plc_retransmits:[" + std::to_string(m_unloadDecoder.repeats())
+                              + "] recv_to_wire " + LatencyHistogram::format(m_plcEngine.takeOriginLatency(m_connUnload)));
+    logStage(m_routeStage);
+    logStage(m_persistStage);
+    logStage(m_reportStage);
+    logStage(m_expiryStage);
+    for(int i = 0; i < m_parcelState.shardCount(); ++i){                                    //各分片在线体上的包裹数及操作排队情况
+        ParcelStateService::ShardStats ps = m_parcelState.shardStats(i);
+        Logger::getInstance().Log("----[DataProcess] reportStats() parcel state shard [" + std::to_string(i)
+                                  + "] ops:[" + std::to_string(ps.ops)
+                                  + "] queued:[" + std::to_string(ps.queued)
+                                  + "] queue_full:[" + std::to_string(ps.queueFull)
+                                  + "] parcels:[" + std::to_string(ps.parcels)
+                                  + "] pending_slot:[" + std::to_string(ps.pendingSlots)
+                                  + "] assigned:[" + std::to_string(ps.assigned)
+                                  + "] reused:[" + std::to_string(ps.reused)
+                                  + "] expired:[" + std::to_string(ps.expired)
+                                  + "] expiry_deferred:[" + std::to_string(ps.expiryDeferred) + "]");
+    }
+    size_t parcelsLive = 0;
+    for(int i = 0; i < m_parcelState.shardCount(); ++i) parcelsLive += m_parcelState.shardStats(i).parcels;
+    char expiredRate[32];
+    std::snprintf(expiredRate, sizeof(expiredRate), "%.1f", m_parcelState.takeExpiredPerMinute());
+    Logger::getInstance().Log("----[DataProcess] reportStats() parcel state live:[" + std::to_string(parcelsLive)
+                              + "] expired:[" + std::to_string(m_parcelState.expired())
+                              + "] expired_per_min:[" + expiredRate
+                              + "] dropped:[" + std::to_string(m_parcelState.dropped())
+                              + "] round_trip " + LatencyHistogram::format(m_parcelState.takeRoundTrip()));
+    Logger::getInstance().Log("----[DataProcess] reportStats() slot scheduler depth:[" + std::to_string(m_slotScheduler.depth())
+                              + "] max_batch:[" + std::to_string(m_slotScheduler.maxDepth())
+                              + "] reordered:[" + std::to_string(m_slotScheduler.reordered())
+                              + "] discarded:[" + std::to_string(m_slotScheduler.discarded()) + "]");
+    for(int i = 0; i < kStationCount; ++i){                                                 //读码到STD/GK下发的延时及GK迟到数, 无数据的供包台不输出
+        if(m_scanToStdHist[i].count() == 0 && m_scanToGkHist[i].count() == 0) continue;
+        GkWireCounters& gk = m_gkWire[i];
+        Logger::getInstance().Log("----[DataProcess] reportStats() station [" + std::to_string(i + 1)
+                                  + "] scan_to_std " + LatencyHistogram::format(m_scanToStdHist[i].takeSummary())
+                                  + " scan_to_gk " + LatencyHistogram::format(m_scanToGkHist[i].takeSummary())
+                                  + " gk_sent:[" + std::to_string(gk.sent.load(std::memory_order_relaxed))
+                                  + "] gk_late:[" + std::to_string(gk.late.load(std::memory_order_relaxed))
+                                  + "] gk_max_late_us:[" + std::to_string(gk.maxLateUs.exchange(0, std::memory_order_relaxed)) + "]");
+    }
 }
 void DataProcess::dataProInit()                             //点击运行按钮
 {
-
-    // connect(&m_plc_sendSlotClient, &SocketClient::dataReceived, this, &DataProcess::onPLCSendSlotRecv);
-
     m_deviceRunning.store(true);
-    isRecvAndSend.store(true);
+    startPipeline();
     tcpConnect();
     startUnloadWorker();                        //接收下件信息线程
     startSlotStatusWorker();                    //接收格口状态线程
 
 }
+bool DataProcess::pushPlcFrame(SpscRing<plcFrame>& ring, SpillQueue& spill, std::string_view frame, int64_t rxNs, bool repeated){     //引擎线程写入一帧, ring满时写溢出文件, 都失败返回false
+    if(!spill.active()){                                                                //溢出文件有积压时继续写文件, 保证顺序
+        plcFrame* slot = nullptr;
+        if(ring.try_reserve_bulk(&slot, 1) == 1){
+            slot->rxNs = rxNs;
+            slot->len = static_cast<uint16_t>(frame.size());                            //解码器保证不超过 kMaxFrame
+            slot->repeated = repeated;
+            std::memcpy(slot->data, frame.data(), frame.size());
+            ring.commit(1);
+            return true;
+        }
+    }
+    char head[kPlcSpillHead];                                                          //与ring槽位一样保留接收时间和重发标记
+    std::memcpy(head, &rxNs, sizeof(rxNs));
+    head[sizeof(rxNs)] = repeated ? 1 : 0;
+    if(!spill.append(frame.data(), static_cast<uint32_t>(frame.size()), head, kPlcSpillHead)) return false;
+    ring.wake();
+    return true;
+}
+bool DataProcess::readPlcSpill(const char* p, uint32_t len, std::string_view& frame, int64_t& rxNs, bool& repeated){     //拆开溢出文件记录 [接收时间][是否重发][报文]
+    if(len < kPlcSpillHead) return false;
+    std::memcpy(&rxNs, p, sizeof(rxNs));
+    repeated = p[sizeof(rxNs)] != 0;
+    frame = std::string_view(p + kPlcSpillHead, len - kPlcSpillHead);
+    return true;
+}
 void DataProcess::startUnloadWorker(){
     unloadWorkerRunning = true;
     unloadWorkerThread = std::thread([this](){
         const size_t BATCH = 256;
-        receiveRaw batch[BATCH];
+        auto handle = [this](plcFrame& f){ onPLCUnLoadRecv(f.view(), f.rxNs, f.repeated); };        //在槽位上直接处理
         while(unloadWorkerRunning){
-            size_t n = unloadRing.pop_bulk(batch,BATCH);
-            if(n==0){
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
-                continue;
+            if(!unloadSpill.active()){
+                unloadRing.wait_consume(handle, BATCH, unloadWorkerRunning);
             }
-            for(size_t i = 0; i<n; ++i){
-                const QByteArray& data = batch[i].data;
-                onPLCUnLoadRecv(data);
+            else if(unloadRing.consume(handle, BATCH) == 0){                                            //ring已空, 按顺序读回溢出文件
+                unloadSpill.drain([this](const char* p, uint32_t len){
+                    std::string_view frame; int64_t rxNs = 0; bool repeated = false;
+                    if(readPlcSpill(p, len, frame, rxNs, repeated)) onPLCUnLoadRecv(frame, rxNs, repeated);
+                }, BATCH);
             }
         }
     });
 }
 void DataProcess::stopUnloadWorker(){
     unloadWorkerRunning = false;
+    unloadRing.wake();
     if(unloadWorkerThread.joinable()) unloadWorkerThread.join();
 }
 void DataProcess::startSlotStatusWorker(){
     slotStatusWorkerRunning = true;
     slotStatusWorkerThread = std::thread([this](){
         const size_t BATCH = 256;
-        receiveRaw batch[BATCH];
+        auto handle = [this](plcFrame& f){ onPLCSlotStatusRecv(f.view()); };
         while (slotStatusWorkerRunning) {
-            size_t n = slotStatusRing.pop_bulk(batch,BATCH);
-            if(n==0){
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
-                continue;
+            if(!slotStatusSpill.active()){
+                slotStatusRing.wait_consume(handle, BATCH, slotStatusWorkerRunning);
             }
-            for(size_t i = 0; i<n;++i){
-                const QByteArray& data = batch[i].data;
-                onPLCSlotStatusRecv(data);
+            else if(slotStatusRing.consume(handle, BATCH) == 0){
+                slotStatusSpill.drain([this](const char* p, uint32_t len){
+                    std::string_view frame; int64_t rxNs = 0; bool repeated = false;
+                    if(readPlcSpill(p, len, frame, rxNs, repeated)) onPLCSlotStatusRecv(frame);
+                }, BATCH);
             }
         }
     });
 }
 void DataProcess::stopSlotStatusWorker(){
     slotStatusWorkerRunning = false;
+    slotStatusRing.wake();
     if(slotStatusWorkerThread.joinable()) slotStatusWorkerThread.join();
 }
 void DataProcess::dataProCleanUp()                      //清理所有资源
 {
     try {
+        stopStatsThread();
         stopSupplyWorker();
         stopUnloadWorker();
         stopSlotStatusWorker();
-        _udpSupplyReceiver->stop();
+        m_supplyReceiver.stop();
         if (m_recvPdaServer) {
             m_recvPdaServer->stop();
             delete m_recvPdaServer;
             m_recvPdaServer = nullptr;
         }
         tcpDisconnect();
+        m_parcelState.stop();                                                           //落库/回传阶段已停止, 不再有状态操作
     }
     catch (...) {}
 }
-void DataProcess::tcpConnect() {                        //tcp连接
-    plcSupplyTcpConnect(false);
-    plcSendSlotTcpConnect(false);
-    plcRecvUnloadTcpConnect(false);
-    plcRecvSlotStatusTcpConnect(false);
-    startTcpCheckThread();
-
+void DataProcess::startPipeline(){
+    m_routeStage.configure(static_cast<size_t>(std::max(1, m_config.routeQueue)), m_config.routeWorkers, static_cast<size_t>(std::max(0, m_config.routeOverflow)));
+    m_persistStage.configure(static_cast<size_t>(std::max(1, m_config.persistQueue)), m_config.persistWorkers, static_cast<size_t>(std::max(0, m_config.persistOverflow)));
+    m_reportStage.configure(static_cast<size_t>(std::max(1, m_config.reportQueue)), m_config.reportWorkers, static_cast<size_t>(std::max(0, m_config.reportOverflow)));
+    m_routeStage.start([this](PersistJob& job){ routeParcel(job); });
+    m_persistStage.start([this](PersistJob& job){ persistParcel(job); });
+    m_reportStage.start([this](UnloadReport& job){ reportUnload(job); });
+    m_expiryStage.start([this](ParcelStateService::ExpiredParcel& parcel){ recordExpiredParcel(parcel); });
+}
+void DataProcess::stopPipeline(){
+    m_routeStage.stop();                                                                //路由阶段会向落库阶段投递, 先停
+    m_persistStage.stop();
+    m_reportStage.stop();
+    m_expiryStage.stop();
+}
+void DataProcess::tcpConnect() {                        //tcp连接, 由引擎负责连接和断线重连
+    if(!m_plcEngine.start()){
+        Logger::getInstance().Log("----[DataProcess] tcpConnect() failed to start plc io engine");
+    }
+    m_slotScheduler.start();
 }
 void DataProcess::tcpDisconnect() {                     //tcp断开连接,即点击了停止按钮
     try {
         stopUnloadWorker();
         stopSlotStatusWorker();
         m_deviceRunning.store(false);
-        stopTcpCheckThread();
-        m_plc_supplyClient.disconnect();
-        m_plc_sendSlotClient.disconnect();
-        m_plc_unloadClient.disconnect();
-        m_plc_slotStatusClient.disconnect();
+        stopPipeline();                                                                 //处理完已入队的落库/回传任务, 其中的 GK 仍可下发
+        m_slotScheduler.stop();
+        m_plcEngine.stop();
+        m_supplyAck.clear();
+        m_slotAck.clear();
     }
     catch (...) {}
 
 }
-void DataProcess::startTcpCheckThread() {               //开启tcp连接的检查线程
-    try {
-        if (m_tcpChecking.load()) return;
-        m_tcpChecking.store(true);
-        m_tcpCheckThread = std::thread(&DataProcess::checkTcpConn, this);
-    }
-    catch (...) {}
+void DataProcess::onPLCSupplyRecv(const QByteArray& data) {											//plc中的供包信息返回, 用于判断是否已经上传成功, AKD01ID000100000#AKD02ID000100000#
+    std::string dataStr = data.toStdString();
+    Logger::getInstance().Log("----[DataProcess] onPLCSupplyRecv() recv data: [" + dataStr + "]");
+
 }
-void DataProcess::checkTcpConn() {                      //检查tcp连接
-    while (m_tcpChecking.load()) {
-        try {
-            plcSupplyTcpConnect(true);
-            plcSendSlotTcpConnect(true);
-            plcRecvUnloadTcpConnect(true);
-            plcRecvSlotStatusTcpConnect(true);
+void DataProcess::onPLCSendSlotRecv(const QByteArray& data) {                                       //plc中的单号格口信息返回
+    std::string dataStr = data.toStdString();
+    Logger::getInstance().Log("----[DataProcess] onPLCSendSlotRecv() recv data: [" + dataStr + "]");
+}
+const PlcFrameDecoder* DataProcess::plcDecoder(int conn) const{
+    if(conn == m_connSupply) return &m_supplyDecoder;
+    if(conn == m_connSendSlot) return &m_sendSlotDecoder;
+    if(conn == m_connUnload) return &m_unloadDecoder;
+    if(conn == m_connSlotStatus) return &m_slotStatusDecoder;
+    return nullptr;
+}
+void DataProcess::onPLCUnLoadRecv(std::string_view frame, int64_t rxNs, bool repeated) {                 //plc中的下件发送(一帧),SU代表正常下件, FA代表未成功并且需要删除该包裹的集包记录
+    try{
+        sendUnloadRecvToPLC(frame, rxNs);                                                                       //先逐帧回复, 再处理
+        UnloadRecord rec;
+        bool parsed = parseUnloadRecord(frame, rec);                                                            //一次遍历取出状态/供包台/序列号/格口
+        Logger::getInstance().Log("----[DataProcess] onPLCUnLoadRecv() recv frame: [" + std::string(frame) + "] kind: [" + unloadStatusName(rec.status) + "]"
+                                  + (repeated ? " retransmitted by plc" : ""));
+        if(repeated) return;                                                                                    //PLC 重发的帧只回复, 已处理过的下件不再回传
+        if(!parsed || rec.station < 1 || rec.station > 12) return;
+        if(!m_parcelState.submitUnload(rec)){                                                                   //交给该供包台所在的状态分片取出记录, 不等待
+            Logger::getInstance().Log("----[DataProcess] onPLCUnLoadRecv() parcel state stopped, drop frame: [" + std::string(frame) + "]");
         }
-        catch (...) {}
-        std::this_thread::sleep_for(std::chrono::milliseconds(5000));            //三秒检查一次
     }
+    catch(...){}
 }
-void DataProcess::stopTcpCheckThread() {                //停止检查线程
-    try {
-        if (!m_tcpChecking.load()) return;
-        m_tcpChecking.store(false);
-        if (m_tcpCheckThread.joinable()) {
-            m_tcpCheckThread.join();
-        }
+void DataProcess::onParcelUnloaded(const UnloadRecord& rec, const ParcelStateService::UnloadLookup& parcel){   //包裹状态分片线程回调, 记录已取出并清除, 只入回传队列不阻塞
+    if(!m_reportStage.post(UnloadReport{rec, parcel})){                                                      //队列满时排入溢出区, 下一帧的回复不受数据库/接口影响
+        Logger::getInstance().Log("----[DataProcess] onParcelUnloaded() report stage stopped or overflow full, drop unload: [D" + std::to_string(rec.station) + "ID" + std::to_string(rec.order) + "]");
     }
-    catch (...) {}
 }
-bool DataProcess::plcSupplyTcpConnect(bool destorySock) {
-    try {
-        if (m_plcSupplyMutex.try_lock()) {				//避免死锁
-            if (!m_plc_supplyClient.connectStatus("0000000000000000")) {
-                if (destorySock) {
-                    Logger::getInstance().Log("----[DataProcess] plcSupplyTcpConnect() Start reconnect to supply port...");
-                    m_plc_supplyClient.disconnect();
-                    Sleep(200);
+void DataProcess::reportUnload(const UnloadReport& job){                                            //回传阶段: 用分片取出的单号、重量和格口(内存中没有的字段查数据库), 调用出仓扫描/建包/小件回传接口
+    const UnloadRecord& rec = job.rec;
+    if(!rec.hasKey()) return;
+    int supply_id = rec.station;                                                                    //供包台号
+    std::string supply_mac = m_supplyMacVector[supply_id - 1];
+    const ParcelStateService::UnloadLookup& parcel = job.parcel;
+    const WaybillCode& code = parcel.code;
+    if(parcel.found)
+    {
+        std::string weight = "0.5";                                                                 //初始化重量
+        int slot_id = parcel.slot;                                                                  //获取格口号
+        if(parcel.weightGrams >= 0){                                                                //读码时的重量, 与写入数据库的相同
+            char weightBuf[24];
+            weight = formatWeightKg(parcel.weightGrams, weightBuf);
+        }
+        if(parcel.weightGrams < 0 || !parcel.hasSlot){                                              //内存中缺少的字段才查数据库
+            auto _sql = SqlConnectionPool::instance().acquire();
+            const std::string codeStr = code.str();
+            if(_sql && parcel.weightGrams < 0){
+                auto db_weight = _sql->queryString("supply_data","code",codeStr,"weight");
+                if(db_weight)
+                {
+                    weight = *db_weight;
                 }
-                SOCKET ok = m_plc_supplyClient.connectTo(m_plc_ip, m_plc_supply,false);                     //不开启接收线程
-                if (ok == INVALID_SOCKET) {
-                    Logger::getInstance().Log("----[DataProcess] plcSupplyTcpConnect() Connect to supply port failed!");
-                    m_plcSupplyMutex.unlock();
-                    return false;
+            }
+            if(_sql && !parcel.hasSlot){
+                auto db_slot_id = _sql->queryString("supply_data","code",codeStr,"slot_id");
+                if(db_slot_id){
+                    slot_id = std::stoi(*db_slot_id);
                 }
-                Logger::getInstance().Log("----[DataProcess] plcSupplyTcpConnect() Connect to supply port successfully!");
             }
         }
-        m_plcSupplyMutex.unlock();
-        return true;
+        if(m_operateType == 1)                                                                      //进港,不需要集包，只需要出仓扫描
+        {
+            auto it = m_slotTodeliveryCodeMap.find(slot_id);
+            if(it!=m_slotTodeliveryCodeMap.end()){
+                const std::string& deliveryCode = it->second;
+                QMetaObject::invokeMethod(&m_requestAPI,                                                    //出仓扫描
+                                          "outboundScanning",
+                                          Qt::QueuedConnection,
+                                          Q_ARG(WaybillCode, code), Q_ARG(QString, QString::fromStdString(deliveryCode)));
+            }
+        }
+        else if(m_operateType == 2){                                                                        //出港，需要集包
+            auto _it = m_slotToPackage.find(slot_id);
+            if(_it!=m_slotToPackage.end()){
+                const std::string& packageNum = _it->second;                                                //获取包牌号
+                QMetaObject::invokeMethod(&m_requestAPI,                                                    //建包
+                                          "requestBuildOneByOne",
+                                          Qt::QueuedConnection,
+                                          Q_ARG(WaybillCode, code), Q_ARG(QString, QString::fromStdString(packageNum)));
+            }
+        }
+        QMetaObject::invokeMethod(&m_requestAPI,                                                    //小件回传，进出港都需要
+                                  "requestSmallData",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(WaybillCode,code),
+                                  Q_ARG(QString,QString::fromStdString(weight)),
+                                  Q_ARG(int,m_operateType),
+                                  Q_ARG(int, slot_id),
+                                  Q_ARG(int, supply_id),
+                                  Q_ARG(QString,QString::fromStdString(supply_mac)));
     }
-    catch (...) {}
-    return false;
 }
-bool DataProcess::plcSendSlotTcpConnect(bool destorySock) {
+void DataProcess::onPLCSlotStatusRecv(std::string_view frame) {                                     //plc中的格口状态返回(一帧), 把格口号对应的包号置为空
+    try{
+        std::string dataStr(frame);
+        Logger::getInstance().Log("----[DataProcess] onPLCSlotStatusRecv() recv frame: [" + dataStr + "]");
+    }
+    catch(...){}
+}
+void DataProcess::ingestSupplyMessage(SupplyShard& shard, std::string_view message, int64_t rxNs) {           //解析读码消息并做重复抑制, 通过后交给onSupplyUDPServerRecv
     try {
-        if (m_plcSendSlotMutex.try_lock())		//避免死锁
-        {
-            if (!m_plc_sendSlotClient.connectStatus("0000000000000000")) {
-                if (destorySock) {
-                    Logger::getInstance().Log("----[DataProcess] plcSendSlotTcpConnect() Start reconnect to send slot port...");
-                    m_plc_sendSlotClient.disconnect();
-                    Sleep(200);
-                }
-                SOCKET ok = m_plc_sendSlotClient.connectTo(m_plc_ip, m_plc_sendSlot,false);                     //不开启接收线程
-                if (ok == INVALID_SOCKET) {
-                    Logger::getInstance().Log("----[DataProcess] plcSendSlotTcpConnect() Connect to send slot port failed!");
-                    m_plcSendSlotMutex.unlock();
-                    return false;
-                }
-                Logger::getInstance().Log("----[DataProcess] plcSendSlotTcpConnect() Connect to send slot port successfully!");
-            }
+        Logger::getInstance().Log("----[DataProcess] ingestSupplyMessage() message: [" + std::string(message) + "]");
+        if(!m_deviceRunning.load()) return;                                                     //设备停止状态
+        ScanRecord scan;
+        ScanParseError err = parseScanMessage(message, scan);
+        if (err == ScanParseError::Empty || err == ScanParseError::MissingField || err == ScanParseError::BadStation) {    //无法确定供包台, 丢弃
+            Logger::getInstance().Log("----[DataProcess] ingestSupplyMessage() parse failed: [" + std::string(scanParseErrorName(err)) + "]");
+            return;
+        }
+        if (scan.stationId <= 0 || scan.stationId > 12) {
+            return;
         }
-        m_plcSendSlotMutex.unlock();
-        return true;
+        WaybillCode code;
+        bool codeOk = err != ScanParseError::EmptyCode && err != ScanParseError::CodeTooLong && WaybillCode::parse(scan.codeView(), code);
+        if (!codeOk || err == ScanParseError::BadWeight) {                                     //包裹已在供包台上: 未读出/单号非法/重量非法都照常上件, 分到异常格
+            const char* reason = (!codeOk && err == ScanParseError::Ok) ? "invalid waybill" : scanParseErrorName(err);
+            Logger::getInstance().Log("----[DataProcess] ingestSupplyMessage() exception parcel: [" + std::string(reason)
+                                      + "] station: [" + std::to_string(scan.stationId) + "]");
+            shard.exceptions.fetch_add(1, std::memory_order_relaxed);
+            inductExceptionParcel(scan, code, rxNs);
+            return;
+        }
+        int64_t nowMs = steadyNowUs() / 1000;
+        if (shard.dedup && shard.dedup->isDuplicate(code.view(), scan.stationId, nowMs)) {     //窗口内重复读码, 丢弃
+            Logger::getInstance().Log("----[DataProcess] ingestSupplyMessage() suppress duplicate scan: [" + code.str() + "]");
+            return;
+        }
+        onSupplyUDPServerRecv(scan, code, rxNs);
     }
     catch (...) {}
-    return false;
 }
-bool DataProcess::plcRecvUnloadTcpConnect(bool destorySock) {
+void DataProcess::onSupplyUDPServerRecv(const ScanRecord& scan, const WaybillCode& code, int64_t rxNs) {							//接收供包台消息, 发送给PLC, 并写入数据库, 判断是否有请求格口, 若没有进行格口请求.(同时需要判断进出港件)
     try {
-        if (!m_plc_unloadClient.connectStatus("0000000000000000")) {
-            if (destorySock) {
-                Logger::getInstance().Log("----[DataProcess] plcRecvUnloadTcpConnect() Start reconnect to recv unload port...");
-                m_plc_unloadClient.disconnect();
-                Sleep(200);
-            }
-            SOCKET ok = m_plc_unloadClient.connectTo(m_plc_ip, m_plc_unload);
-            if (ok == INVALID_SOCKET) {
-                Logger::getInstance().Log("----[DataProcess] plcRecvUnloadTcpConnect() Connect to recv unload port failed!");
-                return false;
-            }
-            Logger::getInstance().Log("----[DataProcess] plcRecvUnloadTcpConnect() Connect to recv unload port successfully!");
+        int supply_id = scan.stationId;
+        char weightBuf[24];
+        std::string weight(formatWeightKg(scan.weightGrams, weightBuf));
+        int supply_order = updateSupplyOrder(supply_id);
+        m_parcelState.record(code, supply_id, supply_order, scan.weightGrams, rxNs);                       //序列号对应单号, 单号对应序列号、重量及读码时间, 只入分片队列
+        sendSupplyDataToPLC(supply_id,supply_order,rxNs);                                                   //STD 只入发送队列, 不等待数据库; 读码到写出的延时在引擎写出时记录
+        PersistJob job;
+        job.kind = PersistJob::Supply;
+        job.code = code;
+        job.weight = std::move(weight);
+        job.supplyId = supply_id;
+        job.supplyOrder = supply_order;
+        if(!m_routeStage.post(std::move(job))){                                                             //不等待路由阶段, 队列满时排入溢出区, 下一条读码的 STD 不受数据库影响
+            Logger::getInstance().Log("----[DataProcess] onSupplyUDPServerRecv() route stage stopped or overflow full, drop supply: [D" + std::to_string(supply_id) + "ID" + std::to_string(supply_order) + "]");
         }
-        return true;
     }
     catch (...) {}
-    return false;
 }
-bool DataProcess::plcRecvSlotStatusTcpConnect(bool destorySock) {
+void DataProcess::inductExceptionParcel(const ScanRecord& scan, const WaybillCode& code, int64_t rxNs){       //异常件: 与正常件一样发 STD, 不请求段码, 直接下发异常格; 单号有效时仍记录在线体上, 供下件回传
     try {
-        if (!m_plc_slotStatusClient.connectStatus("0000000000000000")) {
-            if (destorySock) {
-                Logger::getInstance().Log("----[DataProcess] plcRecvSlotStatusTcpConnect() Start reconnect to recv slot status port...");
-                m_plc_slotStatusClient.disconnect();
-                Sleep(200);
-            }
-            SOCKET ok = m_plc_slotStatusClient.connectTo(m_plc_ip, m_plc_slotStatus);
-            if (ok == INVALID_SOCKET) {
-                Logger::getInstance().Log("----[DataProcess] plcRecvSlotStatusTcpConnect() Connect to recv slot status port failed!");
-                return false;
-            }
-            Logger::getInstance().Log("----[DataProcess] plcRecvSlotStatusTcpConnect() Connect to recv slot status port successfully!");
+        int supply_id = scan.stationId;
+        int supply_order = updateSupplyOrder(supply_id);
+        int slot_id = m_operateType == 1 ? m_arrivalExceptionSlot : m_departureExceptionSlot;
+        if(!code.empty()) m_parcelState.record(code, supply_id, supply_order, kDefaultWeightGrams, rxNs);
+        sendSupplyDataToPLC(supply_id,supply_order,rxNs);
+        if(slot_id <= 0){                                                                               //没有异常格, 不下发 G0
+            Logger::getInstance().Log("----[DataProcess] inductExceptionParcel() exception slot not configured, skip GK, supply_id: [" + std::to_string(supply_id)
+                                      + "] supply_order: [" + std::to_string(supply_order) + "] code: [" + code.str() + "]");
+            return;
+        }
+        ParcelStateService::SlotAssignment assigned;
+        if(!code.empty()) assigned = m_parcelState.assignSlot(code, slot_id, supply_id);                        //取出序列号并记录格口
+        if(!assigned.found){                                                                            //没有单号, 序列号就是本次分配的
+            assigned.found = true;
+            assigned.station = supply_id;
+            assigned.order = supply_order;
+            assigned.scan = ParcelStateService::ScanTime{ rxNs, supply_id };
         }
-        return true;
+        sendSlotToPLC(code, assigned, slot_id);
     }
     catch (...) {}
-    return false;
-}
-void DataProcess::onPLCSupplyRecv(const QByteArray& data) {											//plc中的供包信息返回, 用于判断是否已经上传成功, AKD01ID000100000#AKD02ID000100000#
-    // isRecvAndSend.store(true);
-    std::string dataStr = data.toStdString();
-    Logger::getInstance().Log("----[DataProcess] onPLCSupplyRecv() recv data: [" + dataStr + "]");
-
-}
-void DataProcess::onPLCSendSlotRecv(const QByteArray& data) {                                       //plc中的单号格口信息返回
-    std::string dataStr = data.toStdString();
-    Logger::getInstance().Log("----[DataProcess] onPLCSendSlotRecv() recv data: [" + dataStr + "]");
 }
-std::vector<std::string> extract_by_split(const std::string &s) {                                   //切割字符串GKD01ID0001G1001#GKD02ID0001G1020#SU213D04ID0001G2008
-    std::vector<std::string> results;
-    size_t start = 0;
-    while (start < s.size()) {
-        size_t hash = s.find('#', start);
-        if (hash == std::string::npos) hash = s.size();
-        if (hash > start) {
-            std::string seg = s.substr(start, hash - start); // e.g. "GKD01ID0001G1001"
-            size_t posD = seg.find('D');                      // 找 D 的位置
-            if (posD != std::string::npos) {
-                // 找 D 后面的下一个 'G'（若无则取到段尾）
-                size_t posNextG = seg.find('G', posD + 1);
-                size_t len = (posNextG == std::string::npos) ? seg.size() - posD : posNextG - posD;
-                results.push_back(seg.substr(posD, len));
-            }
+void DataProcess::routeParcel(PersistJob& job){                                                    //路由阶段: 依赖数据库结果的段码请求和格口下发
+    if(job.kind == PersistJob::Supply){
+        int slot_id = insertSupplyDataToDB(job.code, job.weight, job.supplyId, job.supplyOrder);
+        requestAndSendToPLC(job.code, job.weight, slot_id, job.supplyId);
+        return;
+    }
+    if(job.kind == PersistJob::TerminalSlot && job.sendSlot){                                     //内存中没有序列号, 查数据库取序列号后下发 GK, 格口更新交给落库阶段
+        ParcelStateService::SlotAssignment assigned;
+        assigned.scan = job.scan;
+        sendSlotToPLC(job.code, assigned, job.slotId);
+        job.sendSlot = false;
+        if(!m_persistStage.post(std::move(job))){
+            Logger::getInstance().Log("----[DataProcess] routeParcel() persist stage stopped or overflow full, slot not saved, code: [" + job.code.str() + "]");
         }
-        start = hash + 1;
+        return;
     }
-    return results;
+    persistParcel(job);
 }
-void DataProcess::onPLCUnLoadRecv(const QByteArray& data) {                                             //plc中的下件发送,SU代表正常下件, FA代表未成功并且需要删除该包裹的集包记录
-    try{
-        std::string dataStr = data.toStdString();
-        Logger::getInstance().Log("----[DataProcess] onPLCUnLoadRecv() recv data: [" + dataStr + "]");
-        sendUnloadRecvToPLC(dataStr);
-        QtConcurrent::run([this,dataStr]() {                                 //异步执行
-            auto msgs = extract_by_split(dataStr);                                                              //切割字符串得到序列号
-            for(auto &msg : msgs){
-                int supply_id = -1;                                                                             //从消息中获取供包台号
-                if(msg.size()>=3 && msg[0] == 'D'){
-                    std::string num = msg.substr(1,2);
-                    supply_id = std::stoi(num);
-                }
-                if(supply_id<1||supply_id>12) return;
-                std::string supply_mac = m_supplyMacVector[supply_id - 1];
-                auto it = m_msgToCodeMap.find(msg);
-                if(it!=m_msgToCodeMap.end())
-                {
-                    const std::string& code = m_msgToCodeMap[msg];                                              //获取单号
-                    //清除队列中存储的序列号与单号的键值对
-                    auto _sql = SqlConnectionPool::instance().acquire();
-                    std::string weight = "0.5";                                                                 //初始化重量
-                    if(_sql){
-                        auto db_weight = _sql->queryString("supply_data","code",code,"weight");
-                        if(db_weight)
-                        {
-                            weight = *db_weight;
-                        }
-                    }
-
-                    // int slot_id = m_codeToSlotMap[code];                                                        //获取格口号
-                    int slot_id = -1;
-                    auto slot_id_map = m_codeToSlotMap.find(code);
-                    if(slot_id_map!=m_codeToSlotMap.end()){                                                     //存在列表中
-                        slot_id = slot_id_map->second;
-                        m_codeToSlotMap.erase(code);                                                            //清除队列中单号与格口号的键值对
-                    }
-                    else{                                                                                       //队列中不存在
-                        if(_sql){
-                            auto db_slot_id = _sql->queryString("supply_data","code",code,"slot_id");
-                            if(db_slot_id){
-                                slot_id = std::stoi(*db_slot_id);
-                            }
-                        }
-                    }
-                    if(m_operateType == 1)                                                                      //进港,不需要集包，只需要出仓扫描
-                    {
-                        auto it = m_slotTodeliveryCodeMap.find(slot_id);
-                        if(it!=m_slotTodeliveryCodeMap.end()){
-                            const std::string& deliveryCode = it->second;
-                            QMetaObject::invokeMethod(&m_requestAPI,                                                    //出仓扫描
-                                                      "outboundScanning",
-                                                      Qt::QueuedConnection,
-                                                      Q_ARG(QString, QString::fromStdString(code)), Q_ARG(QString, QString::fromStdString(deliveryCode)));
-                        }
-                    }
-                    else if(m_operateType == 2){                                                                        //出港，需要集包
-                        auto _it = m_slotToPackage.find(slot_id);
-                        if(_it!=m_slotToPackage.end()){
-                            const std::string& packageNum = _it->second;                                                //获取包牌号
-                            QMetaObject::invokeMethod(&m_requestAPI,                                                    //建包
-                                                      "requestBuildOneByOne",
-                                                      Qt::QueuedConnection,
-                                                      Q_ARG(QString, QString::fromStdString(code)), Q_ARG(QString, QString::fromStdString(packageNum)));
-                        }
-                    }
-                    QMetaObject::invokeMethod(&m_requestAPI,                                                    //小件回传，进出港都需要
-                                              "requestSmallData",
-                                              Qt::QueuedConnection,
-                                              Q_ARG(QString,QString::fromStdString(code)),
-                                              Q_ARG(QString,QString::fromStdString(weight)),
-                                              Q_ARG(int,m_operateType),
-                                              Q_ARG(int, slot_id),
-                                              Q_ARG(int, supply_id),
-                                              Q_ARG(QString,QString::fromStdString(supply_mac)));
-                    m_msgToCodeMap.erase(msg);
-                }
-            }
-        });
-                                                                                //发送回复消息
+void DataProcess::persistParcel(PersistJob& job){                                                  //落库阶段: 只写入/更新数据库, 不下发报文
+    auto _sql = SqlConnectionPool::instance().acquire();
+    if(_sql){
+        _sql->updateValue("supply_data","code",job.code.str(),"slot_id",std::to_string(job.slotId));
     }
-    catch(...){}
 }
-void DataProcess::onPLCSlotStatusRecv(const QByteArray& data) {                                     //plc中的格口状态返回, 把格口号对应的包号置为空
-    try{
-        std::string dataStr = data.toStdString();
-        Logger::getInstance().Log("----[DataProcess] onPLCSlotStatusRecv() recv data: [" + dataStr + "]");
+void DataProcess::onParcelExpired(const ParcelStateService::ExpiredParcel& parcel){               //包裹状态分片线程回调, 读码后超时仍未下件, 只入低优先级队列不阻塞
+    if(!m_expiryStage.post(parcel)){
+        Logger::getInstance().Log("----[DataProcess] onParcelExpired() expiry stage stopped or full, expired parcel not recorded, code: [" + parcel.code.str() + "]");
     }
-    catch(...){}
 }
-void DataProcess::onSupplyUDPServerRecv(const std::string& message) {							//接收供包台消息, 发送给PLC, 并写入数据库, 判断是否有请求格口, 若没有进行格口请求.(同时需要判断进出港件)
-    try {
-        Logger::getInstance().Log("----[DataProcess] onSupplyUDPServerRecv() message: [" + message + "]");
-        if(!m_deviceRunning.load()) return;                                                     //设备停止状态
-        auto [code, weight, supply_id] = splitUdpMessage(message);
-        if (supply_id <= 0 || supply_id > 12) {
-            return;
-        }
-        int supply_order = updateSupplyOrder(supply_id);
-        std::ostringstream oss;
-        oss << "D"
-            << std::setw(2) << std::setfill('0') << supply_id
-            << "ID"
-            << std::setw(4) << std::setfill('0') << supply_order;
-        std::string order_msg = oss.str();
-        m_msgToCodeMap[order_msg] = code;                                                                   //写入队列中，序列号对应单号
-        m_codeToMsgMap[code] = order_msg;                                                                   //单号对应序列号
-        QtConcurrent::run([this, code, weight, supply_id, supply_order]() {                                 //异步执行
-            sendSupplyDataToPLC(supply_id,supply_order);
-            int slot_id = insertSupplyDataToDB(code, weight, supply_id, supply_order);
-            requestAndSendToPLC(code, weight, slot_id);
-        });
+void DataProcess::recordExpiredParcel(const ParcelStateService::ExpiredParcel& parcel){           //回收阶段: 记录日志, 配置了表时写入数据库
+    char weightBuf[24];
+    std::string weight(parcel.weightGrams >= 0 ? formatWeightKg(parcel.weightGrams, weightBuf) : std::string_view("0"));
+    Logger::getInstance().Log("----[DataProcess] recordExpiredParcel() code: [" + parcel.code.str()
+                              + "] supply_id: [" + std::to_string(parcel.station)
+                              + "] supply_order: [" + std::to_string(parcel.order)
+                              + "] weight: [" + weight
+                              + "] slot_id: [" + (parcel.hasSlot ? std::to_string(parcel.slot) : std::string("none"))
+                              + "] age_s: [" + std::to_string(parcel.ageMs / 1000) + "]");
+    if(m_config.parcelExpiryTable.empty()) return;
+    auto _sql = SqlConnectionPool::instance().acquire();
+    if(!_sql){
+        Logger::getInstance().Log("----[DataProcess] recordExpiredParcel() sql pool no free connect, expired parcel not saved, code: [" + parcel.code.str() + "]");
+        return;
+    }
+    const std::vector<std::string> column = {"code", "weight", "supply_id", "supply_order", "slot_id", "age_sec", "expire_time", "operate_type"};
+    const std::vector<std::string> value = {parcel.code.str(),
+                                            weight,
+                                            std::to_string(parcel.station),
+                                            std::to_string(parcel.order),
+                                            std::to_string(parcel.hasSlot ? parcel.slot : -1),
+                                            std::to_string(parcel.ageMs / 1000),
+                                            getCurrentTime(),
+                                            std::to_string(m_operateType)};
+    if(!_sql->insertRow(m_config.parcelExpiryTable, column, value)){
+        Logger::getInstance().Log("----[DataProcess] recordExpiredParcel() insert expired parcel failed! code: [" + parcel.code.str() + "]");
     }
-    catch (...) {}
 }
-void DataProcess::requestAndSendToPLC(const std::string& code,const std::string& weight, int slot_id){            //若没请求一段码则进行请求, 若请求过则发送到plc中, 需要判断是进港还是出港
+void DataProcess::requestAndSendToPLC(const WaybillCode& code,const std::string& weight, int slot_id, int supply_id){            //若没请求一段码则进行请求, 若请求过则发送到plc中, 需要判断是进港还是出港
     try{
         if(m_operateType == 1){                                                 //进港
             if(slot_id<=0){                                                     //格口未请求
                 QMetaObject::invokeMethod(&m_requestAPI,
                                           "requestTerminalCode",                //一段码
                                           Qt::QueuedConnection,
-                                          Q_ARG(QString, QString::fromStdString(code))
+                                          Q_ARG(WaybillCode, code)
                                           );
             }else{                                                               //已请求, 发送至plc
-                m_codeToSlotMap[code] = slot_id;                                    //写入队列
-
-                auto it = m_codeToMsgMap.find(code);
-                if(it!=m_codeToMsgMap.end()){
-                    const std::string& order_msg = it->second;
-                    sendSlotToPLC(code,order_msg,slot_id);
-                    m_codeToMsgMap.erase(code);
-                }else{
-                    sendSlotToPLC(code,"",slot_id);
-                }
+                sendSlotToPLC(code,m_parcelState.assignSlot(code,slot_id,supply_id),slot_id);             //写入队列, 取出序列号发送
             }
             QMetaObject::invokeMethod(&m_requestAPI,
                                       "unloadToPieces",                     //卸车到件
                                       Qt::QueuedConnection,
-                                      Q_ARG(QString, QString::fromStdString(code)),
+                                      Q_ARG(WaybillCode, code),
                                       Q_ARG(QString, QString::fromStdString(weight))
                                       );
         }else if(m_operateType == 2){                                           //出港
             QMetaObject::invokeMethod(&m_requestAPI,
                                       "requestUploadData",                  //四合一
                                       Qt::QueuedConnection,
-                                      Q_ARG(QString, QString::fromStdString(code)), Q_ARG(QString, QString::fromStdString(weight))
+                                      Q_ARG(WaybillCode, code), Q_ARG(QString, QString::fromStdString(weight))
                                       );
             if(slot_id<=0){                                                     //未请求,进行请求
                 QMetaObject::invokeMethod(&m_requestAPI,
                                           "requestTerminalCode",                //一段码
                                           Qt::QueuedConnection,
-                                          Q_ARG(QString, QString::fromStdString(code))
+                                          Q_ARG(WaybillCode, code)
                                           );
             }
             else{                                                               //已请求, 发送至plc
-                m_codeToSlotMap[code] = slot_id;                                //写入队列, 供onPLCUnLoadRecv 寻找格口号使用
-                auto it = m_codeToMsgMap.find(code);
-                if(it!=m_codeToMsgMap.end()){
-                    const std::string& order_msg = it->second;
-                    sendSlotToPLC(code,order_msg,slot_id);
-                    m_codeToMsgMap.erase(code);
-                }else{
-                    sendSlotToPLC(code,"",slot_id);
-                }
+                sendSlotToPLC(code,m_parcelState.assignSlot(code,slot_id,supply_id),slot_id);         //写入队列, 供onPLCUnLoadRecv 寻找格口号使用
             }
         }
     }
     catch(...){}
 }
-int DataProcess::updateSupplyOrder(int supply_id){                                         //更新每个供包台对应的序列号
-    int supply_id_vector = supply_id - 1;
-    int supply_order = m_supplyIDToOrder[supply_id_vector];
-    if(supply_order==9999){
-        supply_order = 1;
-    }
-    else{
-        supply_order +=1;
-    }
-    m_supplyIDToOrder[supply_id_vector] = supply_order;
-    return supply_order;
+int DataProcess::updateSupplyOrder(int supply_id){                                         //更新每个供包台对应的序列号, 同一供包台可能被多个分片线程同时调用
+    std::atomic<int>& counter = m_supplyIDToOrder[supply_id - 1];
+    int supply_order = counter.load(std::memory_order_relaxed);
+    int next;
+    do {
+        next = supply_order >= 9999 ? 1 : supply_order + 1;                                  //9999 之后回到 1
+    } while (!counter.compare_exchange_weak(supply_order, next, std::memory_order_relaxed));
+    return next;
 }
-std::string DataProcess::takeMsgFromPLCSendSlotQueue(size_t n) {                              //从待发送格口队列中提取最多五个并删除
-    std::string msg = "";
-    try{
-        size_t _n = std::min(n, m_sendPLCSlotDataQueue.size());
-        for (size_t i = 0; i < _n; ++i) {
-            std::string message = std::move(m_sendPLCSlotDataQueue.front());
-            msg += message + "#";
-            m_sendPLCSlotDataQueue.pop_front();
-        }
-    }catch(...){}
-    return msg;
-}
-
-std::string DataProcess::takeMsgFromPLCSupplyQueue(size_t n) {                                  //从待供包队列中提取最多五个并删除
-    std::string msg = "";
-    try{
-        size_t _n = std::min(n, m_sendPLCSupplyDataQueue.size());
-        for (size_t i = 0; i < _n; ++i) {
-            std::string message = std::move(m_sendPLCSupplyDataQueue.front());
-            msg += message + "#";
-            Logger::getInstance().Log("----[test] message : ["+msg+"]");
-            m_sendPLCSupplyDataQueue.pop_front();
-        }
-        return msg;
-    }catch(...){}
-    return "0000000000000000";
-}
-int DataProcess::insertSupplyDataToDB(const std::string& code, const std::string& weight, int supply_id, int supply_order){              //上件单号插入数据库, 返回格口号
+int DataProcess::insertSupplyDataToDB(const WaybillCode& waybill, const std::string& weight, int supply_id, int supply_order){              //上件单号插入数据库, 返回格口号
     int slot_id = -1;
     std::string now_time = getCurrentTime();
+    const std::string code = waybill.str();                                                             //数据库接口按 std::string 传参, 只转换一次
     try{
         auto _mysql = SqlConnectionPool::instance().acquire();
         if(!_mysql){
@@ -634,12 +986,12 @@ int DataProcess::insertSupplyDataToDB(const std::string& code, const std::string
     }catch(...){}
     return slot_id;
 }
-void DataProcess::onTerminalCodeRecv(const QString& code, const std::string& terminalCode, int order_type, int interceptor){             //接收到格口信息,发送给plc， 同时写入数据库
+void DataProcess::onTerminalCodeRecv(const WaybillCode& code, const std::string& terminalCode, int order_type, int interceptor){             //接收到格口信息,发送给plc， 同时写入数据库
     try{
-        std::string code_copy = code.toStdString();
+        if(code.empty()) return;
         int slot_id = -1;
         Logger::getInstance().Log("----[DataProcess] onTerminalCodeRecv() operate type:["+std::to_string(m_operateType)
-                                  +"],code,["+code_copy
+                                  +"],code,["+code.str()
                                   +"],terminal_code:["+terminalCode
                                   +"],order_type:["+std::to_string(order_type)+"]");
         if(interceptor == 2)                                                            //不是拦截件，是否拦截件，1-是 2-否
@@ -682,146 +1034,133 @@ void DataProcess::onTerminalCodeRecv(const QString& code, const std::string& ter
             if(m_operateType == 1) slot_id = arrival_terminalCodeToSlotMap["拦截件"];
             else slot_id = depature_terminalCodeToSlotMap["拦截件"];
         }
-        m_codeToSlotMap[code_copy] = slot_id;                                               //写入队列，单号对应的格口号
-        auto _it = m_codeToMsgMap.find(code_copy);
-        if(_it!=m_codeToMsgMap.end()){
-            const std::string& order_msg = _it->second;
-            sendSlotToPLC(code_copy, order_msg, slot_id);
-            m_codeToMsgMap.erase(code_copy);                                                //清除队列中存储的单号与序列号键值对
+        PersistJob job;
+        job.kind = PersistJob::TerminalSlot;
+        job.slotId = slot_id;
+        ParcelStateService::SlotAssignment assigned = m_parcelState.assignSlot(code, slot_id);    //记录单号对应的格口号, 并取出单号对应的序列号
+        if(assigned.found){
+            sendSlotToPLC(code, assigned, slot_id);                                    //序列号在内存中, 直接入调度队列
         }
         else{
-            sendSlotToPLC(code_copy,"",slot_id);
+            job.sendSlot = true;                                                            //需要查数据库取序列号, 交给落库阶段, 不阻塞主线程
+            job.scan = assigned.scan;
         }
-        QtConcurrent::run([this, code_copy,slot_id]() {                                     //异步执行,写入数据库
-            auto _sql = SqlConnectionPool::instance().acquire();
-            if(_sql){
-                _sql->updateValue("supply_data","code",code_copy,"slot_id",std::to_string(slot_id));
-            }
-        });
-    }catch(...){}
-}
-void DataProcess::sendUnloadRecvToPLC(const std::string& data){
-    try{
-        if(m_plcUnloadMutex.try_lock()){
-            m_plc_unloadClient.sendData(data);
-            m_plcUnloadMutex.unlock();
-            Logger::getInstance().Log("----[DataProcess] sendUnloadRecvToPLC() send message: ["+data+"]");
+        job.code = code;
+        PipelineStage<PersistJob>& stage = job.sendSlot ? m_routeStage : m_persistStage;     //要下发 GK 的走路由阶段, 只写库的走落库阶段
+        if(!stage.post(std::move(job))){                                                    //主线程不等待
+            Logger::getInstance().Log("----[DataProcess] onTerminalCodeRecv() " + stage.name() + " stage stopped or overflow full, slot not saved, code: [" + code.str() + "]");
         }
     }catch(...){}
 }
-void DataProcess::sendSupplyDataToPLC(int supply_id, int supply_order) {                            //STD+供包台+ID+供包台序列号+00000
+void DataProcess::sendUnloadRecvToPLC(std::string_view frame, int64_t rxNs){                       //原帧加'#'回复, 在下件线程写入发送队列(无锁), 队列满时进溢出缓冲区, 断线时保留到重连
+    char buf[PlcFrameDecoder::kMaxFrame + 1];
+    size_t len = std::min(frame.size(), PlcFrameDecoder::kMaxFrame);
+    std::memcpy(buf, frame.data(), len);
+    buf[len++] = '#';
+    if(m_plcEngine.send(m_connUnload, std::string_view(buf, len), rxNs, 0, frameExpireNs(rxNs))){
+        m_unloadAcks.fetch_add(1, std::memory_order_relaxed);
+    }
+    else{
+        m_unloadAckDrops.fetch_add(1, std::memory_order_relaxed);
+        Logger::getInstance().Log("----[DataProcess] sendUnloadRecvToPLC() plc send buffer full or engine stopped, drop message: [" + std::string(buf, len) + "]");
+    }
+}
+void DataProcess::sendSupplyDataToPLC(int supply_id, int supply_order, int64_t rxNs) {              //STD+供包台+ID+供包台序列号+00000
     try{
         int supply_id_copy = supply_id;
         int supply_order_copy = supply_order;
         if (supply_id_copy > 99) { supply_id_copy %= 100; }
         if (supply_order_copy > 9999) { supply_order_copy %= 100; }
-        std::string supply_idStr = std::to_string(supply_id);
-        std::string supply_orderStr = std::to_string(supply_order);
-        std::string send_msg = "";
-        std::ostringstream oss;
-        oss << "STD"
-            << std::setw(2) << std::setfill('0') << supply_id_copy
-            << "ID"
-            << std::setw(4) << std::setfill('0') << supply_order_copy
-            << "00000";
-        std::string message = oss.str();
-        if (m_sendPLCSupplyDataQueue.size() == 0) {					//队列为空, 直接发送
-            send_msg = message + "#";
-            if (m_plcSupplyMutex.try_lock()) {						//直接发送
-                m_plc_supplyClient.sendData(send_msg);
-                m_plcSupplyMutex.unlock();
-                Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() send message: ["+send_msg+"]");
-            }
-            else {													//存储到队列中, 下次发送
-                m_sendPLCSupplyDataQueue.push_back(message);
-                Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() store m_sendPLCSupplyDataQueue data: ["+message+"]");
-                return;
-            }
+        plcframes::StdFrame frame;
+        if(!frame.encode(true, supply_id_copy, supply_order_copy)){                    //台号或序列号为负, 超出报文位宽
+            Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() invalid frame fields, supply_id: [" + std::to_string(supply_id)
+                                      + "] supply_order: [" + std::to_string(supply_order) + "]");
+            return;
         }
-        else {														//队列不为空, 先存储到队列中
-            m_sendPLCSupplyDataQueue.push_back(message);
-            if(m_plcSupplyMutex.try_lock()) {
-                send_msg = takeMsgFromPLCSupplyQueue(5);				//每次最多发送5条
-                m_plc_supplyClient.sendData(send_msg);
-                m_plcSupplyMutex.unlock();
-                Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() send message: ["+send_msg+"]");
-            }
-            else{
-                Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() store m_sendPLCSupplyDataQueue data: ["+message+"]");
-                return;
-            }
+        std::string send_msg(frame.view());
+        if (m_supplyAck.sendTracked(supply_id_copy, supply_order_copy, send_msg, scanOriginNs(rxNs))) {		//登记等待应答并入发送队列
+            Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() send message: ["+send_msg+"]");
+        }
+        else {
+            Logger::getInstance().Log("----[DataProcess] sendSupplyDataToPLC() plc not connected, resend on reconnect: ["+send_msg+"]");
         }
-
     }catch(...){}
 }
-void DataProcess::sendSlotToPLC(const std::string& code, const std::string& order_msg, int slot_id){                           //发送格口信息给plc
+void DataProcess::sendSlotToPLC(const WaybillCode& code, const ParcelStateService::SlotAssignment& assigned, int slot_id){     //发送格口信息给plc
     try{
-        std::string send_msg = "";
-        std::string message = "";
-        if(order_msg != ""){                    //有现成序列号
-            std::ostringstream oss;
-            oss << "GK"
-                << order_msg
-                << "G"
-                << std::to_string(slot_id);
-            message = oss.str();
+        int supply_id = -1;
+        int supply_order = -1;
+        if(assigned.found){                     //有现成序列号
+            supply_id = assigned.station;
+            supply_order = assigned.order;
         }
         else{                                   //若没有， 使用数据库中序列号
-            int supply_id = -1;
-            int supply_order = -1;
             auto _mysql = SqlConnectionPool::instance().acquire();
             if(!_mysql){
                 Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() sql pool no free connect!");
                 return;
             }
-            auto query_id = _mysql->queryString("supply_data","code",code,"supply_id");
+            const std::string codeStr = code.str();
+            auto query_id = _mysql->queryString("supply_data","code",codeStr,"supply_id");
             if(query_id){
                 supply_id = std::stoi(*query_id);
             }
-            auto query_order = _mysql->queryString("supply_data","code",code,"supply_order");
+            auto query_order = _mysql->queryString("supply_data","code",codeStr,"supply_order");
             if(query_order){
                 supply_order = std::stoi(*query_order);
             }
-            std::string supply_idStr = std::to_string(supply_id);
-            std::string supply_orderStr = std::to_string(supply_order);
-            std::string send_msg = "";
-            std::ostringstream oss;
-            oss << "GKD"
-                << std::setw(2) << std::setfill('0') << supply_id
-                << "ID"
-                << std::setw(4) << std::setfill('0') << supply_order
-                << "G"
-                << std::to_string(slot_id);                                             //
-            message = oss.str();
-        }
-        if(m_sendPLCSlotDataQueue.size() == 0){                                     //队列为空
-            if(m_plcSendSlotMutex.try_lock()){                                      //直接发送
-                send_msg = message+"#";
-                m_plc_sendSlotClient.sendData(send_msg);
-                m_plcSendSlotMutex.unlock();
-            }
-            else{                                                                   //写入到队列中
-                m_sendPLCSlotDataQueue.push_back(message);
-                Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() store m_sendPLCSlotDataQueue data: ["+message+"]");
-                return;
-            }
         }
-        else{
-            m_sendPLCSlotDataQueue.push_back(message);
-            if(m_plcSendSlotMutex.try_lock()){
-                send_msg = takeMsgFromPLCSendSlotQueue(5);
-                m_plc_sendSlotClient.sendData(send_msg);
-                m_plcSendSlotMutex.unlock();
-            }
-            else{
-                Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() store m_sendPLCSlotDataQueue data: ["+message+"]");
-                return;
-            }
+        plcframes::GkFrame frame;
+        if(!frame.encode(true, supply_id, supply_order, slot_id)){                      //序列号或格口号超出报文位宽
+            Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() invalid frame fields, code: [" + code.str() + "] supply_id: [" + std::to_string(supply_id)
+                                      + "] supply_order: [" + std::to_string(supply_order) + "] slot_id: [" + std::to_string(slot_id) + "]");
+            return;
+        }
+        const ParcelStateService::ScanTime& scanTime = assigned.scan;
+        SlotScheduler::Command cmd;
+        cmd.frame = std::string(frame.view());
+        cmd.stationId = scanTime.stationId;
+        cmd.scanNs = scanTime.rxNs;
+        cmd.deadlineNs = slotDeadlineNs(scanTime);
+        if(!m_slotScheduler.submit(std::move(cmd))){                                  //调度线程按截止时间最早优先发送
+            Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() device stopped, drop message: ["+std::string(frame.view())+"]");
         }
-        Logger::getInstance().Log("----[DataProcess] sendSlotToPLC() send message: ["+send_msg+"]");
     }
     catch(...){}
 }
+int64_t DataProcess::slotDeadlineOffsetNs(int stationId) const{                                      //该供包台从读码到分拣口的时间, 未配置时为 0
+    if(stationId < 1 || m_config.slotDeadlineMs.empty()) return 0;
+    size_t idx = std::min<size_t>(static_cast<size_t>(stationId - 1), m_config.slotDeadlineMs.size() - 1);
+    return static_cast<int64_t>(m_config.slotDeadlineMs[idx]) * 1000000;
+}
+int64_t DataProcess::slotDeadlineNs(const ParcelStateService::ScanTime& scan) const{                                       //读码时间 + 该供包台到分拣口的时间, 读码时间未知时立即发送
+    int64_t offsetNs = slotDeadlineOffsetNs(scan.stationId);
+    if(scan.rxNs <= 0 || offsetNs <= 0) return 0;
+    return scan.rxNs + offsetNs;
+}
+void DataProcess::recordGkWire(int stationId, int64_t scanToWireNs){                                //GK 整条交给内核时按截止时间(读码时间 + 分拣口时间)判断迟到, 在引擎线程调用
+    if(stationId < 1 || stationId > kStationCount) return;
+    GkWireCounters& c = m_gkWire[stationId - 1];
+    c.sent.fetch_add(1, std::memory_order_relaxed);
+    int64_t offsetNs = slotDeadlineOffsetNs(stationId);
+    if(offsetNs <= 0 || scanToWireNs <= offsetNs) return;
+    c.late.fetch_add(1, std::memory_order_relaxed);
+    atomicMax(c.maxLateUs, static_cast<uint64_t>((scanToWireNs - offsetNs) / 1000));
+}
+int64_t DataProcess::scanOriginNs(int64_t rxNs){                                                    //读码接收时间(系统时钟)换算到引擎的单调时钟, 作为 send() 的 originNs
+    if(rxNs <= 0) return 0;
+    int64_t ageNs = std::max<int64_t>(0, UdpReceiver::wallNowNs() - rxNs);
+    return std::max<int64_t>(1, PlcIoEngine::nowNs() - ageNs);
+}
+int64_t DataProcess::frameExpireNs(int64_t originNs) const{                                       //起始时间(读码/收帧)加包裹 TTL, 未配置 TTL 时一直保留到写出
+    if(m_config.parcelTtlSec <= 0) return 0;
+    int64_t from = originNs > 0 ? originNs : PlcIoEngine::nowNs();
+    return from + static_cast<int64_t>(m_config.parcelTtlSec) * 1000000000;
+}
+void DataProcess::recordScanLatency(LatencyHistogram* hists, int stationId, int64_t latencyNs){            //记录读码接收到报文交给内核的延时, 在引擎线程调用
+    if(stationId < 1 || stationId > kStationCount) return;
+    hists[stationId - 1].record(latencyNs / 1000);
+}
 
 static inline void ltrim(std::string &s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch){ return !std::isspace(ch); }));
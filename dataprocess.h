@@ -1,14 +1,28 @@
 #ifndef DATAPROCESS_H
 #define DATAPROCESS_H
 #include <QObject>
-#include "TcpSocketClient.h"
+#include "plcioengine.h"
 #include "QtTcpServer.h"
 #include "jtrequest.h"
 #include <shared_mutex>
 #include <deque>
+#include <string_view>
 #include "spsc_ring.h"
 #include "UdpReceiver.h"
+#include "runtimeconfig.h"
+#include "scanparser.h"
+#include "scandedup.h"
+#include "latencyhistogram.h"
+#include "spillqueue.h"
+#include "plcframedecoder.h"
+#include "slotscheduler.h"
+#include "acktracker.h"
+#include "unloadparser.h"
+#include "pipelinestage.h"
+#include "parcelstate.h"
+#include "waybillcode.h"
 #include "unordered_map"
+#include <memory>
 class DataProcess : public QObject
 {
     Q_OBJECT
@@ -21,35 +35,32 @@ public:
     int getOperateType();                                                  //得到当前操作模式
 
 private:
-    bool plcSupplyTcpConnect(bool destorySock);
-    bool plcSendSlotTcpConnect(bool destorySock);
-    bool plcRecvUnloadTcpConnect(bool destorySock);
-    bool plcRecvSlotStatusTcpConnect(bool destorySock);
     void dbInit();
     void tcpConnect();
-    void checkTcpConn();
-    void startTcpCheckThread();
-    void stopTcpCheckThread();
 
-    void sendSupplyDataToPLC(int supply_id, int supply_order);              //STD+供包台+ID+供包台序列号+00000
-    void sendSlotToPLC(const std::string& code, const std::string& order_msg, int slot_id);
-    int insertSupplyDataToDB(const std::string& code,                       //插入数据库, 若返回-1代表还未请求格口号
+    void sendSupplyDataToPLC(int supply_id, int supply_order, int64_t rxNs = 0);    //STD+供包台+ID+供包台序列号+00000, rxNs 为读码接收时间
+    void sendSlotToPLC(const WaybillCode& code, const ParcelStateService::SlotAssignment& assigned, int slot_id);      //序列号不在内存中时查数据库
+    int insertSupplyDataToDB(const WaybillCode& waybill,                    //插入数据库, 若返回-1代表还未请求格口号
                              const std::string& weight,
                              int supply_id,
                              int supply_order);
-    std::string takeMsgFromPLCSupplyQueue(size_t n);
-    std::string takeMsgFromPLCSendSlotQueue(size_t n);
     int updateSupplyOrder(int supply_id);                                  //更新每个供包台对应的序列号
-    void requestAndSendToPLC(const std::string& code, const std::string& weight, int slot_id);
+    void requestAndSendToPLC(const WaybillCode& code, const std::string& weight, int slot_id, int supply_id = 0);   //supply_id 已知时只查该供包台所在的状态分片
 
 private:
-    std::shared_mutex m_plcSupplyMutex;
-    SocketClient m_plc_supplyClient;        //2061 socket连接
-    std::shared_mutex m_plcSendSlotMutex;
-    SocketClient m_plc_sendSlotClient;      //2062 socket连接
-    std::shared_mutex m_plcUnloadMutex;
-    SocketClient m_plc_unloadClient;        //2063 socket连接
-    SocketClient m_plc_slotStatusClient;    //2064 socket连接
+    PlcIoEngine m_plcEngine;                //PLC 四个端口的连接, 一个事件循环线程, 也是各端口唯一的写者
+    int m_connSupply = -1;                  //2061 连接编号
+    int m_connSendSlot = -1;                //2062 连接编号
+    int m_connUnload = -1;                  //2063 连接编号
+    int m_connSlotStatus = -1;              //2064 连接编号
+    PlcFrameDecoder m_supplyDecoder;        //各连接的 '#' 分帧, 只在引擎线程使用
+    PlcFrameDecoder m_sendSlotDecoder;
+    PlcFrameDecoder m_unloadDecoder;
+    PlcFrameDecoder m_slotStatusDecoder;
+    const PlcFrameDecoder* plcDecoder(int conn) const;
+    AckTracker m_supplyAck{"supply"};       //2061 STD 应答匹配及超时重发
+    AckTracker m_slotAck{"send slot"};      //2062 GK 应答匹配及超时重发
+    void logAckStats(AckTracker& tracker);
     // std::string m_plc_ip = "192.168.2.10";
     std::string m_plc_ip = "192.168.2.98";
     int m_plc_supply = 2061;                                                //发送上件端口
@@ -57,19 +68,15 @@ private:
     int m_plc_unload = 2063;                                                //接收下件端口
     int m_plc_slotStatus = 2064;                                            //接收格口状态端口
 
-    std::atomic<bool> isRecvAndSend{true};                                  //发送拱包信息到plc后, 变为false, 需要等到接收回plc的信息后才可以再次发送
-    std::deque<std::string> m_sendPLCSupplyDataQueue;                       //发送供包台数据队列
-    std::deque<std::string> m_haveSentPLCSupplyDataQueue;                   //已发送供包台数据队列
-    std::deque<std::string> m_sendPLCSlotDataQueue;                         //发送格口数据队列
     QtTcpServer* m_recvPdaServer = nullptr;                                 //pda巴枪服务器
     int m_recvPdaPort = 3021;                                               //pda巴枪端口
-    std::atomic<bool> m_tcpChecking{ false };                               //tcp客户端心跳线程
-    std::thread m_tcpCheckThread;
 
     int m_operateType = 0;                                                  //操作类型, 1为进港, 2为出港
 
+    static constexpr int kStationCount = 12;                                //供包台数
+
     std::atomic<int> m_msgOrder{ 1 };                                       //消息序列号
-    std::vector<int> m_supplyIDToOrder;                                     //供包台号对应的上件序列号
+    std::atomic<int> m_supplyIDToOrder[kStationCount];                      //供包台号对应的上件序列号, 多个读码分片线程并发递增
 
     JTRequest m_requestAPI;                                                 //请求类
 
@@ -79,55 +86,151 @@ private:
     std::unordered_map<int, int> m_slotStatus;                      //格口状态, 0 = 正常, 1 = 锁格
     std::unordered_map<int, std::string> m_slotToPackage;           //格口对应的包牌号
     std::unordered_map<int, std::string> m_slotTodeliveryCodeMap;               //格口对应派件员编码， 进港
+    int m_arrivalExceptionSlot = 0;                                             //进港异常格, dbInit 时取出, 读码线程只读这两个值
+    int m_departureExceptionSlot = 0;                                           //出港异常格
+    static constexpr int32_t kDefaultWeightGrams = 500;                        //重量无法解析时使用的默认重量, 与下件回传的默认值一致
 
 
     //接收读码平台消息
-    UdpReceiver* _udpSupplyReceiver;
-    std::unordered_map<std::string, std::string> m_msgToCodeMap;               //货物在线体上的周期, 使用供包台号以及序列号对应上单号
-    std::unordered_map<std::string, std::string> m_codeToMsgMap;               //单号对应供包台以及序列号
-    std::unordered_map<std::string, int> m_codeToSlotMap;                       //单号所对应的格口号
-    struct supplyRaw {std::string data;};
-    SpscRing<supplyRaw> supplyRing{1<<14};
-    std::atomic<uint64_t> supplyRingDrops{0};
-    std::thread supplyWorkerThread;
-    bool supplyWorkerRunning = false;
-    void startSupplyWorker();
+    ParcelStateService m_parcelState{kStationCount};                            //包裹在线体上的周期: 序列号键/单号/格口/读码时间, 按供包台分片, 各分片单线程读写
+    static constexpr size_t kSupplyMaxLen = 256;                                //单条读码消息最大长度
+    struct supplyRaw {                                                          //接收线程直接写入的槽位, 不做堆分配
+        uint32_t len = 0;
+        int64_t recvUs = 0;                                                     //进入ring的时间(steady clock, 微秒)
+        int64_t rxNs = 0;                                                       //收包时间(系统时钟, 纳秒), 内核时间戳优先
+        char data[kSupplyMaxLen];
+        std::string_view view() const { return std::string_view(data, len); }
+    };
+    struct SupplyShard {                                                        //处理分片: 按供包台号分配, 独立的ring和处理线程
+        int index = 0;
+        SpscRing<supplyRaw> ring{1<<14};
+        supplyRaw* reserved[64];                                                //接收线程本批reserve的槽位
+        std::thread worker;
+        std::atomic<uint64_t> received{0};                                      //分发到本分片的报文数
+        std::atomic<uint64_t> drops{0};                                         //ring满丢弃数
+        std::atomic<uint64_t> processed{0};                                     //已处理数
+        std::atomic<uint64_t> exceptions{0};                                    //未读出/单号非法/重量非法, 按异常件上件的数量
+        std::atomic<uint64_t> latencySumUs{0};                                  //进入ring到处理完成的耗时
+        std::atomic<uint64_t> latencyMaxUs{0};
+        std::unique_ptr<ScanDedup> dedup;                                       //重复读码抑制, 窗口为0时不创建
+        SpillQueue spill;                                                       //ring 满时的溢出文件, 记录为 [接收时间][报文]
+    };
+    std::vector<std::unique_ptr<SupplyShard>> m_supplyShards;
+    UdpReceiver m_supplyReceiver{3011, "192.168.2.98"};                         //唯一的读码接收socket, 按供包台号分发到各分片
+    std::atomic<bool> supplyWorkerRunning{false};
+    void startSupplyShards();
+    void startSupplyWorker(SupplyShard& shard);
+    void dispatchSupplyBatch(const UdpReceiver::Datagram* msgs, size_t count);
+    static void spillSupply(SupplyShard& shard, const UdpReceiver::Datagram& msg);
     void stopSupplyWorker();
-    void onSupplyUDPServerRecv(const std::string& message);
+    void ingestSupplyMessage(SupplyShard& shard, std::string_view message, int64_t rxNs);
+    void onSupplyUDPServerRecv(const ScanRecord& scan, const WaybillCode& code, int64_t rxNs);
+    void inductExceptionParcel(const ScanRecord& scan, const WaybillCode& code, int64_t rxNs);   //照常上件(STD), 直接下发异常格
+
+    //读码到 STD/GK 整条交给内核的延时, 按供包台统计; 由引擎写出时回调, 未写出或过期丢弃的报文不计
+    LatencyHistogram m_scanToStdHist[kStationCount];
+    LatencyHistogram m_scanToGkHist[kStationCount];
+    static int64_t scanOriginNs(int64_t rxNs);
+    int64_t frameExpireNs(int64_t originNs) const;                  //报文在引擎中保留到包裹 TTL 为止, 断线期间超过的不再补发
+    void recordScanLatency(LatencyHistogram* hists, int stationId, int64_t latencyNs);
+    struct GkWireCounters {                                         //GK 首次整条交给内核时按截止时间统计, 在引擎线程写
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> late{0};                              //写出时已超过截止时间的条数
+        std::atomic<uint64_t> maxLateUs{0};                         //本周期最大迟到时长, 读取后清零
+    };
+    GkWireCounters m_gkWire[kStationCount];
+    void recordGkWire(int stationId, int64_t scanToWireNs);
+    int64_t slotDeadlineOffsetNs(int stationId) const;
+    int64_t slotDeadlineNs(const ParcelStateService::ScanTime& scan) const;
+    SlotScheduler m_slotScheduler;                                  //GK 报文按截止时间最早优先发送, 2062 写者空闲时才取出
 
-    struct receiveRaw
+    struct plcFrame                                                 //一帧完整的PLC报文(不含'#'), 直接存放在ring槽位中
     {
-        QByteArray data;
+        int64_t rxNs = 0;                                           //引擎线程收到该帧的时间(PlcIoEngine::nowNs)
+        uint16_t len = 0;
+        bool repeated = false;                                      //解码器判定为 PLC 重发
+        char data[PlcFrameDecoder::kMaxFrame];
+        std::string_view view() const { return std::string_view(data, len); }
     };
+    bool pushPlcFrame(SpscRing<plcFrame>& ring, SpillQueue& spill, std::string_view frame, int64_t rxNs = 0, bool repeated = false);
+    static constexpr uint32_t kPlcSpillHead = sizeof(int64_t) + 1;  //溢出文件记录头: [接收时间][是否重发]
+    static bool readPlcSpill(const char* p, uint32_t len, std::string_view& frame, int64_t& rxNs, bool& repeated);
     //下件接收
-    SpscRing<receiveRaw> unloadRing{1<<14};
+    SpscRing<plcFrame> unloadRing{1<<14};
     std::atomic<uint64_t> unloadRingDrops{0};
+    SpillQueue unloadSpill;
     std::thread unloadWorkerThread;
-    bool unloadWorkerRunning = false;
+    std::atomic<bool> unloadWorkerRunning{false};
     void startUnloadWorker();
     void stopUnloadWorker();
-    void onPLCUnLoadRecv(const QByteArray& data);       //2013
-    void sendUnloadRecvToPLC(const std::string& data);
+    void onPLCUnLoadRecv(std::string_view frame, int64_t rxNs = 0, bool repeated = false);       //2013
+    void sendUnloadRecvToPLC(std::string_view frame, int64_t rxNs);
+    std::atomic<uint64_t> m_unloadAcks{0};                          //已入发送队列的下件回复
+    std::atomic<uint64_t> m_unloadAckDrops{0};                      //未连接或发送缓冲区满, 未能回复的下件帧
     std::string unload_fail = "FA";                     //失败字样
 
+    //包裹处理流水线: 解析(读码/下件 ring 线程) -> 状态(同线程, 只改内存表) -> PLC 下发(引擎发送队列/GK 调度线程)
+    //             -> 路由(m_routeStage: 写读码记录取格口, 请求段码或下发 GK) -> 落库(m_persistStage: 只写库) -> 回传(m_reportStage)
+    //             数据库和接口调用只在后三级, 前几级用 post() 入队, 从不等待后三级; 纯写库的任务不占用路由阶段, 不拖慢 GK
+    //             超时回收的包裹走单线程的 m_expiryStage, 由包裹状态分片限速, 不与上面几级争抢
+    struct PersistJob {
+        enum Kind { Supply, TerminalSlot };                         //Supply 及需查库下发 GK 的 TerminalSlot 走路由阶段, 其余走落库阶段
+        Kind kind = Supply;
+        WaybillCode code;                                           //内联存储, 写库时再转 std::string
+        std::string weight;
+        int supplyId = -1;
+        int supplyOrder = -1;
+        int slotId = -1;
+        bool sendSlot = false;                                      //TerminalSlot: 内存中没有序列号, 查数据库后再下发 GK
+        ParcelStateService::ScanTime scan;                          //sendSlot 时带上已取出的读码时间
+    };
+    PipelineStage<PersistJob> m_routeStage{"route", 4096, 4};
+    PipelineStage<PersistJob> m_persistStage{"persist", 4096, 2};
+    struct UnloadReport {                                           //包裹状态分片取出下件记录后交给回传阶段
+        UnloadRecord rec;
+        ParcelStateService::UnloadLookup parcel;
+    };
+    PipelineStage<UnloadReport> m_reportStage{"report", 4096, 2};
+    PipelineStage<ParcelStateService::ExpiredParcel> m_expiryStage{"expiry", 1024, 1};
+    void routeParcel(PersistJob& job);
+    void persistParcel(PersistJob& job);
+    void onParcelExpired(const ParcelStateService::ExpiredParcel& parcel);
+    void recordExpiredParcel(const ParcelStateService::ExpiredParcel& parcel);
+    void onParcelUnloaded(const UnloadRecord& rec, const ParcelStateService::UnloadLookup& parcel);
+    void reportUnload(const UnloadReport& job);
+    void startPipeline();
+    void stopPipeline();
+    template<typename T> void logStage(PipelineStage<T>& stage);
+
     //格口状态接收, 用于更换包牌
-    SpscRing<receiveRaw> slotStatusRing{1<<14};
+    SpscRing<plcFrame> slotStatusRing{1<<14};
     std::atomic<uint64_t> slotStatusRingDrops{0};
+    SpillQueue slotStatusSpill;
     std::thread slotStatusWorkerThread;
-    bool slotStatusWorkerRunning = false;
+    std::atomic<bool> slotStatusWorkerRunning{false};
     void startSlotStatusWorker();
     void stopSlotStatusWorker();
-    void onPLCSlotStatusRecv(const QByteArray& data);  //2014
+    void onPLCSlotStatusRecv(std::string_view frame);  //2014
 
     std::atomic<bool> m_deviceRunning{false};                       //开启运行后， 代表线体起来
     std::vector<std::string> m_supplyMacVector;
 
+    RuntimeConfig m_config;                                         //config.json 中的运行参数
+    std::thread m_statsThread;                                      //定时输出统计信息
+    std::atomic<bool> m_statsRunning{false};
+    void startStatsThread();
+    void stopStatsThread();
+    void reportStats();
+    void openSpill(SpillQueue& spill, const std::string& name);
+    std::unordered_map<const SpillQueue*, uint64_t> m_spillDrainedAtReport;   //上次统计时的读回条数, 只在统计线程访问
+    void logSpill(const std::string& name, const SpillQueue& spill, uint64_t drops);
+
 signals:
     void onUDPReceived(const QString& message);
 private slots:
     void onPLCSupplyRecv(const QByteArray& data);       //2011
     void onPLCSendSlotRecv(const QByteArray& data);     //2012
     void onPdaTCPServerRecv(int clientId, const QString& message);
-    void onTerminalCodeRecv(const QString& code, const std::string& terminalCode, int order_type, int interceptor);
+    void onTerminalCodeRecv(const WaybillCode& code, const std::string& terminalCode, int order_type, int interceptor);
 };
 #endif // DATAPROCESS_H
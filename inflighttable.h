@@ -0,0 +1,193 @@
+#ifndef INFLIGHTTABLE_H
+#define INFLIGHTTABLE_H
+
+// 在线体上的包裹表: 按 (供包台, 序列号) 直接下标的定长数组, 每条记录一个缓存行(单号, 重量, 格口, 时间戳, 代数)
+// 序列号键只有 台数 x 9999 个, 构造时一次分配, 之后不做堆分配; 下件按键查找只是一次数组下标
+// 另有按单号的开放寻址索引(线性探测, 后移删除), 指向该单号最近一次读码的记录
+// 同一键再次写入(序列号循环)时覆盖旧记录, 代数加 1, 旧记录计入 reused
+// 非线程安全, 每个包裹状态分片持有一个实例
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include "waybillcode.h"
+
+class InflightTable {
+public:
+    static constexpr size_t kMaxCode = WaybillCode::kMaxLen;
+
+    struct alignas(64) Parcel {
+        enum Flag : uint8_t {
+            Live = 1,               // 记录有效
+            PendingSlot = 2,        // 序列号键尚未被格口下发取走
+            ScanTaken = 4,          // 读码时间已被格口下发取走
+            HasSlot = 8,            // 已确定格口
+        };
+        char code[kMaxCode];
+        uint8_t codeLen = 0;
+        uint8_t flags = 0;
+        int32_t weightGrams = -1;   // 重量(克), 未知为 -1
+        int32_t slot = -1;
+        uint32_t generation = 0;    // 该键被写入的次数
+        int64_t scanNs = 0;         // 读码接收时间(系统时钟纳秒)
+        int64_t slotNs = 0;         // 格口确定时间
+
+        std::string_view codeView() const { return std::string_view(code, codeLen); }
+        WaybillCode waybill() const { return WaybillCode::from(codeView()); }
+        bool has(Flag f) const { return (flags & f) != 0; }
+    };
+    static_assert(sizeof(Parcel) == 64, "parcel record should fill one cache line");
+
+    InflightTable(int stationCount, int maxOrder)
+        : stations_(std::max(1, stationCount)), maxOrder_(std::max(1, maxOrder)),
+          records_(static_cast<size_t>(stations_) * maxOrder_)
+    {
+        size_t buckets = 16;
+        while (buckets < records_.size() * 2) buckets <<= 1;
+        index_.assign(buckets, IndexEntry{ 0, kEmpty });
+        mask_ = buckets - 1;
+    }
+
+    // 键超出范围返回 nullptr; 返回的记录不一定有效, 需检查 Live
+    Parcel* at(int station, int order) {
+        if (station < 1 || station > stations_ || order < 1 || order > maxOrder_) return nullptr;
+        return &records_[slotOf(station, order)];
+    }
+
+    // 按单号查找最近一次读码的有效记录, 使用单号已算好的哈希
+    Parcel* find(const WaybillCode& code) {
+        if (code.empty()) return nullptr;
+        size_t i = probe(fold(code.hash()), code.view());
+        return index_[i].rec == kEmpty ? nullptr : &records_[index_[i].rec];
+    }
+
+    // 写入 (台, 序) 的记录并更新单号索引, 覆盖该键上的旧记录; 键或单号不合法返回 nullptr
+    Parcel* insert(int station, int order, const WaybillCode& code, int32_t weightGrams, int64_t scanNs) {
+        Parcel* p = at(station, order);
+        if (!p || code.empty() || code.size() > kMaxCode) return nullptr;
+        if (p->has(Parcel::Live)) {
+            ++reused_;
+            erase(*p);
+        }
+        uint32_t gen = p->generation + 1;
+        *p = Parcel();
+        std::memcpy(p->code, code.data(), code.size());
+        p->codeLen = static_cast<uint8_t>(code.size());
+        p->flags = Parcel::Live | Parcel::PendingSlot;
+        p->weightGrams = weightGrams;
+        p->scanNs = scanNs;
+        p->generation = gen;
+        ++live_;
+        ++pending_;
+        uint32_t rec = static_cast<uint32_t>(p - records_.data());
+        uint32_t h = fold(code.hash());
+        size_t i = probe(h, code.view());
+        if (index_[i].rec != kEmpty) {                                      // 同一单号再次读码, 索引改指新记录
+            Parcel& prev = records_[index_[i].rec];
+            if (prev.has(Parcel::PendingSlot)) {                            // 旧记录不再能按单号找到
+                prev.flags &= ~Parcel::PendingSlot;
+                --pending_;
+            }
+        }
+        index_[i] = IndexEntry{ h, rec };
+        return p;
+    }
+
+    // 取出序列号键(只取一次), 返回之前是否未被取走
+    bool takeKey(Parcel& p) {
+        if (!p.has(Parcel::PendingSlot)) return false;
+        p.flags &= ~Parcel::PendingSlot;
+        --pending_;
+        return true;
+    }
+
+    // 取出读码时间(只取一次), 已取走返回 0
+    int64_t takeScan(Parcel& p) {
+        if (p.has(Parcel::ScanTaken)) return 0;
+        p.flags |= Parcel::ScanTaken;
+        return p.scanNs;
+    }
+
+    void setSlot(Parcel& p, int32_t slot, int64_t nowNs) {
+        if (!p.has(Parcel::HasSlot)) ++assigned_;
+        p.flags |= Parcel::HasSlot;
+        p.slot = slot;
+        p.slotNs = nowNs;
+    }
+
+    // 删除记录及其单号索引(索引指向其他记录时保留)
+    void erase(Parcel& p) {
+        if (!p.has(Parcel::Live)) return;
+        uint32_t rec = static_cast<uint32_t>(&p - records_.data());
+        size_t i = probe(fold(WaybillCode::hashOf(p.codeView())), p.codeView());
+        if (index_[i].rec == rec) removeAt(i);
+        --live_;
+        if (p.has(Parcel::PendingSlot)) --pending_;
+        if (p.has(Parcel::HasSlot)) --assigned_;
+        p.flags = 0;
+    }
+
+    uint32_t indexOf(const Parcel& p) const { return static_cast<uint32_t>(&p - records_.data()); }
+    Parcel& atIndex(uint32_t i) { return records_[i]; }
+    size_t capacity() const { return records_.size(); }
+    int stationOf(const Parcel& p) const { return static_cast<int>((&p - records_.data()) / maxOrder_) + 1; }
+    int orderOf(const Parcel& p) const { return static_cast<int>((&p - records_.data()) % maxOrder_) + 1; }
+
+    size_t live() const { return live_; }                   // 有效记录数
+    size_t pending() const { return pending_; }             // 等待格口的记录数
+    size_t assigned() const { return assigned_; }           // 已确定格口、等待下件的记录数
+    uint64_t reused() const { return reused_; }             // 未下件即被新包裹覆盖的记录数
+    size_t bytes() const { return records_.size() * sizeof(Parcel) + index_.size() * sizeof(IndexEntry); }
+
+private:
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    struct IndexEntry {
+        uint32_t hash;              // 单号哈希, 低位同时决定探测起点
+        uint32_t rec;               // 记录下标, kEmpty 为空位
+    };
+
+    static uint32_t fold(uint64_t h) { return static_cast<uint32_t>(h ^ (h >> 32)); }     // WaybillCode 的 64 位哈希折成 32 位
+
+    size_t slotOf(int station, int order) const {
+        return static_cast<size_t>(station - 1) * maxOrder_ + static_cast<size_t>(order - 1);
+    }
+
+    // 返回单号所在的索引位置, 不存在时返回探测链末尾的空位
+    size_t probe(uint32_t h, std::string_view code) const {
+        size_t i = h & mask_;
+        while (index_[i].rec != kEmpty) {
+            if (index_[i].hash == h && records_[index_[i].rec].codeView() == code) break;
+            i = (i + 1) & mask_;
+        }
+        return i;
+    }
+
+    // 线性探测用后移删除保持探测链连续
+    void removeAt(size_t hole) {
+        for (size_t j = (hole + 1) & mask_; index_[j].rec != kEmpty; j = (j + 1) & mask_) {
+            size_t home = index_[j].hash & mask_;
+            bool movable = (hole <= j) ? (home <= hole || home > j) : (home <= hole && home > j);
+            if (movable) {
+                index_[hole] = index_[j];
+                hole = j;
+            }
+        }
+        index_[hole] = IndexEntry{ 0, kEmpty };
+    }
+
+    int stations_;
+    int maxOrder_;
+    std::vector<Parcel> records_;
+    std::vector<IndexEntry> index_;
+    size_t mask_ = 0;
+    size_t live_ = 0;
+    size_t pending_ = 0;
+    size_t assigned_ = 0;
+    uint64_t reused_ = 0;
+};
+
+#endif // INFLIGHTTABLE_H
@@ -540,11 +540,15 @@ void JTRequest::onNetworkFinished(QNetworkReply* reply) //所有的回调
                             // 有时候字段名可能不同，尝试 fallback 查找 "waybill"
                             waybill = firstObj.value("waybill").toString();
                         }
-                        if(m_operateType == 1){                             //进港, 使用第三段码
-                            emit slotResult(waybill, thirdTerminalCode, order_type, interceptor);
+                        WaybillCode waybillCode = WaybillCode::fromQString(waybill);
+                        if(waybillCode.empty()){                            //单号为空或含非法字符, 无法对应线体上的包裹
+                            debugLog("----[JTRequest] onNetworkFinished() invalid waybill in get_terminalCode: [" + waybill + "]");
+                        }
+                        else if(m_operateType == 1){                        //进港, 使用第三段码
+                            emit slotResult(waybillCode, thirdTerminalCode, order_type, interceptor);
                         }
                         else{                                               //出港， 使用一段码
-                            emit slotResult(waybill, terminal_code, order_type,interceptor);
+                            emit slotResult(waybillCode, terminal_code, order_type,interceptor);
                         }
                         // emit slotResult(waybill, terminal_code, order_type);
                     }
@@ -571,7 +575,13 @@ void JTRequest::onNetworkFinished(QNetworkReply* reply) //所有的回调
                     QString waybill = dataObj.value("waybillNo").toString();
                     if (waybill.isEmpty()) waybill = dataObj.value("waybill").toString();
 
-                    emit slotResult(waybill, terminal_code, 1, 2);
+                    WaybillCode waybillCode = WaybillCode::fromQString(waybill);
+                    if (waybillCode.empty()) {
+                        debugLog("----[JTRequest] onNetworkFinished() invalid waybill in get_terminalCode: [" + waybill + "]");
+                    }
+                    else {
+                        emit slotResult(waybillCode, terminal_code, 1, 2);
+                    }
                 }
                 else {
                     debugLog("----[JTRequest] onNetworkFinished()  data is neither array nor object");
@@ -653,10 +663,10 @@ void JTRequest::requestToken(const QString& account, const QString& password, co
 
     enqueueOrSend(req, payload, "login", 1, true);
 }
-void JTRequest::requestTerminalCode(const QString& Code)                                //请求一段码
+void JTRequest::requestTerminalCode(const WaybillCode& code)                            //请求一段码
 {
     QJsonObject body;
-    body["waybillNo"] = Code;
+    body["waybillNo"] = code.toQString();
     QJsonDocument doc(body);
     QByteArray payload = doc.toJson(QJsonDocument::Compact);
     Logger::getInstance().Log("----[JTRequest] requestTerminalCode() request body: "+QString::fromUtf8(payload).toStdString());
@@ -700,19 +710,19 @@ void JTRequest::requestTerminalCode(const QString& Code)
     auto _sql = SqlConnectionPool::instance().acquire();
     if(_sql){
         const std::vector<std::string> column = {"code","request_body"};
-        const std::vector<std::string> values = {Code.toStdString(),QString::fromUtf8(payload).toStdString()};
+        const std::vector<std::string> values = {code.str(),QString::fromUtf8(payload).toStdString()};
         _sql->insertRow("terminal_request_data",column,values);
     }
 }
 
-void JTRequest::requestUploadData(const QString& Code, const QString& weight)                           // 四合一 到件补收入发，出港，扫描后直接使用
+void JTRequest::requestUploadData(const WaybillCode& code, const QString& weight)                        // 四合一 到件补收入发，出港，扫描后直接使用
 {
     QString time_mill = QString::fromStdString(std::to_string(currentTimeMillis()));
 
     // 单条数据对象
     QJsonObject item;
     item["listId"] = m_account + time_mill;     // 网点编码+当前时间毫秒数
-    item["waybillId"] = Code;
+    item["waybillId"] = code.toQString();
     item["arriveScanType"] = "1";               // ⚠️ 建议保持字符串/数字一致性
     item["scanTime"] = QString::fromStdString(getCurrentTime());
     item["weight"] = weight;
@@ -748,12 +758,12 @@ void JTRequest::requestUploadData(const QString& Code, const QString& weight)
     attachAuthHeader(req);
     enqueueOrSend(req, payload, "upload", 5);
 }
-void JTRequest::requestBuildOneByOne(const QString& code, const QString& packageNum){                       //单个件建包接口， 在掉格口的时候使用
+void JTRequest::requestBuildOneByOne(const WaybillCode& code, const QString& packageNum){                       //单个件建包接口， 在掉格口的时候使用
 
     auto _sql = SqlConnectionPool::instance().acquire();
     QString scanTime = "";
     if(_sql){
-        auto scan_time = _sql->queryString("supply_data","code",code.toStdString(),"scan_time");
+        auto scan_time = _sql->queryString("supply_data","code",code.str(),"scan_time");
         if(scan_time){
             scanTime = QString::fromStdString(*scan_time);
         }
@@ -771,7 +781,7 @@ void JTRequest::requestBuildOneByOne(const QString& code, const QString& package
     QJsonArray detailArr;
     QJsonObject d;
     d["listId"] = listId;
-    d["waybillId"] = code;
+    d["waybillId"] = code.toQString();
 
     d["scanTime"] = scanTime.isEmpty() ? QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") : scanTime;
     d["packageNumber"] = packageNum;
@@ -825,7 +835,7 @@ QString makeToken(const QString &appSecret, const QString &timestamp, const QStr
 
     return QString::fromUtf8(tokenBase64);
 }
-void JTRequest::requestSmallData(const QString& code,
+void JTRequest::requestSmallData(const WaybillCode& code,
                                  const QString& weight,
                                  int operateType,
                                  int slot_id,
@@ -835,7 +845,7 @@ void JTRequest::requestSmallData(const QString& code,
     // 单条数据对象
     QJsonObject item;
 
-    item["waybillNo"] = code;
+    item["waybillNo"] = code.toQString();
     item["networkCode"] = m_account;                                //网点编码
     item["scanTime"] = QString::fromStdString(getCurrentTime());    //扫描时间
     item["userNum"] = m_account;                                    //登陆人账号
@@ -890,8 +900,8 @@ void JTRequest::requestSmallData(const QString& code,
     // attachAuthHeader(req);
     enqueueOrSend(req, payload, "smallItem", 3);
 }
-void JTRequest::unloadToPieces(const QString& code, const QString& weight){                            //卸车到件, 进港,需要添加图片
-    const QString codeCopy = code;
+void JTRequest::unloadToPieces(const WaybillCode& code, const QString& weight){                        //卸车到件, 进港,需要添加图片
+    const WaybillCode codeCopy = code;                                      //定长值, 按值捕获不分配
     const QString weightCopy = weight;
     // 后台任务：阻塞方式查询 short_url（在工作线程里，不会阻塞主线程）
     auto future = QtConcurrent::run([codeCopy]() -> QString {
@@ -899,7 +909,7 @@ void JTRequest::unloadToPieces(const QString& code, const QString& weight){
         auto _sql = SqlConnectionPool::instance().acquire();
         if (_sql)
         {
-            const std::string db_code = codeCopy.toStdString();
+            const std::string db_code = codeCopy.str();
             constexpr int maxTries = 15;                                        //延迟15秒
             constexpr std::chrono::milliseconds interval(1000);
 
@@ -926,7 +936,7 @@ void JTRequest::unloadToPieces(const QString& code, const QString& weight){
         QString time_mill = QString::fromStdString(std::to_string(currentTimeMillis()));
         QJsonObject item;
         item["listId"] = m_account + time_mill;
-        item["waybillId"] = codeCopy;
+        item["waybillId"] = codeCopy.toQString();
         item["scanTime"] = QString::fromStdString(getCurrentTime());
         item["scanTypeCode"] = 92;
         item["weight"] = weightCopy;
@@ -1011,7 +1021,7 @@ void JTRequest::unloadToPieces(const QString& code, const QString& weight){
 //     attachAuthHeader(req);                                                              //请求头加入autoken， 是登录成功后返回的token值
 //     enqueueOrSend(req, payload, "outboundScanning", 3);
 // }
-void JTRequest::outboundScanning(const QString& code, const QString& deliveryCode) {
+void JTRequest::outboundScanning(const WaybillCode& code, const QString& deliveryCode) {
     // 立即设置一个 10 秒后执行的单次定时器（10000 ms）
     Logger::getInstance().Log("----[JTRequest] outboundScanning() request!");
     QTimer::singleShot(12000, this, [this, code, deliveryCode]() {
@@ -1019,7 +1029,7 @@ void JTRequest::outboundScanning(const QString& code, const QString& deliveryCod
         QString time_mill = QString::fromStdString(std::to_string(currentTimeMillis()));
         QJsonObject item;
         item["listId"] = m_account + time_mill;
-        item["waybillId"] = code;
+        item["waybillId"] = code.toQString();
         item["deliveryCode"] = deliveryCode;
         item["scanTime"] = QString::fromStdString(getCurrentTime());
         item["scanPda"] = m_equipmentID;
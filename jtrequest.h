@@ -12,6 +12,7 @@
 #include <QMutex>
 #include <QJsonObject>
 #include <atomic>
+#include "waybillcode.h"
 
 struct PendingInfo {
     std::string weight;
@@ -86,25 +87,25 @@ private:
 private slots:
     void onNetworkFinished(QNetworkReply* reply);
     void checkPendingTimeouts();
-    void requestTerminalCode(const QString& code);                                              //请求三段码
-    void requestSmallData(const QString& code,
+    void requestTerminalCode(const WaybillCode& code);                                          //请求三段码
+    void requestSmallData(const WaybillCode& code,
                           const QString& weight,
                           int operateType,
                           int slot_id,
                           int supply_id,
                           const QString& supply_mac);         //小件回传数据
 
-    void requestUploadData(const QString& code, const QString& weight);                         //四合一扫描,补收入发 集散点
+    void requestUploadData(const WaybillCode& code, const QString& weight);                     //四合一扫描,补收入发 集散点
     // void requestBuild(const QString& packageNum);                                               //建包接口,所有数据从数据库拿
-    void requestBuildOneByOne(const QString& code, const QString& packageNum);                  //建包接口，掉一个建一个
+    void requestBuildOneByOne(const WaybillCode& code, const QString& packageNum);              //建包接口，掉一个建一个
 
-    void unloadToPieces(const QString& code, const QString& weight);                            //卸车到件, 进港
-    void outboundScanning(const QString& code, const QString& deliveryCode);                    //出仓扫描， 进港
+    void unloadToPieces(const WaybillCode& code, const QString& weight);                        //卸车到件, 进港
+    void outboundScanning(const WaybillCode& code, const QString& deliveryCode);                //出仓扫描， 进港
 
 signals:
     void loginSucceeded();
     void loginFailed(const QString& reason);
-    void slotResult(const QString& waybill, const std::string& terminalCode, int order_type, int interceptor);              //单号，段码，订单类型，拦截状态
+    void slotResult(const WaybillCode& waybill, const std::string& terminalCode, int order_type, int interceptor);              //单号，段码，订单类型，拦截状态
     //通用请求失败回调
     void requestFailed(const QString& url, const QString& reason);
 
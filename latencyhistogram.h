@@ -0,0 +1,85 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+// 延时直方图: 按微秒取 log2 分桶, 第 i 个桶覆盖 [2^(i-1), 2^i) 微秒, 桶 0 为 0 微秒
+// 记录端只做一次 relaxed fetch_add, 可多线程并发写; 读取端做近似分位数统计
+// takeSummary() 输出后清零, 用于按统计周期输出
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <bit>
+
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 40;                 // 2^39 微秒约 6 天, 足够覆盖
+
+    void record(int64_t us) {
+        uint64_t v = us > 0 ? static_cast<uint64_t>(us) : 0;
+        int b = v ? static_cast<int>(std::bit_width(v)) : 0;
+        if (b >= kBuckets) b = kBuckets - 1;
+        buckets_[b].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(v, std::memory_order_relaxed);
+        uint64_t cur = max_.load(std::memory_order_relaxed);
+        while (v > cur && !max_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t avgUs = 0;
+        uint64_t p50Us = 0;             // 分位数取所在桶的上界
+        uint64_t p99Us = 0;
+        uint64_t maxUs = 0;
+    };
+
+    // 取出本周期的统计并清零; 与 record 并发时个别样本可能计入下一周期
+    Summary takeSummary() {
+        uint64_t counts[kBuckets];
+        uint64_t total = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+        count_.store(0, std::memory_order_relaxed);
+        Summary s;
+        s.count = total;
+        uint64_t sum = sum_.exchange(0, std::memory_order_relaxed);
+        s.maxUs = max_.exchange(0, std::memory_order_relaxed);
+        if (total == 0) return s;
+        s.avgUs = sum / total;
+        s.p50Us = percentile(counts, total, 50);
+        s.p99Us = percentile(counts, total, 99);
+        if (s.p50Us > s.maxUs) s.p50Us = s.maxUs;
+        if (s.p99Us > s.maxUs) s.p99Us = s.maxUs;
+        return s;
+    }
+
+    static std::string format(const Summary& s) {
+        return "count:[" + std::to_string(s.count)
+               + "] avg_us:[" + std::to_string(s.avgUs)
+               + "] p50_us:[" + std::to_string(s.p50Us)
+               + "] p99_us:[" + std::to_string(s.p99Us)
+               + "] max_us:[" + std::to_string(s.maxUs) + "]";
+    }
+
+private:
+    static uint64_t percentile(const uint64_t* counts, uint64_t total, uint64_t pct) {
+        uint64_t rank = (total * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return i ? (uint64_t(1) << i) - 1 : 0;
+        }
+        return 0;
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{ 0 };
+    std::atomic<uint64_t> sum_{ 0 };
+    std::atomic<uint64_t> max_{ 0 };
+};
+
+#endif // LATENCYHISTOGRAM_H
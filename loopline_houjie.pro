@@ -9,28 +9,50 @@ CONFIG += c++20
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    acktracker.cpp \
     dataprocess.cpp \
     jtrequest.cpp \
     logger.cpp \
     main.cpp \
     loopline_houjie.cpp \
     otherfunction.cpp \
+    parcelstate.cpp \
+    plcioengine.cpp \
     qttcpserver.cpp \
+    runtimeconfig.cpp \
+    slotscheduler.cpp \
+    spillqueue.cpp \
     sqlconnection.cpp \
-    sqlconnectionpool.cpp \
-    tcpsocketclient.cpp
+    sqlconnectionpool.cpp
 
 HEADERS += \
+    acktracker.h \
     dataprocess.h \
+    inflighttable.h \
     jtrequest.h \
+    latencyhistogram.h \
     logger.h \
     loopline_houjie.h \
+    mpsc_queue.h \
+    parcelstate.h \
+    pipelinestage.h \
+    plcframedecoder.h \
+    plcframes.h \
+    plcioengine.h \
     qttcpserver.h \
+    runtimeconfig.h \
+    scandedup.h \
+    scanparser.h \
+    simdscan.h \
+    slotscheduler.h \
+    spillqueue.h \
     spsc_ring.h \
     sqlconnection.h \
     sqlconnectionpool.h \
-    tcpsocketclient.h \
-    udpreceiver.h
+    timingwheel.h \
+    udpreceiver.h \
+    unloadparser.h \
+    waybillcode.h
 
 FORMS += \
     loopline_houjie.ui
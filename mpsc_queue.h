@@ -0,0 +1,101 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+// 有界多生产者单消费者队列 (Vyukov 有界队列, 消费端只有一个线程因此出队不需要 CAS)
+//  - 每个槽位带序号 seq: seq == pos 表示可写, seq == pos + 1 表示可读
+//  - 生产者 CAS 抢占写位置后写入槽位, 再以 release 发布 seq; 写入过程中其他生产者不受阻塞
+//  - 槽位对象在构造时创建并循环复用, 适合放定长报文, 不做堆分配
+//  - 满时 try_push 返回 false, 由调用方决定退路
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+template<typename T>
+class MpscQueue {
+public:
+    static constexpr size_t kCacheLine = 64;
+
+    explicit MpscQueue(size_t capacity) {
+        cap_ = 2;
+        while (cap_ < capacity) cap_ <<= 1;
+        mask_ = cap_ - 1;
+        cells_ = new Cell[cap_];
+        for (size_t i = 0; i < cap_; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    ~MpscQueue() {
+        delete[] cells_;
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 任意线程调用; fill(T&) 在抢到的槽位上原地写入, 满时返回 false 且不调用 fill
+    template<typename Fill>
+    bool try_push_with(Fill&& fill) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false;                                           // 满: 消费者还没取走上一圈的数据
+            }
+            else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);      // 被其他生产者抢先, 重读
+            }
+        }
+        fill(cell->data);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& item) {
+        return try_push_with([&](T& slot) { slot = item; });
+    }
+
+    // 只在消费线程调用; 按入队顺序对已发布的元素调用 fn(T&), 最多 max 个, 返回个数
+    // 遇到已占位但尚未写完的槽位即停止, 剩余元素留到下次
+    template<typename Fn>
+    size_t consume(Fn&& fn, size_t max) {
+        size_t n = 0;
+        while (n < max) {
+            Cell& cell = cells_[dequeuePos_ & mask_];
+            if (cell.seq.load(std::memory_order_acquire) != dequeuePos_ + 1) break;
+            fn(cell.data);
+            cell.seq.store(dequeuePos_ + cap_, std::memory_order_release);
+            ++dequeuePos_;
+            ++n;
+        }
+        if (n) dequeuePosShared_.store(dequeuePos_, std::memory_order_relaxed);
+        return n;
+    }
+
+    // 近似元素个数, 仅用于统计
+    size_t size_approx() const {
+        size_t e = enqueuePos_.load(std::memory_order_relaxed);
+        size_t d = dequeuePosShared_.load(std::memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+    size_t capacity() const { return cap_; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    Cell* cells_ = nullptr;
+    size_t cap_ = 0;
+    size_t mask_ = 0;
+    alignas(kCacheLine) std::atomic<size_t> enqueuePos_{ 0 };          // 生产者共享
+    alignas(kCacheLine) size_t dequeuePos_ = 0;                         // 消费者独占
+    std::atomic<size_t> dequeuePosShared_{ 0 };                         // 供统计线程读取的出队位置
+};
+
+#endif // MPSC_QUEUE_H
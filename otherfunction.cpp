@@ -7,32 +7,6 @@
 #include <chrono>
 #include <ctime>
 
-std::tuple<std::string, std::string, int> splitUdpMessage(const std::string& msg)	//单号,重量,供包台号
-{
-    std::stringstream ss(msg);
-    std::string item;
-    std::vector<std::string> parts;
-
-    while (std::getline(ss, item, ','))
-    {
-        parts.push_back(item);
-    }
-    try
-    {
-        if (parts.size() >= 3)
-        {
-            std::string code = parts[0];
-            std::string weight = parts[1];
-            int supply_id = std::stoi(parts[2]);
-            return std::make_tuple(code, weight, supply_id);
-        }
-    }
-    catch (const std::exception& e)
-    {
-        Logger::getInstance().Log("---- [Error] Function splitUdpMessage error: " + std::string(e.what()));
-    }
-    return std::make_tuple("", "", -1);
-}
 std::string currentDateTimeString()
 {
     using namespace std::chrono;
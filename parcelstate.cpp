@@ -0,0 +1,351 @@
+#include "parcelstate.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+
+ParcelStateService::ParcelStateService(int stationCount)
+    : stationCount_(std::max(1, stationCount))
+{
+}
+
+ParcelStateService::~ParcelStateService() {
+    stop();
+}
+
+int64_t ParcelStateService::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t ParcelStateService::steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t ParcelStateService::wallNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void ParcelStateService::configure(int shards, size_t queueCapacity) {
+    if (!shards_.empty()) return;
+    shardConfig_ = std::clamp(shards, 1, std::min(kMaxShards, stationCount_));       //每个分片至少一个供包台
+    queueCapacity_ = std::max<size_t>(16, queueCapacity);
+}
+
+void ParcelStateService::setOnUnloaded(UnloadedFn fn) {
+    if (!shards_.empty()) return;
+    onUnloaded_ = std::move(fn);
+}
+
+void ParcelStateService::setExpiry(int64_t ttlMs, ExpiredFn fn, size_t maxPerTick) {
+    if (!shards_.empty()) return;
+    ttlMs_ = std::max<int64_t>(0, ttlMs);
+    maxExpiryPerTick_ = maxPerTick;
+    onExpired_ = std::move(fn);
+}
+
+void ParcelStateService::start() {
+    if (running_.exchange(true)) return;
+    if (shards_.empty()) {
+        for (int i = 0; i < shardConfig_; ++i) {
+            int stations = (stationCount_ - i + shardConfig_ - 1) / shardConfig_;      //供包台 i+1, i+1+分片数, ...
+            auto shard = std::make_unique<Shard>(queueCapacity_, i, stations);
+            if (ttlMs_ > 0) {                                                   //每条记录最多一个定时器, 节点池与记录数相同
+                shard->wheel = std::make_unique<TimingWheel<ExpiryTimer>>(shard->table.capacity(), kExpiryWheelSlots, kExpiryTickMs);
+                shard->timers.assign(shard->table.capacity(), TimingWheel<ExpiryTimer>::kInvalid);
+            }
+            shards_.push_back(std::move(shard));
+        }
+        rateAtMs_ = steadyNowMs();
+    }
+    for (auto& s : shards_) {
+        Shard* shard = s.get();
+        shard->thread = std::thread([this, shard]() { run(*shard); });
+    }
+    accepting_.store(true, std::memory_order_seq_cst);
+    size_t tableBytes = 0;
+    for (auto& s : shards_) tableBytes += s->table.bytes();
+    if (ttlMs_ > 0) ticker_ = std::thread(&ParcelStateService::runTicker, this);
+    Logger::getInstance().Log("----[ParcelStateService] start() shards: [" + std::to_string(shards_.size()) + "] queue: [" + std::to_string(queueCapacity_)
+                              + "] table_kb: [" + std::to_string(tableBytes / 1024) + "] ttl_s: [" + std::to_string(ttlMs_ / 1000) + "]");
+}
+
+void ParcelStateService::stop() {
+    if (!running_.load(std::memory_order_acquire)) return;
+    {
+        std::lock_guard<std::mutex> lk(tickMutex_);
+        accepting_.store(false, std::memory_order_seq_cst);
+    }
+    tickCv_.notify_all();
+    if (ticker_.joinable()) ticker_.join();
+    while (callers_.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();     //已入队的操作由分片线程处理完
+    running_.store(false, std::memory_order_release);
+    for (auto& s : shards_) {
+        s->wakeSeq.fetch_add(1, std::memory_order_release);
+        s->wakeSeq.notify_all();
+    }
+    for (auto& s : shards_) {
+        if (s->thread.joinable()) s->thread.join();
+    }
+}
+
+bool ParcelStateService::enter() {
+    callers_.fetch_add(1, std::memory_order_seq_cst);
+    if (accepting_.load(std::memory_order_seq_cst)) return true;
+    callers_.fetch_sub(1, std::memory_order_seq_cst);
+    return false;
+}
+
+void ParcelStateService::leave() {
+    callers_.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void ParcelStateService::submit(Shard& s, const Op& op) {
+    if (!s.queue.try_push(op)) {
+        s.queueFull.fetch_add(1, std::memory_order_relaxed);
+        do { std::this_thread::yield(); } while (!s.queue.try_push(op));       //分片线程在 stop() 等待调用结束前不会退出
+    }
+    wake(s);
+}
+
+void ParcelStateService::wake(Shard& s) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);                        //与 run() 中的 fence 配对
+    if (s.idle.load(std::memory_order_relaxed)) {
+        s.wakeSeq.fetch_add(1, std::memory_order_release);
+        s.wakeSeq.notify_one();
+    }
+}
+
+void ParcelStateService::await(const Reply& reply, int64_t startUs) {
+    for (;;) {
+        uint8_t st = reply.state.load(std::memory_order_acquire);
+        if (st == Reply::Released) break;
+        if (st == Reply::Pending) reply.state.wait(Reply::Pending, std::memory_order_acquire);
+        else std::this_thread::yield();                                         //分片线程正在 notify, 随后即释放
+    }
+    roundTrip_.record(nowUs() - startUs);
+}
+
+void ParcelStateService::complete(Reply& reply) {                               //notify 之后才允许调用方返回, 避免唤醒已销毁的栈上对象
+    reply.state.store(Reply::Notifying, std::memory_order_release);
+    reply.state.notify_one();
+    reply.state.store(Reply::Released, std::memory_order_release);
+}
+
+bool ParcelStateService::record(const WaybillCode& code, int station, int order, int32_t weightGrams, int64_t rxNs) {
+    if (code.empty() || station < 1 || station > stationCount_ || order < 1 || order > kMaxOrder) return false;
+    if (!enter()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Op op;
+    op.type = OpType::Record;
+    op.code = code;
+    op.station = localStation(station);
+    op.order = order;
+    op.weightGrams = weightGrams;
+    op.rxNs = rxNs;
+    submit(*shards_[shardOf(station)], op);
+    leave();
+    return true;
+}
+
+ParcelStateService::SlotAssignment ParcelStateService::assignSlot(const WaybillCode& code, int slot, int station) {
+    if (code.empty() || !enter()) return SlotAssignment();
+    int64_t start = nowUs();
+    size_t first = 0;
+    size_t count = shards_.size();
+    if (station >= 1 && station <= stationCount_) {                             //已知供包台, 只查一个分片
+        first = shardOf(station);
+        count = 1;
+    }
+    Reply replies[kMaxShards];
+    Op op;
+    op.type = OpType::AssignSlot;
+    op.code = code;
+    op.slot = slot;
+    for (size_t i = 0; i < count; ++i) {                                        //先全部投递, 各分片并行查找
+        op.reply = &replies[i];
+        submit(*shards_[first + i], op);
+    }
+    const Reply* best = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        await(replies[i], start);
+        if (replies[i].recordNs > 0 && (!best || replies[i].recordNs > best->recordNs)) best = &replies[i];
+    }
+    leave();
+    return best ? best->assign : SlotAssignment();
+}
+
+bool ParcelStateService::submitUnload(const UnloadRecord& rec) {
+    if (!rec.hasKey() || rec.station > stationCount_ || rec.order > kMaxOrder || !enter()) return false;
+    Shard& s = *shards_[shardOf(rec.station)];
+    if (!s.unloads.try_push(rec)) {
+        s.queueFull.fetch_add(1, std::memory_order_relaxed);
+        do { std::this_thread::yield(); } while (!s.unloads.try_push(rec));    //分片线程在 stop() 等待调用结束前不会退出
+    }
+    wake(s);
+    leave();
+    return true;
+}
+
+ParcelStateService::ShardStats ParcelStateService::shardStats(int shard) const {
+    ShardStats st;
+    if (shard < 0 || shard >= static_cast<int>(shards_.size())) return st;
+    const Shard& s = *shards_[shard];
+    st.ops = s.ops.load(std::memory_order_relaxed);
+    st.queueFull = s.queueFull.load(std::memory_order_relaxed);
+    st.queued = s.queue.size_approx() + s.unloads.size_approx();
+    st.parcels = s.parcels.load(std::memory_order_relaxed);
+    st.pendingSlots = s.pendingSlots.load(std::memory_order_relaxed);
+    st.assigned = s.assigned.load(std::memory_order_relaxed);
+    st.reused = s.reused.load(std::memory_order_relaxed);
+    st.expired = s.expired.load(std::memory_order_relaxed);
+    st.expiryDeferred = s.expiryDeferred.load(std::memory_order_relaxed);
+    return st;
+}
+
+uint64_t ParcelStateService::expired() const {
+    uint64_t n = 0;
+    for (const auto& s : shards_) n += s->expired.load(std::memory_order_relaxed);
+    return n;
+}
+
+double ParcelStateService::takeExpiredPerMinute() {
+    int64_t now = steadyNowMs();
+    uint64_t total = expired();
+    double minutes = static_cast<double>(now - rateAtMs_) / 60000.0;
+    double rate = minutes > 0 ? static_cast<double>(total - expiredAtRate_) / minutes : 0.0;
+    expiredAtRate_ = total;
+    rateAtMs_ = now;
+    return rate;
+}
+
+void ParcelStateService::runTicker() {                                          //定时向各分片投递时间轮推进操作, 上一个未处理时不重复投递
+    std::unique_lock<std::mutex> lk(tickMutex_);
+    while (!tickCv_.wait_for(lk, std::chrono::milliseconds(kExpiryTickMs), [this] { return !accepting_.load(std::memory_order_acquire); })) {
+        if (!enter()) break;
+        for (auto& s : shards_) {
+            if (s->tickQueued.exchange(true, std::memory_order_acq_rel)) continue;
+            Op op;
+            op.type = OpType::Tick;
+            submit(*s, op);
+        }
+        leave();
+    }
+}
+
+void ParcelStateService::run(Shard& s) {
+    const size_t BATCH = 256;
+    auto handle = [this, &s](Op& op) { apply(s, op); };
+    auto handleUnload = [this, &s](UnloadRecord& rec) { unload(s, rec); };
+    auto drain = [&]() { return s.queue.consume(handle, BATCH) + s.unloads.consume(handleUnload, BATCH); };
+    auto publish = [&s]() {
+        s.parcels.store(s.table.live(), std::memory_order_relaxed);
+        s.pendingSlots.store(s.table.pending(), std::memory_order_relaxed);
+        s.assigned.store(s.table.assigned(), std::memory_order_relaxed);
+        s.reused.store(s.table.reused(), std::memory_order_relaxed);
+    };
+    while (running_.load(std::memory_order_acquire)) {
+        if (drain()) {
+            publish();
+            continue;
+        }
+        s.idle.store(true, std::memory_order_relaxed);
+        uint32_t seq = s.wakeSeq.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);                    //与 submit() 中的 fence 配对
+        size_t n = drain();
+        if (n == 0 && running_.load(std::memory_order_acquire)) s.wakeSeq.wait(seq, std::memory_order_acquire);
+        s.idle.store(false, std::memory_order_relaxed);
+        if (n) publish();
+    }
+    while (drain()) {}
+    publish();
+}
+
+void ParcelStateService::cancelTimer(Shard& s, InflightTable::Parcel& p) {
+    if (!s.wheel) return;
+    int32_t& h = s.timers[s.table.indexOf(p)];
+    s.wheel->cancel(h);
+    h = TimingWheel<ExpiryTimer>::kInvalid;
+}
+
+void ParcelStateService::expire(Shard& s, const ExpiryTimer& timer) {
+    s.timers[timer.rec] = TimingWheel<ExpiryTimer>::kInvalid;
+    InflightTable::Parcel& p = s.table.atIndex(timer.rec);
+    if (!p.has(InflightTable::Parcel::Live) || p.generation != timer.generation) return;
+    if (maxExpiryPerTick_ > 0 && s.expiredThisTick >= maxExpiryPerTick_) {        //本次推进已到上限, 顺延一个 tick, 节点刚释放, 不会因池满失败
+        s.timers[timer.rec] = s.wheel->schedule(steadyNowMs(), kExpiryTickMs, timer);
+        s.expiryDeferred.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ++s.expiredThisTick;
+    ExpiredParcel e;
+    e.code = p.waybill();
+    e.station = globalStation(s, s.table.stationOf(p));
+    e.order = s.table.orderOf(p);
+    e.weightGrams = p.weightGrams;
+    e.hasSlot = p.has(InflightTable::Parcel::HasSlot);
+    e.slot = p.slot;
+    e.scanNs = p.scanNs;
+    e.ageMs = p.scanNs > 0 ? (wallNowNs() - p.scanNs) / 1000000 : ttlMs_;
+    if (onExpired_) {
+        try { onExpired_(e); }
+        catch (...) {}
+    }
+    s.table.erase(p);
+    s.expired.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ParcelStateService::apply(Shard& s, Op& op) {
+    s.ops.fetch_add(1, std::memory_order_relaxed);
+    InflightTable& t = s.table;
+    switch (op.type) {
+    case OpType::Record:
+        if (InflightTable::Parcel* old = t.at(op.station, op.order)) cancelTimer(s, *old);          //被覆盖的旧记录不再回收
+        if (InflightTable::Parcel* p = t.insert(op.station, op.order, op.code, op.weightGrams, op.rxNs)) {     //序列号键对应单号, 单号索引指向该记录
+            if (s.wheel) s.timers[t.indexOf(*p)] = s.wheel->schedule(steadyNowMs(), ttlMs_, ExpiryTimer{ t.indexOf(*p), p->generation });
+        }
+        break;
+    case OpType::Tick: {
+        s.tickQueued.store(false, std::memory_order_release);
+        s.expiredThisTick = 0;
+        if (s.wheel) s.wheel->advance(steadyNowMs(), [this, &s](const ExpiryTimer& timer) { expire(s, timer); });
+        break;
+    }
+    case OpType::AssignSlot: {
+        Reply& r = *op.reply;
+        if (InflightTable::Parcel* p = t.find(op.code)) {
+            int station = globalStation(s, t.stationOf(*p));
+            r.recordNs = std::max<int64_t>(1, p->scanNs);
+            if (t.takeKey(*p)) {                                                    //序列号只取一次, 重复的格口结果走数据库
+                r.assign.found = true;
+                r.assign.station = station;
+                r.assign.order = t.orderOf(*p);
+            }
+            int64_t scanNs = t.takeScan(*p);
+            if (scanNs) r.assign.scan = ScanTime{ scanNs, station };
+            t.setSlot(*p, op.slot, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());   //供下件时查找格口号
+        }
+        complete(r);
+        break;
+    }
+    }
+}
+
+void ParcelStateService::unload(Shard& s, const UnloadRecord& rec) {           //本分片的序列号键直接按下标取出, 不经过目录和应答
+    s.ops.fetch_add(1, std::memory_order_relaxed);
+    UnloadLookup r;
+    InflightTable::Parcel* p = s.table.at(localStation(rec.station), rec.order);
+    if (p && p->has(InflightTable::Parcel::Live)) {
+        r.found = true;
+        r.code = p->waybill();
+        r.weightGrams = p->weightGrams;
+        r.hasSlot = p->has(InflightTable::Parcel::HasSlot);
+        r.slot = p->slot;
+        cancelTimer(s, *p);
+        s.table.erase(*p);                                                          //包裹已下件, 清除
+    }
+    if (onUnloaded_) {
+        try { onUnloaded_(rec, r); }
+        catch (...) {}
+    }
+}
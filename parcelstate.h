@@ -0,0 +1,199 @@
+#ifndef PARCELSTATE_H
+#define PARCELSTATE_H
+
+// 包裹在线体上的状态: 序列号键 <-> 单号, 单号 -> 格口/重量/读码时间; 按供包台分片, 供包台 s 属于分片 (s-1) % 分片数
+// 每个分片的 InflightTable 只容纳本分片供包台的序列号键, 各分片合起来才是 台数 x 9999 条, 只由该分片自己的线程读写
+// record() 写入分片的无锁 MPSC 队列, 只入队不等待; 下件由下件线程经 submitUnload() 写入分片的 SPSC 下件队列,
+// 分片线程直接按下标在本分片的表中取出记录并回调 onUnloaded, 下件线程不等待, 不查目录
+// assignSlot() 只有单号, 给出供包台时只投递到该分片, 否则投递到全部分片, 在调用线程等待各分片返回结果;
+// 同一单号在不同供包台重复读码时各分片都有记录, 取读码时间最新的一条
+// 队列满时调用方让出 CPU 等待空位, 状态操作不丢弃; 未启动时 record()/submitUnload() 返回 false, 查询返回空结果
+// 超时回收: 每条记录读码时在分片的时间轮上登记, 超过 TTL 仍未下件(掉落、未读出、漏下件)的包裹经 onExpired 回调后删除
+// 时间轮由 tick 线程定时向各分片投递推进操作, 回调在分片线程执行, 不能阻塞; 每个分片每次推进最多回收 maxPerTick 条,
+// 超出的顺延到下一次推进, 批量到期(如停线后恢复)时不会一次性压给下游
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "mpsc_queue.h"
+#include "latencyhistogram.h"
+#include "inflighttable.h"
+#include "timingwheel.h"
+#include "waybillcode.h"
+#include "spsc_ring.h"
+#include "unloadparser.h"
+
+class ParcelStateService {
+public:
+    static constexpr size_t kMaxCode = WaybillCode::kMaxLen;         // 与 ScanRecord::kMaxCode 一致
+    static constexpr int kMaxOrder = 9999;          // 供包台序列号上限
+    static constexpr int kMaxShards = 16;           // 分片数上限, 同时不超过供包台数
+    static constexpr int64_t kExpiryTickMs = 1000;  // 超时回收的时间粒度
+    static constexpr size_t kExpiryWheelSlots = 3600;   // 时间轮一圈一小时, 更长的 TTL 按圈数计
+
+    struct ScanTime {                               // 读码时间, 发送格口时计算读码到格口下发的延时
+        int64_t rxNs = 0;
+        int stationId = 0;
+    };
+    struct SlotAssignment {                         // assignSlot() 的结果
+        bool found = false;                         // 单号对应的序列号还在内存中
+        int station = -1;
+        int order = -1;
+        ScanTime scan;                              // 已取出的读码时间, 重发或读码时间未知时为空
+    };
+    struct UnloadLookup {                           // onUnloaded 回调参数
+        bool found = false;                         // 序列号键对应的单号还在内存中
+        WaybillCode code;
+        int32_t weightGrams = -1;                   // 读码时的重量(克)
+        bool hasSlot = false;                       // 已记录格口号
+        int slot = -1;
+    };
+    struct ShardStats {
+        uint64_t ops = 0;                           // 已执行的操作数
+        uint64_t queueFull = 0;                     // 入队时队列已满的次数
+        size_t queued = 0;                          // 排队中的操作数
+        size_t parcels = 0;                         // 在线体上的包裹数
+        size_t pendingSlots = 0;                    // 等待格口的包裹数
+        size_t assigned = 0;                        // 已确定格口、等待下件的包裹数
+        uint64_t reused = 0;                        // 未下件即被循环的序列号覆盖的包裹数
+        uint64_t expired = 0;                       // 超时回收的包裹数
+        uint64_t expiryDeferred = 0;                // 超过每次推进的回收上限, 顺延到下一次推进的次数
+    };
+    struct ExpiredParcel {                          // onExpired 回调参数
+        WaybillCode code;
+        int station = 0;
+        int order = 0;
+        int32_t weightGrams = -1;
+        bool hasSlot = false;                       // 已下发格口(等待下件时超时), 否则为未取得格口
+        int slot = -1;
+        int64_t scanNs = 0;                         // 读码时间
+        int64_t ageMs = 0;                          // 读码到回收的时间
+    };
+    using ExpiredFn = std::function<void(const ExpiredParcel& parcel)>;
+    using UnloadedFn = std::function<void(const UnloadRecord& rec, const UnloadLookup& parcel)>;
+
+    explicit ParcelStateService(int stationCount);
+    ~ParcelStateService();
+    ParcelStateService(const ParcelStateService&) = delete;
+    ParcelStateService& operator=(const ParcelStateService&) = delete;
+
+    // 第一次 start() 之前设置, 之后分片数不再改变(各分片的表在停止后保留)
+    void configure(int shards, size_t queueCapacity);
+    // 第一次 start() 之前设置; 在分片线程回调, 不能阻塞
+    void setOnUnloaded(UnloadedFn fn);
+    // 第一次 start() 之前设置; ttlMs <= 0 为不回收, maxPerTick 为 0 时不限制每次推进的回收条数
+    void setExpiry(int64_t ttlMs, ExpiredFn fn, size_t maxPerTick = 0);
+    void start();
+    void stop();                                    // 等待进行中的调用完成后停止分片线程
+    bool running() const { return accepting_.load(std::memory_order_acquire); }
+
+    // 读码: 记录序列号键与单号的对应关系及读码时间, 不等待
+    bool record(const WaybillCode& code, int station, int order, int32_t weightGrams, int64_t rxNs);
+    // 格口已确定: 记录单号对应的格口, 取出(删除)单号对应的序列号和读码时间; station > 0 时只查该供包台所在分片
+    SlotAssignment assignSlot(const WaybillCode& code, int slot, int station = 0);
+    // 下件: 由分片线程取出(删除)序列号键对应的单号、重量及格口后回调 onUnloaded, 不等待;
+    // 只能由一个线程(下件线程)调用, 分片下件队列满时等待空位; 键不合法或未启动时返回 false, 不回调
+    bool submitUnload(const UnloadRecord& rec);
+
+    int shardCount() const { return static_cast<int>(shards_.size()); }
+    ShardStats shardStats(int shard) const;
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    LatencyHistogram::Summary takeRoundTrip() { return roundTrip_.takeSummary(); }     // assignSlot/takeUnload 的等待时间
+    uint64_t expired() const;                                                           // 各分片超时回收的总数
+    double takeExpiredPerMinute();                                                      // 距上次调用的回收速率(条/分钟), 只在统计线程调用
+
+private:
+    enum class OpType : uint8_t { Record, AssignSlot, Tick };
+    struct Reply {
+        enum State : uint8_t { Pending, Notifying, Released };
+        std::atomic<uint8_t> state{ Pending };
+        SlotAssignment assign;
+        int64_t recordNs = 0;                       // 找到的记录的读码时间, 多个分片都找到时取最新的
+    };
+    struct Op {                                     // 队列槽位, 定长, 不做堆分配
+        OpType type = OpType::Record;
+        WaybillCode code;                           // 内联存储, 哈希已算好
+        int station = 0;
+        int order = 0;
+        int slot = -1;
+        int32_t weightGrams = -1;
+        int64_t rxNs = 0;
+        Reply* reply = nullptr;
+    };
+    struct ExpiryTimer {
+        uint32_t rec;                               // InflightTable 记录下标
+        uint32_t generation;                        // 登记时的代数, 记录已被覆盖时忽略
+    };
+    struct Shard {
+        Shard(size_t capacity, int index, int stations) : queue(capacity), unloads(capacity), table(stations, kMaxOrder), index(index) {
+            unloads.set_wait_strategy(RingWaitStrategy::BusySpin);        //分片线程自己等待, ring 只用作队列, 发布时不做 fence
+        }
+        MpscQueue<Op> queue;
+        SpscRing<UnloadRecord> unloads;                     //下件线程写入, 分片线程取出
+        std::thread thread;
+        alignas(64) std::atomic<bool> idle{ false };        // 分片线程处于空闲等待
+        std::atomic<uint32_t> wakeSeq{ 0 };
+        std::atomic<uint64_t> ops{ 0 };
+        std::atomic<uint64_t> queueFull{ 0 };
+        std::atomic<size_t> parcels{ 0 };
+        std::atomic<size_t> pendingSlots{ 0 };
+        std::atomic<size_t> assigned{ 0 };
+        std::atomic<uint64_t> reused{ 0 };
+        std::atomic<uint64_t> expired{ 0 };
+        std::atomic<uint64_t> expiryDeferred{ 0 };
+        std::atomic<bool> tickQueued{ false };              //已有推进操作在队列中
+        size_t expiredThisTick = 0;                         //本次推进已回收的条数, 只在分片线程访问
+        InflightTable table;                                //只在分片线程访问, 供包台为分片内编号
+        int index;
+        std::unique_ptr<TimingWheel<ExpiryTimer>> wheel;    //未启用回收时为空
+        std::vector<int32_t> timers;                        //各记录的定时器句柄, 下标同 InflightTable
+    };
+
+    size_t shardOf(int station) const { return static_cast<size_t>(station - 1) % shards_.size(); }
+    int localStation(int station) const { return (station - 1) / static_cast<int>(shards_.size()) + 1; }
+    int globalStation(const Shard& s, int local) const { return (local - 1) * static_cast<int>(shards_.size()) + s.index + 1; }
+    bool enter();                                   // 登记一次调用, 已停止时返回 false
+    void leave();
+    void submit(Shard& s, const Op& op);
+    static void wake(Shard& s);
+    void await(const Reply& reply, int64_t startUs);
+    static void complete(Reply& reply);
+    static int64_t nowUs();
+    void run(Shard& s);
+    void apply(Shard& s, Op& op);
+    void unload(Shard& s, const UnloadRecord& rec);
+    void cancelTimer(Shard& s, InflightTable::Parcel& p);
+    void expire(Shard& s, const ExpiryTimer& timer);
+    void runTicker();
+    static int64_t steadyNowMs();
+    static int64_t wallNowNs();
+
+    int stationCount_;
+    int shardConfig_ = 2;
+    size_t queueCapacity_ = 4096;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> accepting_{ false };                    // 接受新的调用
+    std::atomic<bool> running_{ false };                      // 分片线程运行中
+    std::atomic<int> callers_{ 0 };                           // 进行中的调用数, stop() 等待其归零
+    std::atomic<uint64_t> dropped_{ 0 };
+    LatencyHistogram roundTrip_;
+    int64_t ttlMs_ = 0;
+    size_t maxExpiryPerTick_ = 0;
+    ExpiredFn onExpired_;
+    UnloadedFn onUnloaded_;
+    std::thread ticker_;
+    std::mutex tickMutex_;
+    std::condition_variable tickCv_;
+    uint64_t expiredAtRate_ = 0;                              //takeExpiredPerMinute 上次调用时的值
+    int64_t rateAtMs_ = 0;
+};
+
+#endif // PARCELSTATE_H
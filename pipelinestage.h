@@ -0,0 +1,216 @@
+#ifndef PIPELINESTAGE_H
+#define PIPELINESTAGE_H
+
+// 包裹处理流水线的一级: 有界队列 + 固定数量的工作线程, 取代直接投递到全局线程池的 QtConcurrent::run
+// 队列满时 push() 阻塞等待(背压传回上游的 ring/溢出文件), tryPush() 立即返回 false; 两种情况都计入 backpressure
+// post() 不阻塞: 队列满后继续排入溢出区(上限 overflow 条, 计入 overflowed), 溢出区也满才拒绝;
+// 读码/下件/格口结果等不能等待数据库和接口的线程使用 post()
+// 统计: 当前/最大队列深度, 排队时间, 处理时间, push 被阻塞的时间
+// stop() 处理完队列中剩余的任务后再退出, 停止期间及停止后的 push 返回 false; 停止后可以再次 start()
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "latencyhistogram.h"
+#include "logger.h"
+
+template<typename T>
+class PipelineStage {
+public:
+    using Handler = std::function<void(T&)>;
+
+    struct Stats {
+        size_t depth = 0;               // 当前排队数
+        size_t maxDepth = 0;            // 本周期最大排队数, 读取后清零
+        uint64_t pushed = 0;
+        uint64_t processed = 0;
+        uint64_t errors = 0;            // 处理函数抛出异常的次数
+        uint64_t backpressure = 0;      // push 时队列已满的次数
+        uint64_t rejected = 0;          // 未运行, tryPush 队列满或 post 溢出区满, 未入队的次数
+        uint64_t overflowed = 0;        // post 时队列已满, 排入溢出区的次数
+    };
+
+    PipelineStage(const std::string& name, size_t capacity, int workers)
+        : name_(name), capacity_(std::max<size_t>(1, capacity)), workers_(std::max(1, workers)) {}
+    ~PipelineStage() { stop(); }
+    PipelineStage(const PipelineStage&) = delete;
+    PipelineStage& operator=(const PipelineStage&) = delete;
+
+    // 在 start() 之前调整, 运行中调用无效
+    void configure(size_t capacity, int workers, size_t overflow = 0) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (running_) return;
+        capacity_ = std::max<size_t>(1, capacity);
+        workers_ = std::max(1, workers);
+        overflow_ = overflow;
+    }
+
+    void start(Handler handler) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (running_ || !threads_.empty()) return;
+        handler_ = std::move(handler);
+        running_ = true;
+        for (int i = 0; i < workers_; ++i) threads_.emplace_back(&PipelineStage::run, this);
+        Logger::getInstance().Log("----[PipelineStage] start() [" + name_ + "] workers: [" + std::to_string(workers_) + "] capacity: [" + std::to_string(capacity_) + "]");
+    }
+
+    void stop() {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            running_ = false;
+            threads.swap(threads_);
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+        for (std::thread& t : threads) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    // 队列满时阻塞到有空位, 未运行时返回 false
+    bool push(T item) {
+        int64_t start = 0;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            if (running_ && queue_.size() >= capacity_) {
+                backpressure_.fetch_add(1, std::memory_order_relaxed);
+                start = nowUs();
+                notFull_.wait(lk, [this] { return !running_ || queue_.size() < capacity_; });
+            }
+            if (!running_) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            enqueueLocked(std::move(item));
+        }
+        if (start) blocked_.record(nowUs() - start);
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // 队列满或未运行时立即返回 false, item 不变
+    bool tryPush(T& item) {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (!running_ || queue_.size() >= capacity_) {
+                if (running_) backpressure_.fetch_add(1, std::memory_order_relaxed);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            enqueueLocked(std::move(item));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // 不阻塞; 队列满时排入溢出区, 溢出区也满或未运行时返回 false
+    bool post(T item) {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (!running_ || queue_.size() >= capacity_ + overflow_) {
+                if (running_) backpressure_.fetch_add(1, std::memory_order_relaxed);
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (queue_.size() >= capacity_) overflowed_.fetch_add(1, std::memory_order_relaxed);
+            enqueueLocked(std::move(item));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    const std::string& name() const { return name_; }
+
+    Stats stats() {
+        Stats s;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            s.depth = queue_.size();
+            s.maxDepth = maxDepth_;
+            maxDepth_ = queue_.size();
+        }
+        s.pushed = pushed_.load(std::memory_order_relaxed);
+        s.processed = processed_.load(std::memory_order_relaxed);
+        s.errors = errors_.load(std::memory_order_relaxed);
+        s.backpressure = backpressure_.load(std::memory_order_relaxed);
+        s.rejected = rejected_.load(std::memory_order_relaxed);
+        s.overflowed = overflowed_.load(std::memory_order_relaxed);
+        return s;
+    }
+    LatencyHistogram::Summary takeQueueWait() { return queueWait_.takeSummary(); }      // 入队到开始处理
+    LatencyHistogram::Summary takeService() { return service_.takeSummary(); }          // 处理函数耗时
+    LatencyHistogram::Summary takeBlocked() { return blocked_.takeSummary(); }          // push 因队列满等待的时间
+
+private:
+    struct Entry {
+        T item;
+        int64_t enqUs;
+    };
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void enqueueLocked(T&& item) {
+        queue_.push_back(Entry{ std::move(item), nowUs() });
+        maxDepth_ = std::max(maxDepth_, queue_.size());
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run() {
+        while (true) {
+            Entry e;
+            {
+                std::unique_lock<std::mutex> lk(mutex_);
+                notEmpty_.wait(lk, [this] { return !queue_.empty() || !running_; });
+                if (queue_.empty()) return;                             //已停止且队列处理完
+                e = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            notFull_.notify_one();
+            int64_t begin = nowUs();
+            queueWait_.record(begin - e.enqUs);
+            try {
+                handler_(e.item);
+            }
+            catch (...) {
+                errors_.fetch_add(1, std::memory_order_relaxed);
+            }
+            service_.record(nowUs() - begin);
+            processed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::string name_;
+    size_t capacity_;
+    int workers_;
+    size_t overflow_ = 0;                       // post() 在队列满后还能排入的条数
+    Handler handler_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<Entry> queue_;                   // 由 mutex_ 保护
+    size_t maxDepth_ = 0;                       // 由 mutex_ 保护
+    bool running_ = false;                      // 由 mutex_ 保护
+    std::vector<std::thread> threads_;
+    std::atomic<uint64_t> pushed_{ 0 };
+    std::atomic<uint64_t> processed_{ 0 };
+    std::atomic<uint64_t> errors_{ 0 };
+    std::atomic<uint64_t> backpressure_{ 0 };
+    std::atomic<uint64_t> rejected_{ 0 };
+    std::atomic<uint64_t> overflowed_{ 0 };
+    LatencyHistogram queueWait_;
+    LatencyHistogram service_;
+    LatencyHistogram blocked_;
+};
+
+#endif // PIPELINESTAGE_H
@@ -0,0 +1,161 @@
+#ifndef PLCFRAMEDECODER_H
+#define PLCFRAMEDECODER_H
+
+// PLC 报文流式切分: 报文以 '#' 结尾, 例如 "SU213D04ID0001G2008#", "AKD01ID000100000#"
+// TCP 会把报文合并或拆开, 解码器保存跨次读取的半帧, 凑齐后再输出
+// 完整落在本次输入中的帧直接以 string_view 指向输入数据, 跨读取拼接的帧指向内部固定缓冲区, 不做堆分配
+// 超过 kMaxFrame 的帧丢弃到下一个 '#' 为止并计数; 每个连接一个实例, feed/reset 只在该连接的接收线程调用
+// 可选的重发检测: 窗口内出现过相同内容的帧计为 PLC 重发(PLC 未收到回复时会原样重发), 帧仍照常输出
+// 最近的帧按内容哈希记录在直接映射表中, 哈希冲突只会漏计, 不会误计不同内容的帧
+
+#include <string_view>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <cstddef>
+#include "simdscan.h"
+
+enum class PlcFrameKind {
+    Unknown = 0,
+    Unload,             // SU 正常下件
+    UnloadFail,         // FA 下件失败
+    Ack,                // AK 上件回复
+    SlotCommand,        // GK 格口下发
+    Supply,             // STD 上件
+};
+
+inline PlcFrameKind classifyPlcFrame(std::string_view f) {
+    if (f.size() < 2) return PlcFrameKind::Unknown;
+    if (f[0] == 'S' && f[1] == 'U') return PlcFrameKind::Unload;
+    if (f[0] == 'F' && f[1] == 'A') return PlcFrameKind::UnloadFail;
+    if (f[0] == 'A' && f[1] == 'K') return PlcFrameKind::Ack;
+    if (f[0] == 'G' && f[1] == 'K') return PlcFrameKind::SlotCommand;
+    if (f.size() >= 3 && f[0] == 'S' && f[1] == 'T' && f[2] == 'D') return PlcFrameKind::Supply;
+    return PlcFrameKind::Unknown;
+}
+
+inline const char* plcFrameKindName(PlcFrameKind k) {
+    switch (k) {
+    case PlcFrameKind::Unknown: return "unknown";
+    case PlcFrameKind::Unload: return "SU";
+    case PlcFrameKind::UnloadFail: return "FA";
+    case PlcFrameKind::Ack: return "AK";
+    case PlcFrameKind::SlotCommand: return "GK";
+    case PlcFrameKind::Supply: return "STD";
+    }
+    return "unknown";
+}
+
+class PlcFrameDecoder {
+public:
+    static constexpr size_t kMaxFrame = 128;            // 不含 '#'
+
+    // 输入一段接收数据, 每个完整帧(不含 '#', 去掉开头的空白和换行)调用一次 onFrame(std::string_view)
+    template<typename Fn>
+    void feed(const char* p, size_t n, Fn&& onFrame) {
+        while (n > 0) {
+            size_t hit = simdscan::find(p, n, '#');
+            if (hit == n) {                             // 本次数据没有结束符, 保存半帧
+                if (discarding_) return;
+                if (len_ == 0) {                        // 帧间的换行不算半帧
+                    while (n > 0 && (*p == '\r' || *p == '\n' || *p == ' ')) { ++p; --n; }
+                    if (n == 0) return;
+                }
+                if (len_ + n > kMaxFrame) {
+                    bump(oversized_);
+                    discarding_ = true;
+                    len_ = 0;
+                    return;
+                }
+                std::memcpy(buf_ + len_, p, n);
+                len_ += n;
+                return;
+            }
+            if (discarding_) {                          // 超长帧的剩余部分
+                discarding_ = false;
+            }
+            else if (len_ > 0) {                        // 与上次保存的半帧拼接
+                if (len_ + hit > kMaxFrame) {
+                    bump(oversized_);
+                }
+                else {
+                    std::memcpy(buf_ + len_, p, hit);
+                    bump(reassembled_);
+                    deliver(std::string_view(buf_, len_ + hit), onFrame);
+                }
+                len_ = 0;
+            }
+            else if (hit > kMaxFrame) {
+                bump(oversized_);
+            }
+            else {
+                deliver(std::string_view(p, hit), onFrame);
+            }
+            p += hit + 1;
+            n -= hit + 1;
+        }
+    }
+
+    // 打开重发检测, windowMs 为 0 时关闭; 在开始接收之前设置
+    void setRepeatWindowMs(int windowMs) { repeatWindowMs_ = windowMs > 0 ? windowMs : 0; }
+    // 当前输出的帧是否判定为重发, 只在 onFrame 回调中有效
+    bool lastRepeated() const { return lastRepeated_; }
+
+    // 连接断开/重连时丢弃未完成的半帧; 最近帧记录保留, 重连后 PLC 重发的帧同样计数
+    void reset() {
+        len_ = 0;
+        discarding_ = false;
+    }
+
+    // 计数只由接收线程写, 统计线程可随时读
+    uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+    uint64_t reassembled() const { return reassembled_.load(std::memory_order_relaxed); }     // 跨读取拼接的帧数
+    uint64_t oversized() const { return oversized_.load(std::memory_order_relaxed); }         // 超长丢弃的帧数
+    uint64_t repeats() const { return repeats_.load(std::memory_order_relaxed); }             // 判定为 PLC 重发的帧数
+
+private:
+    static void bump(std::atomic<uint64_t>& c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    template<typename Fn>
+    void deliver(std::string_view f, Fn& onFrame) {
+        size_t b = 0;
+        while (b < f.size() && (f[b] == '\r' || f[b] == '\n' || f[b] == ' ')) ++b;
+        if (b == f.size()) return;                      // 空帧, 如 "##"
+        bump(frames_);
+        f = f.substr(b);
+        lastRepeated_ = repeatWindowMs_ > 0 && checkRepeat(f);
+        if (lastRepeated_) bump(repeats_);
+        onFrame(f);
+    }
+
+    bool checkRepeat(std::string_view f) {
+        uint64_t h = 1469598103934665603ull;            // FNV-1a
+        for (char c : f) h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        Recent& r = recent_[h >> (64 - kRecentBits)];          // FNV 低位区分度差, 用高位做下标
+        bool hit = r.hash == h && r.atMs != 0 && nowMs - r.atMs <= repeatWindowMs_;
+        r = Recent{ h, nowMs };
+        return hit;
+    }
+
+    static constexpr int kRecentBits = 10;
+    static constexpr size_t kRecent = size_t(1) << kRecentBits;
+    struct Recent {
+        uint64_t hash = 0;
+        int64_t atMs = 0;
+    };
+
+    char buf_[kMaxFrame];
+    size_t len_ = 0;
+    bool discarding_ = false;
+    std::atomic<uint64_t> frames_{ 0 };
+    std::atomic<uint64_t> reassembled_{ 0 };
+    std::atomic<uint64_t> oversized_{ 0 };
+    std::atomic<uint64_t> repeats_{ 0 };
+    int repeatWindowMs_ = 0;
+    bool lastRepeated_ = false;
+    Recent recent_[kRecent];
+};
+
+#endif // PLCFRAMEDECODER_H
@@ -0,0 +1,191 @@
+#ifndef PLCFRAMES_H
+#define PLCFRAMES_H
+
+// PLC 报文格式描述与编解码: 每种报文用 constexpr 字段表描述, 编码和解码共用同一份描述
+//  STD 上件   "STD" 台2 "ID" 序4 "00000"           例 STD01ID000100000
+//  GK  格口   "GK" "D" 台2 "ID" 序4 "G" 格口       例 GKD01ID0001G12
+//  序列号键   "D" 台2 "ID" 序4                     例 D01ID0001
+//  下件/回复  ("SU"|"FA") 小车3 "D" 台2 "ID" 序4 "G" 格口   例 SU213D04ID0001G2008, 回复为原帧
+// 编码写入栈上固定缓冲区, 数字用 to_chars 输出并按位宽补 0; 不做堆分配, 不依赖 locale
+// 报文不含结尾 '#', 需要时由 Frame::encode 的 terminate 参数追加
+
+#include <array>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace plcframes {
+
+enum class FieldKind : uint8_t {
+    Literal,            // 固定文本
+    Number,             // 定宽数字, 不足补 0
+    Variable,           // 变长数字(最多 width 位), 只能是最后一个字段或后面紧跟文本
+    Tag,                // 若干个等长备选文本之一, 值为备选序号, 例如 "SUFA" 宽 2: SU=0, FA=1
+};
+
+struct Field {
+    FieldKind kind;
+    std::string_view text;
+    uint8_t width;
+
+    constexpr size_t maxLen() const { return kind == FieldKind::Literal ? text.size() : width; }
+    constexpr bool hasValue() const { return kind != FieldKind::Literal; }
+};
+
+constexpr Field lit(std::string_view s) { return Field{ FieldKind::Literal, s, 0 }; }
+constexpr Field num(uint8_t width) { return Field{ FieldKind::Number, {}, width }; }
+constexpr Field var(uint8_t maxWidth) { return Field{ FieldKind::Variable, {}, maxWidth }; }
+constexpr Field tag(std::string_view alternatives, uint8_t width) { return Field{ FieldKind::Tag, alternatives, width }; }
+
+template<size_t N>
+struct Layout {
+    std::array<Field, N> fields;
+
+    constexpr size_t maxLen() const {
+        size_t n = 0;
+        for (const Field& f : fields) n += f.maxLen();
+        return n;
+    }
+    constexpr size_t valueCount() const {
+        size_t n = 0;
+        for (const Field& f : fields) n += f.hasValue() ? 1 : 0;
+        return n;
+    }
+};
+
+template<typename... F>
+constexpr Layout<sizeof...(F)> layout(F... f) { return Layout<sizeof...(F)>{ { f... } }; }
+
+inline constexpr auto kKey = layout(lit("D"), num(2), lit("ID"), num(4));                                     // 台, 序
+inline constexpr auto kStd = layout(lit("STD"), num(2), lit("ID"), num(4), lit("00000"));                     // 台, 序
+inline constexpr auto kGk = layout(lit("GKD"), num(2), lit("ID"), num(4), lit("G"), var(5));                   // 台, 序, 格口
+inline constexpr auto kUnload = layout(tag("SUFA", 2), num(3), lit("D"), num(2), lit("ID"), num(4), lit("G"), var(5));    // 状态, 小车, 台, 序, 格口
+
+enum UnloadStatus { Su = 0, Fa = 1 };
+
+// 按 layout 编码到 out[0..cap), 返回写入长度; 数值超出位宽、为负或缓冲区不足时返回 0
+template<size_t N>
+inline size_t encode(const Layout<N>& l, char* out, size_t cap, const int* values, size_t valueCount) {
+    size_t pos = 0;
+    size_t vi = 0;
+    for (const Field& f : l.fields) {
+        if (f.kind == FieldKind::Literal) {
+            if (pos + f.text.size() > cap) return 0;
+            std::memcpy(out + pos, f.text.data(), f.text.size());
+            pos += f.text.size();
+            continue;
+        }
+        if (vi >= valueCount) return 0;
+        int v = values[vi++];
+        if (v < 0) return 0;
+        if (f.kind == FieldKind::Tag) {
+            if (static_cast<size_t>(v + 1) * f.width > f.text.size() || pos + f.width > cap) return 0;
+            std::memcpy(out + pos, f.text.data() + static_cast<size_t>(v) * f.width, f.width);
+            pos += f.width;
+            continue;
+        }
+        char digits[12];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), v);
+        size_t len = static_cast<size_t>(end - digits);
+        if (ec != std::errc() || len > f.width) return 0;
+        size_t pad = f.kind == FieldKind::Number ? f.width - len : 0;
+        if (pos + pad + len > cap) return 0;
+        std::memset(out + pos, '0', pad);
+        std::memcpy(out + pos + pad, digits, len);
+        pos += pad + len;
+    }
+    return vi == valueCount ? pos : 0;
+}
+
+// 从 s 开头按 layout 解码, 数值按字段顺序写入 values, 返回消耗的字符数, 不匹配返回 0
+// 解码只看 layout 覆盖的前缀, 调用方需要整帧匹配时比较返回值与 s.size()
+template<size_t N>
+inline size_t decode(const Layout<N>& l, std::string_view s, int* values, size_t valueCount) {
+    size_t pos = 0;
+    size_t vi = 0;
+    for (const Field& f : l.fields) {
+        if (f.kind == FieldKind::Literal) {
+            if (s.size() - pos < f.text.size() || s.compare(pos, f.text.size(), f.text) != 0) return 0;
+            pos += f.text.size();
+            continue;
+        }
+        if (vi >= valueCount) return 0;
+        if (f.kind == FieldKind::Tag) {
+            if (s.size() - pos < f.width) return 0;
+            int found = -1;
+            for (size_t a = 0; a + f.width <= f.text.size(); a += f.width) {
+                if (s.compare(pos, f.width, f.text.substr(a, f.width)) == 0) {
+                    found = static_cast<int>(a / f.width);
+                    break;
+                }
+            }
+            if (found < 0) return 0;
+            values[vi++] = found;
+            pos += f.width;
+            continue;
+        }
+        size_t len = 0;
+        if (f.kind == FieldKind::Number) {
+            if (s.size() - pos < f.width) return 0;
+            len = f.width;
+        }
+        else {
+            while (len < f.width && pos + len < s.size() && s[pos + len] >= '0' && s[pos + len] <= '9') ++len;
+            if (len == 0) return 0;
+        }
+        if (s[pos] < '0' || s[pos] > '9') return 0;     // from_chars 会接受负号
+        int v = 0;
+        auto [end, ec] = std::from_chars(s.data() + pos, s.data() + pos + len, v);
+        if (ec != std::errc() || end != s.data() + pos + len) return 0;
+        values[vi++] = v;
+        pos += len;
+    }
+    return pos;
+}
+
+// 栈上报文缓冲区, 容量由 layout 在编译期确定(含结尾 '#')
+template<const auto& L>
+class Frame {
+public:
+    static constexpr size_t kCapacity = L.maxLen() + 1;
+
+    template<typename... V>
+    bool encode(bool terminate, V... values) {
+        static_assert(sizeof...(V) == L.valueCount(), "value count does not match frame layout");
+        const int v[] = { static_cast<int>(values)... };
+        len_ = plcframes::encode(L, data_, kCapacity - 1, v, sizeof...(V));
+        if (len_ && terminate) data_[len_++] = '#';
+        return len_ != 0;
+    }
+
+    std::string_view view() const { return std::string_view(data_, len_); }
+    size_t size() const { return len_; }
+
+private:
+    char data_[kCapacity];
+    size_t len_ = 0;
+};
+
+using KeyFrame = Frame<kKey>;
+using StdFrame = Frame<kStd>;
+using GkFrame = Frame<kGk>;
+using UnloadFrame = Frame<kUnload>;
+
+// 在报文任意位置查找 D<台2>ID<序4>, 如 "AKD01ID000100000" -> (1, 1)
+inline bool findKey(std::string_view s, int& station, int& order) {
+    for (size_t d = s.find('D'); d != std::string_view::npos; d = s.find('D', d + 1)) {
+        int v[2];
+        if (decode(kKey, s.substr(d), v, 2)) {
+            station = v[0];
+            order = v[1];
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace plcframes
+
+#endif // PLCFRAMES_H
@@ -0,0 +1,1016 @@
+#include "plcioengine.h"
+#include "logger.h"
+#include "simdscan.h"
+#include "mpsc_queue.h"
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mstcpip.h>
+using sock_t = SOCKET;
+static const sock_t kInvalidSock = INVALID_SOCKET;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+using sock_t = int;
+static const sock_t kInvalidSock = -1;
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define PLC_USE_EPOLL 1
+#endif
+
+namespace {
+
+int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int lastSockError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+bool wouldBlock(int err) {
+#ifdef _WIN32
+    return err == WSAEWOULDBLOCK;
+#else
+    return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+#endif
+}
+
+bool connectInProgress(int err) {
+#ifdef _WIN32
+    return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS;
+#else
+    return err == EINPROGRESS || err == EINTR;
+#endif
+}
+
+std::string sockErrorText(int err) {
+#ifdef _WIN32
+    return "WSAGetLastError=" + std::to_string(err);
+#else
+    return std::strerror(err);
+#endif
+}
+
+void setNonBlocking(sock_t s) {
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    fcntl(s, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+void closeSock(sock_t s) {
+    if (s == kInvalidSock) return;
+#ifdef _WIN32
+    closesocket(s);
+#else
+    ::close(s);
+#endif
+}
+
+// TCP_NODELAY, keepalive 探测及未确认数据超时, 失败只影响断线判定速度, 不影响连接
+void tuneSocket(sock_t s, const PlcIoEngine::Options& opt) {
+    int flag = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
+    if (opt.keepaliveIdleMs > 0) {
+        setsockopt(s, SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&flag), sizeof(flag));
+#ifdef _WIN32
+        tcp_keepalive ka{};                                     //Windows 以毫秒设置, 探测次数固定
+        ka.onoff = 1;
+        ka.keepalivetime = static_cast<ULONG>(opt.keepaliveIdleMs);
+        ka.keepaliveinterval = static_cast<ULONG>(std::max(1, opt.keepaliveIntervalMs));
+        DWORD ret = 0;
+        WSAIoctl(s, SIO_KEEPALIVE_VALS, &ka, sizeof(ka), nullptr, 0, &ret, nullptr, nullptr);
+#else
+#ifdef TCP_KEEPIDLE
+        int idle = std::max(1, (opt.keepaliveIdleMs + 999) / 1000);     //Linux 以秒为单位
+        setsockopt(s, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+#endif
+#ifdef TCP_KEEPINTVL
+        int intvl = std::max(1, (opt.keepaliveIntervalMs + 999) / 1000);
+        setsockopt(s, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+#endif
+#ifdef TCP_KEEPCNT
+        int cnt = std::max(1, opt.keepaliveCount);
+        setsockopt(s, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt));
+#endif
+#endif
+    }
+    if (opt.userTimeoutMs > 0) {
+#if defined(TCP_USER_TIMEOUT)
+        unsigned int t = static_cast<unsigned int>(opt.userTimeoutMs);
+        setsockopt(s, IPPROTO_TCP, TCP_USER_TIMEOUT, &t, sizeof(t));
+#elif defined(_WIN32) && defined(TCP_MAXRTMS)
+        DWORD t = static_cast<DWORD>(opt.userTimeoutMs);
+        setsockopt(s, IPPROTO_TCP, TCP_MAXRTMS, reinterpret_cast<const char*>(&t), sizeof(t));
+#endif
+    }
+}
+
+size_t countFrames(const char* p, size_t n) {                  // '#' 为 PLC 报文结束符
+    size_t frames = 0;
+    size_t pos = 0;
+    while (pos < n) {
+        size_t hit = simdscan::find(p + pos, n - pos, '#');
+        if (hit >= n - pos) break;
+        ++frames;
+        pos += hit + 1;
+    }
+    return frames;
+}
+
+constexpr size_t kQueuedFrameBytes = 132;                      // 队列槽位容纳的报文长度, PLC 报文最长 128 字节加 '#'
+
+struct OutFrame {
+    int64_t enqNs = 0;                                          // send() 入队时间, 用于统计写出延时
+    int64_t originNs = 0;                                       // 调用方给出的起始时间, 0 为没有
+    int64_t expireNs = 0;                                       // 调用方给出的失效时间, 到时未写出则丢弃, 0 为不失效
+    uint32_t session = 0;                                       // 入队时的连接代次, 只对 kThisConnection 的报文有意义
+    int32_t tag = 0;                                            // 调用方给出的标记, 写出时随 originNs 交给 onWire
+    uint32_t len = 0;
+    char data[kQueuedFrameBytes];
+};
+
+struct WireMark {
+    size_t end;                                                 // 报文末尾在缓冲区中的位置, 写到这里即整条交给内核; 上一条的 end 即本条的起点
+    int64_t enqNs;
+    int64_t originNs;
+    int64_t expireNs;
+    uint32_t session;
+    int32_t tag;
+    bool heartbeat;                                             // 引擎自己的心跳, 断线时不保留, 不计写出延时
+};
+
+// 已过失效时间, 或只属于当前连接而入队时的连接已经断开
+bool frameStale(int64_t expireNs, uint32_t frameSession, int64_t nowNs, uint32_t session) {
+    if (expireNs == PlcIoEngine::kThisConnection) return frameSession != session;
+    return expireNs > 0 && nowNs >= expireNs;
+}
+
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+} // namespace
+
+struct PlcIoEngine::Conn {
+    int id = 0;
+    std::string name;
+    std::string ip;
+    uint16_t port = 0;
+    RecvFn onRecv;
+    ConnectedFn onConnected;
+    WireFn onWire;
+    DrainedFn onDrained;
+
+    // 以下由事件循环线程独占
+    sock_t sock = kInvalidSock;
+    int64_t deadlineMs = 0;                 // Disconnected: 下次重连时间; Connecting: 连接超时时间
+    int64_t lastTxMs = 0;                   // 最近一次写出数据的时间, 心跳只在空闲时发送
+    int64_t hbSentUs = 0;                   // 等待回传的心跳发出时间, 0 为没有
+    size_t hbMatch = 0;                     // 心跳回传已匹配的字节数, 可跨读取
+    std::string hbHeld;                     // 上次读取末尾与回传部分匹配、暂不交给 onRecv 的字节
+    char rxLast = '#';                      // 最近一个接收字节(去掉回传后), 为 '#' 时下一字节是报文开头
+    bool wantWrite = false;                 // 待发数据未写完, 关注可写事件
+    bool registered = false;
+    int failStreak = 0;                     // 连续连接失败次数, 决定重连退避, 只在第一次失败时输出日志
+    std::string outBuf;                     // 待写出的报文, 断线时保留未写出的部分, 重连后接着写
+    size_t outOff = 0;
+    std::vector<WireMark> marks;            // outBuf 中各报文的结束位置, 按顺序, 覆盖 outBuf 的全部字节
+    size_t markHead = 0;
+
+    // 其他线程 send() 写入, 事件循环线程取走
+    std::unique_ptr<MpscQueue<OutFrame>> outQ;
+    std::mutex outMutex;                    // 队列满或报文超长时的溢出缓冲区
+    std::string pending;
+    std::vector<WireMark> pendingMarks;
+    std::atomic<bool> overflowActive{ false };  // 溢出缓冲区非空期间所有 send 都写溢出缓冲区, 保证同一线程的报文顺序
+    LatencyHistogram wireLatency;
+    LatencyHistogram originLatency;
+    LatencyHistogram heartbeatRtt;
+
+    std::atomic<uint32_t> state{ 0 };       // 低 2 位为 ConnState, 其余为连接代次: 每次连接建立加一, 只由事件循环线程修改
+    std::atomic<uint64_t> bytesIn{ 0 };
+    std::atomic<uint64_t> bytesOut{ 0 };
+    std::atomic<uint64_t> framesIn{ 0 };
+    std::atomic<uint64_t> framesOut{ 0 };
+    std::atomic<uint64_t> connects{ 0 };
+    std::atomic<uint64_t> connectFailures{ 0 };
+    std::atomic<uint64_t> disconnects{ 0 };
+    std::atomic<uint64_t> sendDrops{ 0 };
+    std::atomic<uint64_t> unsentDrops{ 0 };
+    std::atomic<uint64_t> carriedOver{ 0 };
+    std::atomic<uint64_t> pendingBytes{ 0 };
+    std::atomic<uint64_t> queueOverflows{ 0 };
+    std::atomic<uint64_t> flushes{ 0 };
+    std::atomic<int64_t> connectedAtMs{ 0 };
+    std::atomic<uint64_t> reconnects{ 0 };
+    std::atomic<uint64_t> heartbeatsSent{ 0 };
+    std::atomic<uint64_t> heartbeatTimeouts{ 0 };
+
+    ConnState st() const { return static_cast<ConnState>(state.load(std::memory_order_acquire) & 3u); }
+    uint32_t session() const { return state.load(std::memory_order_acquire) >> 2; }
+    void setState(ConnState s) {
+        uint32_t session = state.load(std::memory_order_relaxed) >> 2;
+        if (s == ConnState::Connected) ++session;
+        state.store((session << 2) | static_cast<uint32_t>(s), std::memory_order_release);
+    }
+};
+
+// 事件等待: Linux 为 epoll + eventfd 唤醒, 其他平台为 poll/WSAPoll + 本地 UDP 套接字唤醒
+struct PlcIoEngine::Poller {
+    struct Event {
+        int id;                             // 连接编号, -1 为唤醒事件
+        bool readable;
+        bool writable;
+        bool error;
+    };
+
+#ifdef PLC_USE_EPOLL
+    int epfd = -1;
+    int evfd = -1;
+
+    bool open() {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epfd < 0 || evfd < 0) return false;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = UINT32_MAX;
+        return epoll_ctl(epfd, EPOLL_CTL_ADD, evfd, &ev) == 0;
+    }
+    void close() {
+        if (evfd >= 0) ::close(evfd);
+        if (epfd >= 0) ::close(epfd);
+        evfd = epfd = -1;
+    }
+    void signal() {
+        uint64_t one = 1;
+        ssize_t r = ::write(evfd, &one, sizeof(one));
+        (void)r;
+    }
+    void drainWake() {
+        uint64_t v;
+        ssize_t r = ::read(evfd, &v, sizeof(v));
+        (void)r;
+    }
+    void update(Conn& c) {
+        if (c.sock == kInvalidSock) {
+            c.registered = false;
+            return;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        if (c.wantWrite || c.st() == ConnState::Connecting) ev.events |= EPOLLOUT;
+        ev.data.u32 = static_cast<uint32_t>(c.id);
+        epoll_ctl(epfd, c.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, c.sock, &ev);
+        c.registered = true;
+    }
+    void remove(Conn& c) {
+        if (c.registered && c.sock != kInvalidSock) epoll_ctl(epfd, EPOLL_CTL_DEL, c.sock, nullptr);
+        c.registered = false;
+    }
+    int wait(std::vector<Event>& out, int timeoutMs, const std::vector<std::unique_ptr<Conn>>&) {
+        epoll_event evs[16];
+        int n = epoll_wait(epfd, evs, 16, timeoutMs);
+        out.clear();
+        for (int i = 0; i < n; ++i) {
+            int id = evs[i].data.u32 == UINT32_MAX ? -1 : static_cast<int>(evs[i].data.u32);
+            out.push_back(Event{ id,
+                                 (evs[i].events & (EPOLLIN | EPOLLRDHUP)) != 0,
+                                 (evs[i].events & EPOLLOUT) != 0,
+                                 (evs[i].events & (EPOLLERR | EPOLLHUP)) != 0 });
+        }
+        return n;
+    }
+#else
+    sock_t wakeSock = kInvalidSock;
+    std::vector<pollfd> fds;
+    std::vector<int> ids;
+
+    bool open() {
+        wakeSock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (wakeSock == kInvalidSock) return false;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = 0;
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        socklen_t len = sizeof(addr);
+        if (::bind(wakeSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::getsockname(wakeSock, reinterpret_cast<sockaddr*>(&addr), &len) != 0
+            || ::connect(wakeSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            return false;
+        }
+        setNonBlocking(wakeSock);
+        return true;
+    }
+    void close() {
+        closeSock(wakeSock);
+        wakeSock = kInvalidSock;
+    }
+    void signal() {
+        char b = 1;
+        ::send(wakeSock, &b, 1, 0);
+    }
+    void drainWake() {
+        char buf[64];
+        while (::recv(wakeSock, buf, sizeof(buf), 0) > 0) {}
+    }
+    void update(Conn& c) { c.registered = c.sock != kInvalidSock; }
+    void remove(Conn& c) { c.registered = false; }
+    int wait(std::vector<Event>& out, int timeoutMs, const std::vector<std::unique_ptr<Conn>>& conns) {
+        fds.clear();
+        ids.clear();
+        pollfd wfd{};
+        wfd.fd = wakeSock;
+        wfd.events = POLLIN;
+        fds.push_back(wfd);
+        ids.push_back(-1);
+        for (const auto& c : conns) {
+            if (c->sock == kInvalidSock) continue;
+            pollfd p{};
+            p.fd = c->sock;
+            p.events = POLLIN;
+            if (c->wantWrite || c->st() == ConnState::Connecting) p.events |= POLLOUT;
+            fds.push_back(p);
+            ids.push_back(c->id);
+        }
+#ifdef _WIN32
+        int n = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+        int n = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeoutMs);
+#endif
+        out.clear();
+        if (n <= 0) return n;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            short r = fds[i].revents;
+            if (!r) continue;
+            out.push_back(Event{ ids[i], (r & POLLIN) != 0, (r & POLLOUT) != 0, (r & (POLLERR | POLLHUP)) != 0 });
+        }
+        return static_cast<int>(out.size());
+    }
+#endif
+};
+
+const char* PlcIoEngine::stateName(ConnState s) {
+    switch (s) {
+    case ConnState::Disconnected: return "disconnected";
+    case ConnState::Connecting: return "connecting";
+    case ConnState::Connected: return "connected";
+    }
+    return "unknown";
+}
+
+PlcIoEngine::PlcIoEngine() = default;
+
+void PlcIoEngine::setOptions(const Options& opt) {
+    opt_ = opt;
+    if (!opt_.heartbeat.empty() && opt_.heartbeat.back() != '#') {     //不带结束符的心跳会被 PLC 拼到下一帧前面
+        opt_.heartbeat.push_back('#');
+    }
+}
+
+PlcIoEngine::~PlcIoEngine() {
+    stop();
+    if (poller_) poller_->close();
+}
+
+int PlcIoEngine::addConnection(const std::string& name, const std::string& ip, uint16_t port, RecvFn onRecv) {
+    auto c = std::make_unique<Conn>();
+    c->id = static_cast<int>(conns_.size());
+    c->name = name;
+    c->ip = ip;
+    c->port = port;
+    c->onRecv = std::move(onRecv);
+    c->outQ = std::make_unique<MpscQueue<OutFrame>>(std::max<size_t>(2, opt_.sendQueueFrames));
+    conns_.push_back(std::move(c));
+    return conns_.back()->id;
+}
+
+void PlcIoEngine::setOnConnected(int conn, ConnectedFn fn) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return;
+    conns_[conn]->onConnected = std::move(fn);
+}
+
+void PlcIoEngine::setOnWire(int conn, WireFn fn) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return;
+    conns_[conn]->onWire = std::move(fn);
+}
+
+void PlcIoEngine::setOnDrained(int conn, DrainedFn fn) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return;
+    conns_[conn]->onDrained = std::move(fn);
+}
+
+void PlcIoEngine::setTicker(int intervalMs, TickFn fn) {
+    tickMs_ = std::max(1, intervalMs);
+    tickFn_ = std::move(fn);
+}
+
+bool PlcIoEngine::start() {
+    if (running_.load()) return true;
+    if (!poller_) {                                             //第一次启动时创建, 之后保留到析构, send() 所在线程随时可能唤醒它
+        auto poller = std::make_unique<Poller>();
+        if (!poller->open()) {
+            Logger::getInstance().Log("----[PlcIoEngine] start() failed to create poller: " + sockErrorText(lastSockError()));
+            poller->close();
+            return false;
+        }
+        poller_ = std::move(poller);
+    }
+    poller_->drainWake();                                       //先清掉停止期间残留的唤醒, 再复位合并标志, 之后的 send() 一定会重新唤醒
+    wakePending_.store(false, std::memory_order_release);
+    int64_t now = steadyNowMs();
+    for (auto& c : conns_) {
+        c->deadlineMs = now;                                    //立即开始连接
+        c->failStreak = 0;
+    }
+    nextTickMs_ = now + tickMs_;
+    jitterState_ = static_cast<uint64_t>(steadyNowNs()) | 1;
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&PlcIoEngine::loop, this);
+    Logger::getInstance().Log("----[PlcIoEngine] start() connections: [" + std::to_string(conns_.size()) + "]");
+    return true;
+}
+
+void PlcIoEngine::stop() {
+    if (!running_.exchange(false)) return;
+    poller_->signal();                                          //不经过 wake(): 合并标志可能已置位, 仍要确保循环醒来
+    if (thread_.joinable()) thread_.join();
+    wakePending_.store(false, std::memory_order_release);       //循环可能未处理最后一次唤醒就退出
+    int64_t now = steadyNowMs();
+    for (auto& c : conns_) {
+        if (c->sock != kInvalidSock) closeConn(*c, now, "engine stopped");
+        size_t lost = discardQueued(*c);                        //停止后不再重连, 保留的报文没有机会写出
+        if (lost > 0) {
+            Logger::getInstance().Log("----[PlcIoEngine] stop() [" + c->name + "] discard unsent bytes: [" + std::to_string(lost) + "]");
+        }
+    }
+    Logger::getInstance().Log("----[PlcIoEngine] stop() engine stopped");
+}
+
+bool PlcIoEngine::send(int conn, std::string_view data, int64_t originNs, int tag, int64_t expireNs) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return false;
+    Conn& c = *conns_[conn];
+    uint32_t word = c.state.load(std::memory_order_acquire);    //状态和代次一次读出, kThisConnection 的报文只属于这一次连接
+    bool down = static_cast<ConnState>(word & 3u) != ConnState::Connected;
+    if (!running_.load(std::memory_order_acquire) || (down && expireNs == kThisConnection)) {     //其余报文未连接时照常入队
+        c.sendDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    uint32_t session = word >> 2;
+    if (data.empty()) return true;
+    if (c.pendingBytes.load(std::memory_order_relaxed) + data.size() > opt_.maxPendingBytes) {    //断线过久, 保留的报文已到上限
+        c.sendDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    int64_t enqNs = steadyNowNs();
+    c.pendingBytes.fetch_add(data.size(), std::memory_order_relaxed);     //先计入再发布, 事件循环扣减时不会先于这里
+    bool queued = false;
+    if (data.size() <= kQueuedFrameBytes && !c.overflowActive.load(std::memory_order_acquire)) {
+        queued = c.outQ->try_push_with([&](OutFrame& f) {
+            f.enqNs = enqNs;
+            f.originNs = originNs;
+            f.expireNs = expireNs;
+            f.session = session;
+            f.tag = tag;
+            f.len = static_cast<uint32_t>(data.size());
+            std::memcpy(f.data, data.data(), data.size());
+        });
+    }
+    if (!queued) {                                              //队列满或报文超长
+        std::lock_guard<std::mutex> lk(c.outMutex);
+        c.pending.append(data.data(), data.size());
+        c.pendingMarks.push_back(WireMark{ c.pending.size(), enqNs, originNs, expireNs, session, tag, false });
+        c.overflowActive.store(true, std::memory_order_release);
+        c.queueOverflows.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake();
+    return true;
+}
+
+bool PlcIoEngine::connected(int conn) const {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return false;
+    return conns_[conn]->st() == ConnState::Connected;
+}
+
+uint64_t PlcIoEngine::pendingBytes(int conn) const {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return 0;
+    return conns_[conn]->pendingBytes.load(std::memory_order_relaxed);
+}
+
+PlcIoEngine::ConnStats PlcIoEngine::stats(int conn) const {
+    ConnStats s;
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return s;
+    const Conn& c = *conns_[conn];
+    s.name = c.name;
+    s.state = c.st();
+    s.bytesIn = c.bytesIn.load(std::memory_order_relaxed);
+    s.bytesOut = c.bytesOut.load(std::memory_order_relaxed);
+    s.framesIn = c.framesIn.load(std::memory_order_relaxed);
+    s.framesOut = c.framesOut.load(std::memory_order_relaxed);
+    s.connects = c.connects.load(std::memory_order_relaxed);
+    s.connectFailures = c.connectFailures.load(std::memory_order_relaxed);
+    s.disconnects = c.disconnects.load(std::memory_order_relaxed);
+    s.sendDrops = c.sendDrops.load(std::memory_order_relaxed);
+    s.unsentDrops = c.unsentDrops.load(std::memory_order_relaxed);
+    s.carriedOver = c.carriedOver.load(std::memory_order_relaxed);
+    s.pendingBytes = c.pendingBytes.load(std::memory_order_relaxed);
+    s.queuedFrames = c.outQ->size_approx();
+    s.queueOverflows = c.queueOverflows.load(std::memory_order_relaxed);
+    s.flushes = c.flushes.load(std::memory_order_relaxed);
+    if (s.state == ConnState::Connected) s.uptimeMs = steadyNowMs() - c.connectedAtMs.load(std::memory_order_relaxed);
+    s.reconnects = c.reconnects.load(std::memory_order_relaxed);
+    s.heartbeatsSent = c.heartbeatsSent.load(std::memory_order_relaxed);
+    s.heartbeatTimeouts = c.heartbeatTimeouts.load(std::memory_order_relaxed);
+    return s;
+}
+
+LatencyHistogram::Summary PlcIoEngine::takeHeartbeatRtt(int conn) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return LatencyHistogram::Summary();
+    return conns_[conn]->heartbeatRtt.takeSummary();
+}
+
+// 指数退避加抖动: 第 n 次连续失败后等待 [d/2, d], d = min(reconnectMs * 2^n, reconnectMaxMs), 避免多个连接同时重连
+int64_t PlcIoEngine::reconnectDelayMs(int failStreak) {
+    int64_t base = std::max(1, opt_.reconnectMs);
+    int64_t cap = std::max<int64_t>(base, opt_.reconnectMaxMs);
+    int64_t d = base << std::min(failStreak, 20);
+    if (d > cap) d = cap;
+    jitterState_ ^= jitterState_ << 13;                         //xorshift64
+    jitterState_ ^= jitterState_ >> 7;
+    jitterState_ ^= jitterState_ << 17;
+    int64_t half = d / 2;
+    return half + static_cast<int64_t>(jitterState_ % static_cast<uint64_t>(d - half + 1));
+}
+
+LatencyHistogram::Summary PlcIoEngine::takeWireLatency(int conn) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return LatencyHistogram::Summary();
+    return conns_[conn]->wireLatency.takeSummary();
+}
+
+LatencyHistogram::Summary PlcIoEngine::takeOriginLatency(int conn) {
+    if (conn < 0 || conn >= static_cast<int>(conns_.size())) return LatencyHistogram::Summary();
+    return conns_[conn]->originLatency.takeSummary();
+}
+
+int64_t PlcIoEngine::nowNs() {
+    return steadyNowNs();
+}
+
+void PlcIoEngine::wake() {
+    if (wakePending_.exchange(true)) return;                    //已有未处理的唤醒, 合并
+    poller_->signal();                                          //send() 只在连接过后才走到这里, 此时 poller_ 已创建且不再释放
+}
+
+void PlcIoEngine::loop() {
+    std::vector<Poller::Event> events;
+    while (running_.load(std::memory_order_acquire)) {
+        int64_t now = steadyNowMs();
+        runTimers(now);
+        poller_->wait(events, nextTimeoutMs(now), conns_);
+        now = steadyNowMs();
+        for (const auto& ev : events) {
+            if (ev.id < 0) {                                    //send() 或 stop() 唤醒
+                poller_->drainWake();
+                wakePending_.exchange(false, std::memory_order_acq_rel);    //与 send() 的 exchange 同步, 之后能看到它入队的报文
+                for (auto& c : conns_) {
+                    if (c->st() == ConnState::Connected) flush(*c, now);
+                }
+                continue;
+            }
+            Conn& c = *conns_[ev.id];
+            if (c.sock == kInvalidSock) continue;
+            if (c.st() == ConnState::Connecting) {
+                if (ev.writable || ev.error) finishConnect(c, now);
+                continue;
+            }
+            if (ev.readable || ev.error) handleRead(c, now);
+            if (c.sock != kInvalidSock && ev.writable) flush(c, now);
+        }
+    }
+}
+
+void PlcIoEngine::beginConnect(Conn& c, int64_t nowMs) {
+    sock_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalidSock) {
+        c.connectFailures.fetch_add(1, std::memory_order_relaxed);
+        c.deadlineMs = nowMs + reconnectDelayMs(c.failStreak++);
+        Logger::getInstance().Log("----[PlcIoEngine] beginConnect() [" + c.name + "] create socket failed: " + sockErrorText(lastSockError()));
+        return;
+    }
+    tuneSocket(s, opt_);
+    setNonBlocking(s);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(c.port);
+    if (inet_pton(AF_INET, c.ip.c_str(), &addr.sin_addr) != 1) {
+        closeSock(s);
+        c.connectFailures.fetch_add(1, std::memory_order_relaxed);
+        c.deadlineMs = nowMs + reconnectDelayMs(c.failStreak++);
+        Logger::getInstance().Log("----[PlcIoEngine] beginConnect() [" + c.name + "] invalid ip: [" + c.ip + "]");
+        return;
+    }
+    c.sock = s;
+    c.setState(ConnState::Connecting);
+    c.deadlineMs = nowMs + opt_.connectTimeoutMs;
+    int r = ::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    if (r == 0) {
+        finishConnect(c, nowMs);
+        return;
+    }
+    int err = lastSockError();
+    if (!connectInProgress(err)) {
+        closeConn(c, nowMs, "connect failed: " + sockErrorText(err));
+        return;
+    }
+    poller_->update(c);                                         //等待可写即连接完成
+}
+
+void PlcIoEngine::finishConnect(Conn& c, int64_t nowMs) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(c.sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &len) != 0) err = lastSockError();
+    if (err != 0) {
+        closeConn(c, nowMs, "connect failed: " + sockErrorText(err));
+        return;
+    }
+    c.connectedAtMs.store(nowMs, std::memory_order_relaxed);
+    c.setState(ConnState::Connected);
+    if (c.connects.fetch_add(1, std::memory_order_relaxed) > 0) c.reconnects.fetch_add(1, std::memory_order_relaxed);
+    c.failStreak = 0;
+    c.lastTxMs = nowMs;
+    c.hbSentUs = 0;
+    c.hbMatch = 0;
+    c.hbHeld.clear();
+    c.rxLast = '#';
+    c.wantWrite = false;
+    poller_->update(c);
+    if (c.onConnected) c.onConnected();
+    Logger::getInstance().Log("----[PlcIoEngine] finishConnect() [" + c.name + "] connected to [" + c.ip + ":" + std::to_string(c.port) + "]");
+    size_t kept = c.marks.size();
+    keepUnsent(c, steadyNowNs());                               //断线期间过期的报文在写出前去掉
+    if (kept > 0) {
+        c.carriedOver.fetch_add(c.marks.size(), std::memory_order_relaxed);
+        Logger::getInstance().Log("----[PlcIoEngine] finishConnect() [" + c.name + "] replay frames kept from previous connection: ["
+                                  + std::to_string(c.marks.size()) + "] expired: [" + std::to_string(kept - c.marks.size()) + "]");
+    }
+    flush(c, nowMs);                                            //保留的报文先于断线期间入队的报文写出
+}
+
+void PlcIoEngine::handleRead(Conn& c, int64_t nowMs) {
+    char buf[4096];
+    for (int i = 0; i < 16; ++i) {                              //单次事件最多读 64KB, 避免一个连接独占循环
+        int n = ::recv(c.sock, buf, static_cast<int>(sizeof(buf)), 0);
+        if (n > 0) {
+            c.bytesIn.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            c.framesIn.fetch_add(countFrames(buf, static_cast<size_t>(n)), std::memory_order_relaxed);
+            receive(c, buf, static_cast<size_t>(n));
+            if (static_cast<size_t>(n) < sizeof(buf)) return;
+            continue;
+        }
+        if (n == 0) {
+            closeConn(c, nowMs, "peer closed");
+            return;
+        }
+        int err = lastSockError();
+        if (wouldBlock(err)) return;
+        closeConn(c, nowMs, "recv failed: " + sockErrorText(err));
+        return;
+    }
+}
+
+// 把发送队列和溢出缓冲区中的报文按入队顺序追加到 outBuf, 已过 expireNs 或属于已断开连接的丢弃并计入 unsentDrops, 只在事件循环线程调用
+void PlcIoEngine::takeQueued(Conn& c, int64_t nowNs) {
+    if (c.outOff == c.outBuf.size()) {
+        c.outBuf.clear();
+        c.outOff = 0;
+        c.marks.clear();
+        c.markHead = 0;
+    }
+    const uint32_t session = c.session();
+    uint64_t expiredFrames = 0;
+    size_t expiredBytes = 0;
+    c.outQ->consume([&](OutFrame& f) {
+        if (frameStale(f.expireNs, f.session, nowNs, session)) {
+            ++expiredFrames;
+            expiredBytes += f.len;
+            return;
+        }
+        c.outBuf.append(f.data, f.len);
+        c.marks.push_back(WireMark{ c.outBuf.size(), f.enqNs, f.originNs, f.expireNs, f.session, f.tag, false });
+    }, c.outQ->capacity());
+    // 溢出缓冲区中的报文比队列中已发布的报文晚, 队列里还有占位未写完的槽位时留到下次, 该生产者写完会再次唤醒
+    if (c.overflowActive.load(std::memory_order_acquire) && c.outQ->size_approx() == 0) {
+        std::lock_guard<std::mutex> lk(c.outMutex);
+        size_t start = 0;
+        for (const WireMark& m : c.pendingMarks) {
+            if (frameStale(m.expireNs, m.session, nowNs, session)) {
+                ++expiredFrames;
+                expiredBytes += m.end - start;
+            }
+            else {
+                c.outBuf.append(c.pending, start, m.end - start);
+                c.marks.push_back(WireMark{ c.outBuf.size(), m.enqNs, m.originNs, m.expireNs, m.session, m.tag, false });
+            }
+            start = m.end;
+        }
+        c.pending.clear();
+        c.pendingMarks.clear();
+        c.overflowActive.store(false, std::memory_order_release);
+    }
+    if (expiredFrames > 0) {
+        c.unsentDrops.fetch_add(expiredFrames, std::memory_order_relaxed);
+        c.pendingBytes.fetch_sub(expiredBytes, std::memory_order_relaxed);
+        Logger::getInstance().Log("----[PlcIoEngine] takeQueued() [" + c.name + "] drop frames past their expiry or queued for a closed connection: ["
+                                  + std::to_string(expiredFrames) + "]");
+    }
+}
+
+// 连接断开或重新建立时整理 outBuf: 已整条写出的报文去掉, 写了一半的报文退回开头整条重发,
+// 心跳、已过 expireNs 和只属于当前连接(kThisConnection, 由调用方重放)的报文丢弃, 其余按原顺序保留到下一次连接. 返回保留的报文数
+size_t PlcIoEngine::keepUnsent(Conn& c, int64_t nowNs) {
+    size_t start = c.markHead > 0 ? c.marks[c.markHead - 1].end : 0;     //第一条未整条写出的报文的起点
+    uint64_t rewound = c.outOff - start;                        //已写给旧连接的半条, 重发时要重新计入待发
+    std::string kept;
+    std::vector<WireMark> keptMarks;
+    uint64_t expiredFrames = 0;
+    uint64_t droppedBytes = 0;
+    for (size_t i = c.markHead; i < c.marks.size(); ++i) {
+        const WireMark& m = c.marks[i];
+        size_t len = m.end - start;
+        if (m.heartbeat || m.expireNs == kThisConnection || frameStale(m.expireNs, m.session, nowNs, 0)) {
+            if (!m.heartbeat) ++expiredFrames;
+            droppedBytes += len;
+        }
+        else {
+            kept.append(c.outBuf, start, len);
+            keptMarks.push_back(m);
+            keptMarks.back().end = kept.size();
+        }
+        start = m.end;
+    }
+    c.outBuf.swap(kept);
+    c.marks.swap(keptMarks);
+    c.outOff = 0;
+    c.markHead = 0;
+    c.pendingBytes.fetch_add(rewound, std::memory_order_relaxed);
+    c.pendingBytes.fetch_sub(droppedBytes, std::memory_order_relaxed);
+    if (expiredFrames > 0) {
+        c.unsentDrops.fetch_add(expiredFrames, std::memory_order_relaxed);
+        Logger::getInstance().Log("----[PlcIoEngine] keepUnsent() [" + c.name + "] drop frames past their expiry or left to the caller to replay: ["
+                                  + std::to_string(expiredFrames) + "]");
+    }
+    return c.marks.size();
+}
+
+// 引擎停止时丢弃全部未写出的报文(写了一半的报文也算), 计入 unsentDrops, 返回字节数
+size_t PlcIoEngine::discardQueued(Conn& c) {
+    size_t lost = c.outBuf.size() - c.outOff;
+    uint64_t frames = 0;
+    for (size_t i = c.markHead; i < c.marks.size(); ++i) {
+        if (!c.marks[i].heartbeat) ++frames;
+    }
+    c.outBuf.clear();
+    c.outOff = 0;
+    c.marks.clear();
+    c.markHead = 0;
+    c.outQ->consume([&](OutFrame& f) { lost += f.len; ++frames; }, c.outQ->capacity());
+    {
+        std::lock_guard<std::mutex> lk(c.outMutex);
+        lost += c.pending.size();
+        frames += c.pendingMarks.size();
+        c.pending.clear();
+        c.pendingMarks.clear();
+        c.overflowActive.store(false, std::memory_order_release);
+    }
+    c.unsentDrops.fetch_add(frames, std::memory_order_relaxed);
+    c.pendingBytes.fetch_sub(lost, std::memory_order_relaxed);               //send() 在发布前已计入, 不会减成负数
+    return lost;
+}
+
+void PlcIoEngine::flush(Conn& c, int64_t nowMs) {
+    bool hadPending = c.pendingBytes.load(std::memory_order_relaxed) > 0;
+    takeQueued(c, steadyNowNs());
+    bool wasWant = c.wantWrite;
+    while (c.outOff < c.outBuf.size()) {                        //全部待发报文一次 send 写出
+        const char* p = c.outBuf.data() + c.outOff;
+        size_t left = c.outBuf.size() - c.outOff;
+        int n = ::send(c.sock, p, static_cast<int>(left), kSendFlags);
+        if (n > 0) {
+            c.outOff += static_cast<size_t>(n);
+            c.bytesOut.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            c.flushes.fetch_add(1, std::memory_order_relaxed);
+            c.lastTxMs = nowMs;
+            c.pendingBytes.fetch_sub(std::min<uint64_t>(static_cast<uint64_t>(n), c.pendingBytes.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            if (c.markHead < c.marks.size() && c.marks[c.markHead].end <= c.outOff) {
+                int64_t nowNs = steadyNowNs();
+                while (c.markHead < c.marks.size() && c.marks[c.markHead].end <= c.outOff) {
+                    const WireMark& m = c.marks[c.markHead];
+                    if (!m.heartbeat) {                         //心跳不计入报文数和写出延时
+                        c.framesOut.fetch_add(1, std::memory_order_relaxed);
+                        c.wireLatency.record((nowNs - m.enqNs) / 1000);
+                    }
+                    if (m.originNs > 0) {
+                        c.originLatency.record((nowNs - m.originNs) / 1000);
+                        if (c.onWire) c.onWire(m.tag, m.originNs, nowNs);
+                    }
+                    ++c.markHead;
+                }
+            }
+            continue;
+        }
+        int err = lastSockError();
+        if (n < 0 && wouldBlock(err)) break;
+        closeConn(c, nowMs, "send failed: " + sockErrorText(err));
+        return;
+    }
+    if (c.outOff == c.outBuf.size()) {
+        c.outBuf.clear();
+        c.outOff = 0;
+        c.marks.clear();
+        c.markHead = 0;
+    }
+    c.wantWrite = c.outOff < c.outBuf.size();
+    if (c.wantWrite != wasWant) poller_->update(c);
+    if (hadPending && c.onDrained && c.pendingBytes.load(std::memory_order_relaxed) == 0) {    //待发数据已写完或过期丢弃, 写者空闲, 上游可以交下一批
+        try {
+            c.onDrained();
+        }
+        catch (...) {
+            Logger::getInstance().Log("----[PlcIoEngine] flush() [" + c.name + "] drained callback threw");
+        }
+    }
+}
+
+// 接收数据交给 onRecv. 等待心跳回传时, 从报文边界(连接开始或 '#' 之后)起与心跳内容逐字节匹配,
+// 完整的回传从数据中去掉, 不会拼到下一帧前面; 读取末尾的部分匹配先扣留, 后续不匹配时原样补交
+void PlcIoEngine::receive(Conn& c, const char* p, size_t n) {
+    const std::string& hb = opt_.heartbeat;
+    size_t from = 0;                                            // 尚未交出的起点
+    size_t matchAt = 0;                                         // 本次数据中回传的起点, 接着扣留的字节匹配时为 0
+    char prev = c.rxLast;
+    for (size_t i = 0; i < n && c.hbSentUs != 0 && !hb.empty(); ++i) {
+        if (c.hbMatch > 0 && p[i] != hb[c.hbMatch]) {           //不是回传, 扣留的字节在本次数据之前补交
+            if (!c.hbHeld.empty()) {
+                deliver(c, c.hbHeld.data(), c.hbHeld.size());
+                c.hbHeld.clear();
+            }
+            c.hbMatch = 0;
+        }
+        if (c.hbMatch == 0) {
+            if (prev != '#' || p[i] != hb[0]) {
+                prev = p[i];
+                continue;
+            }
+            matchAt = i;
+        }
+        ++c.hbMatch;
+        prev = p[i];
+        if (c.hbMatch == hb.size()) {
+            c.heartbeatRtt.record(steadyNowNs() / 1000 - c.hbSentUs);
+            c.hbSentUs = 0;
+            c.hbMatch = 0;
+            c.hbHeld.clear();
+            deliver(c, p + from, matchAt - from);
+            from = i + 1;
+            prev = '#';                                         //去掉回传后仍在报文边界
+        }
+    }
+    if (c.hbMatch > 0) {                                        //末尾是未完成的匹配, 扣留到下次读取
+        deliver(c, p + from, matchAt - from);
+        c.hbHeld.append(p + matchAt, n - matchAt);
+    }
+    else {
+        deliver(c, p + from, n - from);
+    }
+    c.rxLast = from < n ? p[n - 1] : prev;
+}
+
+void PlcIoEngine::deliver(Conn& c, const char* p, size_t n) {
+    if (n == 0 || !c.onRecv) return;
+    try {
+        c.onRecv(p, n);
+    }
+    catch (...) {
+        Logger::getInstance().Log("----[PlcIoEngine] deliver() [" + c.name + "] receive callback threw");
+    }
+}
+
+void PlcIoEngine::closeConn(Conn& c, int64_t nowMs, const std::string& reason) {
+    ConnState prev = c.st();
+    poller_->remove(c);
+    closeSock(c.sock);
+    c.sock = kInvalidSock;
+    c.setState(ConnState::Disconnected);
+    c.deadlineMs = nowMs + reconnectDelayMs(prev == ConnState::Connected ? 0 : c.failStreak);
+    c.wantWrite = false;
+    c.hbSentUs = 0;
+    c.hbMatch = 0;
+    c.hbHeld.clear();
+    if (prev == ConnState::Connected) {
+        takeQueued(c, steadyNowNs());                           //连同已入队的报文一起按顺序留到重连
+        size_t kept = keepUnsent(c, steadyNowNs());
+        c.disconnects.fetch_add(1, std::memory_order_relaxed);
+        Logger::getInstance().Log("----[PlcIoEngine] closeConn() [" + c.name + "] disconnected: " + reason
+                                  + ", unsent frames kept for reconnect: [" + std::to_string(kept) + "]");
+    }
+    else {
+        c.connectFailures.fetch_add(1, std::memory_order_relaxed);
+        if (c.failStreak++ == 0 && running_.load()) {           //持续连不上时只输出第一次
+            Logger::getInstance().Log("----[PlcIoEngine] closeConn() [" + c.name + "] " + reason + ", retry backoff from "
+                                      + std::to_string(opt_.reconnectMs) + " ms up to " + std::to_string(opt_.reconnectMaxMs) + " ms");
+        }
+    }
+}
+
+void PlcIoEngine::runTimers(int64_t nowMs) {
+    if (tickFn_ && nowMs >= nextTickMs_) {
+        nextTickMs_ = nowMs + tickMs_;
+        try {
+            tickFn_(nowMs);
+        }
+        catch (...) {
+            Logger::getInstance().Log("----[PlcIoEngine] runTimers() tick callback threw");
+        }
+    }
+    for (auto& cp : conns_) {
+        Conn& c = *cp;
+        switch (c.st()) {
+        case ConnState::Disconnected:
+            if (nowMs >= c.deadlineMs) beginConnect(c, nowMs);
+            break;
+        case ConnState::Connecting:
+            if (nowMs >= c.deadlineMs) closeConn(c, nowMs, "connect timeout");
+            break;
+        case ConnState::Connected:
+            if (opt_.heartbeatMs <= 0) break;
+            if (c.hbSentUs != 0 && nowMs - c.hbSentUs / 1000 >= opt_.heartbeatTimeoutMs) {      //心跳未回传, 判定断线
+                c.heartbeatTimeouts.fetch_add(1, std::memory_order_relaxed);
+                closeConn(c, nowMs, "heartbeat echo timeout");
+                break;
+            }
+            if (c.hbSentUs == 0 && !c.wantWrite && nowMs - c.lastTxMs >= opt_.heartbeatMs) {     //空闲时才发心跳, 写失败即判定断线
+                takeQueued(c, steadyNowNs());                   //心跳排在已入队报文之后, outBuf 的每个字节都有对应的标记
+                c.outBuf.append(opt_.heartbeat);
+                c.marks.push_back(WireMark{ c.outBuf.size(), 0, 0, 0, 0, 0, true });
+                c.pendingBytes.fetch_add(opt_.heartbeat.size(), std::memory_order_relaxed);   //与报文一样计入待发, flush/keepUnsent 按写出或丢弃扣减
+                c.heartbeatsSent.fetch_add(1, std::memory_order_relaxed);
+                if (opt_.heartbeatEcho) {
+                    c.hbSentUs = steadyNowNs() / 1000;
+                    c.hbMatch = 0;
+                }
+                flush(c, nowMs);
+                c.lastTxMs = nowMs;
+            }
+            break;
+        }
+    }
+}
+
+int PlcIoEngine::nextTimeoutMs(int64_t nowMs) const {
+    int64_t next = tickFn_ ? nextTickMs_ : INT64_MAX;
+    for (const auto& c : conns_) {
+        switch (c->st()) {
+        case ConnState::Disconnected:
+        case ConnState::Connecting:
+            next = std::min(next, c->deadlineMs);
+            break;
+        case ConnState::Connected:
+            if (opt_.heartbeatMs <= 0) break;
+            if (c->hbSentUs != 0) next = std::min(next, c->hbSentUs / 1000 + opt_.heartbeatTimeoutMs);
+            else if (!c->wantWrite) next = std::min(next, c->lastTxMs + opt_.heartbeatMs);     //有未写完的数据时由可写事件驱动
+            break;
+        }
+    }
+    if (next == INT64_MAX) return -1;                           //没有定时任务, 只等事件
+    return static_cast<int>(std::clamp<int64_t>(next - nowMs, 0, 60000));
+}
@@ -0,0 +1,158 @@
+#ifndef PLCIOENGINE_H
+#define PLCIOENGINE_H
+
+// PLC 连接引擎: 一个事件循环线程管理全部 PLC TCP 连接 (Linux 用 epoll, Windows 用 WSAPoll)
+// 每个连接是一个状态机: Disconnected -> Connecting -> Connected -> (出错/断开) -> Disconnected
+// connect/recv/send 全部非阻塞; 断开后按 reconnectMs 起步指数退避(带随机抖动)重连, 无事件时线程阻塞在 epoll_wait, 不占 CPU
+// 链路保活: TCP keepalive 探测空闲链路, 已发数据长时间未确认由 TCP_USER_TIMEOUT(Windows 为 TCP_MAXRTMS) 判定断线;
+// 应用层心跳只在链路空闲时发送, 是一条以 '#' 结尾的独立报文(PLC 不识别的内容会被忽略), 不会粘到下一帧 STD/GK 前面;
+// 空闲链路因此也总有未确认数据, 由 userTimeoutMs 判定断线. PLC 支持原样回传时可打开 heartbeatEcho 测量往返时延,
+// 回传超时也立即断开重连; 回传从报文边界开始匹配, 匹配到的字节不交给 onRecv
+// 断线判定时间(默认参数): 有未确认数据时约 userTimeoutMs(500ms); 空闲链路为 heartbeatMs + userTimeoutMs, 约 700ms,
+// 打开 heartbeatEcho 时取其与 heartbeatMs + heartbeatTimeoutMs 的较小者; keepalive 只作兜底 (Linux 按秒取整, 约 3 秒)
+// send() 可在任意线程调用: 报文写入连接的 MPSC 队列后唤醒事件循环, 事件循环线程是每个连接唯一的写者,
+// 每次唤醒把队列中全部报文合并到一次 send 写出; 队列满或报文超长时退到加锁的溢出缓冲区, 不丢弃
+// 送达保证: 报文属于连接而不是某一次连接. 未连接时 send() 照常入队; 连接断开时尚未整条交给内核的报文(写了一半的也算)
+// 按原顺序保留, 重连后在 onConnected 之后最先写出, 写了一半的报文从头重发. 只有超过 send() 给出的 expireNs
+// (包裹 TTL/截止时间) 仍未写出的报文才丢弃, 计入 unsentDrops; 待发字节超过 maxPendingBytes 时 send() 返回 false.
+// 已交给内核但随断线丢失的报文引擎无法得知, 由调用方重发; stop() 丢弃全部待发报文
+// 调用方自己能重放的报文(STD/GK 由 AckTracker 登记)以 expireNs = kThisConnection 发送: 只属于入队时的那一次连接,
+// 未连接时 send() 返回 false, 断线时未写出的丢弃, 由调用方在 onConnected 中按顺序整窗重发, 避免与引擎保留的副本重复
+// 接收回调在事件循环线程执行, 回调内不能阻塞
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include "latencyhistogram.h"
+
+class PlcIoEngine {
+public:
+    enum class ConnState : int {
+        Disconnected = 0,   // 未连接, 等待下次重连
+        Connecting,         // 非阻塞 connect 进行中
+        Connected,
+    };
+    static const char* stateName(ConnState s);
+
+    using RecvFn = std::function<void(const char* data, size_t len)>;
+    using ConnectedFn = std::function<void()>;
+    using TickFn = std::function<void(int64_t nowMs)>;
+    using WireFn = std::function<void(int tag, int64_t originNs, int64_t wireNs)>;
+    using DrainedFn = std::function<void()>;
+
+    struct Options {
+        int reconnectMs = 3000;                 // 断开后首次重连间隔, 连续失败时逐次翻倍
+        int reconnectMaxMs = 30000;             // 重连间隔上限
+        int connectTimeoutMs = 3000;            // connect 超时
+        int heartbeatMs = 200;                  // 链路空闲(无发送)多久发一次心跳, 0 为关闭
+        std::string heartbeat = "0000000000000000#"; // 心跳报文, 与原 connectStatus 探测内容一致; 不以 '#' 结尾时 setOptions 补上
+        bool heartbeatEcho = false;             // PLC 原样回传心跳时打开, 用于测量往返时延和快速判定断线, 回传不会交给 onRecv
+        int heartbeatTimeoutMs = 300;           // 打开 heartbeatEcho 时, 心跳发出后多久未回传判定断线
+        int keepaliveIdleMs = 1000;             // TCP keepalive: 空闲多久开始探测, 0 为不设置 (Linux 按秒取整)
+        int keepaliveIntervalMs = 300;          // 探测间隔
+        int keepaliveCount = 3;                 // 连续几次探测无响应判定断线 (仅 Linux 可设置)
+        int userTimeoutMs = 500;                // 已发数据多久未被确认判定断线, 0 为系统默认
+        size_t sendQueueFrames = 1024;          // 单个连接发送队列槽位数, 在 addConnection 之前设置
+        size_t maxPendingBytes = 1 << 20;       // 单个连接待发字节上限(含断线期间保留的报文), 超出的 send 被丢弃
+    };
+
+    struct ConnStats {
+        std::string name;
+        ConnState state = ConnState::Disconnected;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+        uint64_t framesIn = 0;                  // 以 '#' 结尾的报文数
+        uint64_t framesOut = 0;
+        uint64_t connects = 0;                  // 连接成功次数
+        uint64_t connectFailures = 0;           // 连接失败/超时次数
+        uint64_t disconnects = 0;               // 已连接后断开次数
+        uint64_t sendDrops = 0;                 // 引擎未运行或待发字节超限被拒绝的 send 次数
+        uint64_t unsentDrops = 0;               // 写出前已超过 expireNs, 所属连接已断开(kThisConnection), 或引擎停止时未写出而丢弃的报文数
+        uint64_t carriedOver = 0;               // 断线时未写出、保留到重连后写出的报文数
+        uint64_t pendingBytes = 0;              // 待发字节数
+        uint64_t queuedFrames = 0;              // 发送队列中尚未取走的报文数
+        uint64_t queueOverflows = 0;            // 队列满或超长, 走溢出缓冲区的 send 次数
+        uint64_t flushes = 0;                   // 合并写出的批次数, framesOut / flushes 为平均合并条数
+        int64_t uptimeMs = 0;                   // 当前连接已持续的时间, 未连接为 0
+        uint64_t reconnects = 0;                // 首次连接之后的重连成功次数
+        uint64_t heartbeatsSent = 0;
+        uint64_t heartbeatTimeouts = 0;         // 心跳回传超时断开的次数
+    };
+
+    PlcIoEngine();
+    ~PlcIoEngine();
+    PlcIoEngine(const PlcIoEngine&) = delete;
+    PlcIoEngine& operator=(const PlcIoEngine&) = delete;
+
+    void setOptions(const Options& opt);
+
+    // 在 start() 之前添加连接, 返回连接编号
+    int addConnection(const std::string& name, const std::string& ip, uint16_t port, RecvFn onRecv);
+    // 每次连接建立后在事件循环线程回调, 用于丢弃上一条连接遗留的接收状态(如半帧), 在 start() 之前设置
+    void setOnConnected(int conn, ConnectedFn fn);
+    // 带 originNs 的报文整条交给内核时在事件循环线程回调, tag 为 send() 传入的值, 用于按调用方的维度统计, 在 start() 之前设置
+    void setOnWire(int conn, WireFn fn);
+    // 连接的待发数据全部交给内核(待发字节为 0)时在事件循环线程回调, 用于让上游在写者空闲时再取下一批, 在 start() 之前设置
+    void setOnDrained(int conn, DrainedFn fn);
+    // 事件循环线程中每 intervalMs 调用一次, 用于应答超时重发等定时任务, 回调内不能阻塞, 在 start() 之前设置
+    void setTicker(int intervalMs, TickFn fn);
+
+    bool start();                               // 启动事件循环线程, 所有连接立即开始连接
+    void stop();                                // 停止线程并关闭全部连接
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // 线程安全; 引擎未运行或待发字节超过 maxPendingBytes 时返回 false, 未连接时照常入队, 重连后写出, 见文件头的送达保证
+    // originNs 为报文的起始时间(nowNs() 时钟, 如触发回复的报文的接收时间), 大于 0 时另外统计起始到写出内核的延时, 并带 tag 回调 onWire
+    // expireNs 为报文的失效时间(nowNs() 时钟), 到时仍未写出则丢弃; 0 为一直保留到写出; kThisConnection 见文件头
+    static constexpr int64_t kThisConnection = -1;
+    bool send(int conn, std::string_view data, int64_t originNs = 0, int tag = 0, int64_t expireNs = 0);
+    bool connected(int conn) const;
+    uint64_t pendingBytes(int conn) const;      // 已入队尚未交给内核的字节数(含断线期间保留的报文), 线程安全
+    ConnStats stats(int conn) const;
+    // send() 入队到数据全部交给内核的延时, 取出后清零
+    LatencyHistogram::Summary takeWireLatency(int conn);
+    // 带 originNs 的报文从起始时间到交给内核的延时, 取出后清零
+    LatencyHistogram::Summary takeOriginLatency(int conn);
+    static int64_t nowNs();                     // 单调时钟纳秒, originNs 使用此时钟
+    // 心跳发出到收到回传的往返时延(需打开 heartbeatEcho), 取出后清零
+    LatencyHistogram::Summary takeHeartbeatRtt(int conn);
+    size_t connectionCount() const { return conns_.size(); }
+
+private:
+    struct Conn;
+    struct Poller;
+
+    void loop();
+    void wake();
+    void beginConnect(Conn& c, int64_t nowMs);
+    void finishConnect(Conn& c, int64_t nowMs);
+    void handleRead(Conn& c, int64_t nowMs);
+    void takeQueued(Conn& c, int64_t nowNs);
+    size_t keepUnsent(Conn& c, int64_t nowNs);
+    size_t discardQueued(Conn& c);
+    void flush(Conn& c, int64_t nowMs);
+    void closeConn(Conn& c, int64_t nowMs, const std::string& reason);
+    void receive(Conn& c, const char* p, size_t n);
+    void deliver(Conn& c, const char* p, size_t n);
+    void runTimers(int64_t nowMs);
+    int64_t reconnectDelayMs(int failStreak);
+    int nextTimeoutMs(int64_t nowMs) const;
+
+    Options opt_;
+    std::vector<std::unique_ptr<Conn>> conns_;
+    std::unique_ptr<Poller> poller_;            // 第一次 start() 时创建, 析构时才关闭, 停止期间的 send() 唤醒它也安全
+    std::thread thread_;
+    int tickMs_ = 0;
+    TickFn tickFn_;
+    int64_t nextTickMs_ = 0;
+    uint64_t jitterState_ = 0;                  // 重连抖动的随机数状态, 只在事件循环线程使用
+    std::atomic<bool> running_{ false };
+    std::atomic<bool> wakePending_{ false };
+};
+
+#endif // PLCIOENGINE_H
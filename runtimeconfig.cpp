@@ -0,0 +1,67 @@
+#include "runtimeconfig.h"
+#include "logger.h"
+#include <fstream>
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+bool load_RuntimeConfig(const std::string& path, RuntimeConfig& cfg) {
+    std::ifstream ifs(path);
+    if (!ifs) return false;
+    json j;
+    try {
+        ifs >> j;
+        if (!j.contains("dataprocess")) return true;                //未配置, 全部使用默认值
+        const json& d = j.at("dataprocess");
+        cfg.supplyShards = d.value("supply_shards", cfg.supplyShards);
+        cfg.supplyBatch = d.value("supply_batch", cfg.supplyBatch);
+        cfg.statsIntervalSec = d.value("stats_interval_s", cfg.statsIntervalSec);
+        cfg.dedupWindowMs = d.value("dedup_window_ms", cfg.dedupWindowMs);
+        cfg.dedupCapacity = d.value("dedup_capacity", cfg.dedupCapacity);
+        cfg.rxTimestamps = d.value("rx_timestamps", cfg.rxTimestamps);
+        cfg.supplyWait = d.value("supply_wait", cfg.supplyWait);
+        cfg.unloadWait = d.value("unload_wait", cfg.unloadWait);
+        cfg.slotStatusWait = d.value("slot_status_wait", cfg.slotStatusWait);
+        cfg.overflowPolicy = d.value("overflow_policy", cfg.overflowPolicy);
+        cfg.spillDir = d.value("spill_dir", cfg.spillDir);
+        cfg.spillMb = d.value("spill_mb", cfg.spillMb);
+        cfg.plcReconnectMs = d.value("plc_reconnect_ms", cfg.plcReconnectMs);
+        cfg.plcReconnectMaxMs = d.value("plc_reconnect_max_ms", cfg.plcReconnectMaxMs);
+        cfg.plcConnectTimeoutMs = d.value("plc_connect_timeout_ms", cfg.plcConnectTimeoutMs);
+        cfg.plcHeartbeatMs = d.value("plc_heartbeat_ms", cfg.plcHeartbeatMs);
+        cfg.plcHeartbeat = d.value("plc_heartbeat", cfg.plcHeartbeat);
+        cfg.plcHeartbeatEcho = d.value("plc_heartbeat_echo", cfg.plcHeartbeatEcho);
+        cfg.plcHeartbeatTimeoutMs = d.value("plc_heartbeat_timeout_ms", cfg.plcHeartbeatTimeoutMs);
+        cfg.plcKeepaliveIdleMs = d.value("plc_keepalive_idle_ms", cfg.plcKeepaliveIdleMs);
+        cfg.plcKeepaliveIntervalMs = d.value("plc_keepalive_interval_ms", cfg.plcKeepaliveIntervalMs);
+        cfg.plcUserTimeoutMs = d.value("plc_user_timeout_ms", cfg.plcUserTimeoutMs);
+        cfg.ackTimeoutMs = d.value("ack_timeout_ms", cfg.ackTimeoutMs);
+        cfg.ackRetries = d.value("ack_retries", cfg.ackRetries);
+        cfg.ackWindow = d.value("ack_window", cfg.ackWindow);
+        cfg.unloadRepeatWindowMs = d.value("unload_repeat_window_ms", cfg.unloadRepeatWindowMs);
+        cfg.routeWorkers = d.value("route_workers", cfg.routeWorkers);
+        cfg.routeQueue = d.value("route_queue", cfg.routeQueue);
+        cfg.routeOverflow = d.value("route_overflow", cfg.routeOverflow);
+        cfg.persistWorkers = d.value("persist_workers", cfg.persistWorkers);
+        cfg.persistQueue = d.value("persist_queue", cfg.persistQueue);
+        cfg.persistOverflow = d.value("persist_overflow", cfg.persistOverflow);
+        cfg.reportWorkers = d.value("report_workers", cfg.reportWorkers);
+        cfg.reportQueue = d.value("report_queue", cfg.reportQueue);
+        cfg.reportOverflow = d.value("report_overflow", cfg.reportOverflow);
+        cfg.parcelStateShards = d.value("parcel_state_shards", cfg.parcelStateShards);
+        cfg.parcelStateQueue = d.value("parcel_state_queue", cfg.parcelStateQueue);
+        cfg.parcelTtlSec = d.value("parcel_ttl_sec", cfg.parcelTtlSec);
+        cfg.expiryMaxPerTick = d.value("expiry_max_per_tick", cfg.expiryMaxPerTick);
+        cfg.parcelExpiryTable = d.value("parcel_expiry_table", cfg.parcelExpiryTable);
+        if (d.contains("slot_deadline_ms")) {                       //数字或按供包台排列的数组
+            const json& v = d.at("slot_deadline_ms");
+            if (v.is_array() && !v.empty()) cfg.slotDeadlineMs = v.get<std::vector<int>>();
+            else if (v.is_number()) cfg.slotDeadlineMs = { v.get<int>() };
+        }
+    }
+    catch (const std::exception& e) {
+        Logger::getInstance().Log("Runtime configuration parse error: " + std::string(e.what()));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef RUNTIMECONFIG_H
+#define RUNTIMECONFIG_H
+
+#include <string>
+#include <vector>
+
+// config.json 中 "dataprocess" 段, 未配置的字段使用默认值
+struct RuntimeConfig
+{
+    int supplyShards = 1;                   //读码处理分片数, 单个接收线程按供包台号分发, 同一供包台固定在一个分片
+    int supplyBatch = 32;                   //每次系统调用最多接收的报文数
+    int statsIntervalSec = 60;              //统计日志输出间隔(秒), 0 为关闭
+    int dedupWindowMs = 500;                //重复读码抑制窗口(毫秒), 0 为关闭
+    int dedupCapacity = 4096;               //每个分片窗口内最多记录的单号数
+    bool rxTimestamps = true;               //读码报文使用内核收包时间戳(SO_TIMESTAMPNS, 仅 Linux), 用于读码到下发的延时统计
+    std::string supplyWait = "block";       //各 ring 消费线程空闲时的等待方式: spin / yield / block
+    std::string unloadWait = "block";
+    std::string slotStatusWait = "block";
+    std::string overflowPolicy = "drop";    //ring 满时的处理: drop 丢弃计数 / spill 写入溢出文件, ring 空后按顺序读回
+    std::string spillDir = "spill";         //溢出文件目录
+    int spillMb = 64;                       //每个 ring 的溢出文件大小(MB), 写满后丢弃
+    int plcReconnectMs = 3000;              //PLC 连接断开后的首次重连间隔, 连续失败时指数退避
+    int plcReconnectMaxMs = 30000;          //PLC 重连间隔上限
+    int plcConnectTimeoutMs = 3000;         //PLC 连接超时
+    int plcHeartbeatMs = 200;               //PLC 链路空闲多久发一次心跳, 0 为关闭; 心跳让空闲链路也在 plc_user_timeout_ms 内判定断线
+    std::string plcHeartbeat = "0000000000000000#";    //心跳报文, 须为 PLC 会忽略的独立报文, 不以 '#' 结尾时自动补上
+    bool plcHeartbeatEcho = false;          //PLC 会原样回传心跳时打开, 测量心跳往返时延并在回传超时后断开重连; 回传在引擎内去掉, 不进解码器
+    int plcHeartbeatTimeoutMs = 300;        //心跳回传超时
+    int plcKeepaliveIdleMs = 1000;          //TCP keepalive 空闲探测起始时间, 0 为不启用 (Linux 按秒取整)
+    int plcKeepaliveIntervalMs = 300;       //TCP keepalive 探测间隔
+    int plcUserTimeoutMs = 500;             //已发数据(含心跳)多久未被确认判定断线, 0 为系统默认
+    int ackTimeoutMs = 500;                 //STD/GK 发出后等待 PLC 应答的时间, 超时重发
+    int ackRetries = 2;                     //超时重发次数, 0 为只统计不重发
+    int ackWindow = 256;                    //每个端口在途(未应答)报文上限
+    int unloadRepeatWindowMs = 2000;        //下件帧在此时间内重复出现计为 PLC 重发, 只回复不再处理, 0 为不检测
+    int routeWorkers = 4;                   //路由阶段线程数(写入读码记录并取格口, 请求段码或下发 GK), 与落库阶段共用数据库连接池
+    int routeQueue = 4096;                  //路由阶段队列上限
+    int routeOverflow = 65536;              //路由队列满后的溢出区条数, 读码/格口结果线程不等待, 溢出区满才丢弃并记录
+    int persistWorkers = 2;                 //落库阶段线程数(只写库: 更新格口, 回收记录), 不影响 GK 下发
+    int persistQueue = 4096;                //落库阶段队列上限
+    int persistOverflow = 65536;            //落库队列满后的溢出区条数, 格口结果线程不等待, 溢出区满才丢弃并记录
+    int reportWorkers = 2;                  //回传阶段线程数(下件后的数据库查询和接口调用)
+    int reportQueue = 4096;                 //回传阶段队列上限
+    int reportOverflow = 65536;             //回传队列满后的溢出区条数, 下件线程不等待, 溢出区满才丢弃并记录
+    int parcelStateShards = 2;              //包裹状态分片数, 每个分片一个线程, 按供包台分配, 各分片只存本分片供包台的记录
+    int parcelStateQueue = 4096;            //每个分片的操作队列容量, 满时调用方等待
+    int parcelTtlSec = 1800;                //读码后超过此时间仍未下件的包裹从内存中回收(秒), 0 为不回收
+    int expiryMaxPerTick = 100;             //每个包裹状态分片每秒最多回收的包裹数, 超出的顺延到下一秒, 0 为不限制
+    std::string parcelExpiryTable = "";     //回收的包裹写入该表(需预先建表: code, weight, supply_id, supply_order, slot_id, age_sec, expire_time, operate_type), 空为只记日志
+    std::vector<int> slotDeadlineMs{3000};  //读码到包裹经过分拣口前 GK 必须送达的时间(毫秒), 按供包台号依次配置, 只配一个时所有供包台共用
+};
+
+bool load_RuntimeConfig(const std::string& path, RuntimeConfig& cfg);
+
+#endif // RUNTIMECONFIG_H
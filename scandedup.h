@@ -0,0 +1,120 @@
+#ifndef SCANDEDUP_H
+#define SCANDEDUP_H
+
+// 读码重复抑制: 同一 (单号, 供包台) 在窗口时间内只放行第一次
+// 固定内存: 条目存放在时间轮节点池中, 开放寻址哈希表只存节点句柄; 到期由时间轮回收
+// 非线程安全, 每个接收分片持有一个实例
+
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include "timingwheel.h"
+
+class ScanDedup {
+public:
+    static constexpr size_t kMaxCode = 32;
+
+    ScanDedup(size_t capacity, int64_t windowMs)
+        : windowMs_(windowMs),
+          wheel_(std::max<size_t>(1, capacity), static_cast<size_t>(std::max<int64_t>(1, windowMs / kTickMs + 2)), kTickMs)
+    {
+        size_t buckets = 16;
+        while (buckets < capacity * 2) buckets <<= 1;
+        index_.assign(buckets, Wheel::kInvalid);
+        mask_ = buckets - 1;
+    }
+
+    bool enabled() const { return windowMs_ > 0; }
+
+    // 返回 true 表示该单号在窗口内已从同一供包台出现过, 调用方应丢弃
+    bool isDuplicate(std::string_view code, int station, int64_t nowMs) {
+        if (!enabled() || code.size() > kMaxCode) return false;
+        wheel_.advance(nowMs, [this](const Entry& e) { erase(e); });
+        uint64_t h = hashKey(code, station);
+        for (size_t i = h & mask_;; i = (i + 1) & mask_) {
+            Wheel::Handle handle = index_[i];
+            if (handle == Wheel::kInvalid) break;
+            const Entry& e = wheel_.at(handle);
+            if (e.hash == h && e.station == station && std::string_view(e.code, e.len) == code) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        Entry e{};
+        e.hash = h;
+        e.station = station;
+        e.len = static_cast<uint8_t>(code.size());
+        std::memcpy(e.code, code.data(), code.size());
+        Wheel::Handle handle = wheel_.schedule(nowMs, windowMs_, e);
+        if (handle == Wheel::kInvalid) {                                    // 容量已满, 放行不记录
+            overflow_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        size_t i = h & mask_;
+        while (index_[i] != Wheel::kInvalid) i = (i + 1) & mask_;
+        index_[i] = handle;
+        live_.store(wheel_.size(), std::memory_order_relaxed);
+        return false;
+    }
+
+    uint64_t suppressed() const { return suppressed_.load(std::memory_order_relaxed); }
+    uint64_t overflow() const { return overflow_.load(std::memory_order_relaxed); }
+    size_t live() const { return live_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int64_t kTickMs = 10;
+
+    struct Entry {
+        uint64_t hash;
+        int station;
+        uint8_t len;
+        char code[kMaxCode];
+    };
+    using Wheel = TimingWheel<Entry>;
+
+    static uint64_t hashKey(std::string_view code, int station) {
+        uint64_t h = 1469598103934665603ull;                               // FNV-1a
+        for (char c : code) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        h ^= static_cast<uint64_t>(station) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+    }
+
+    // 到期条目从哈希表删除, 线性探测用后移删除保持探测链连续
+    void erase(const Entry& e) {
+        size_t i = e.hash & mask_;
+        while (index_[i] != Wheel::kInvalid) {
+            const Entry& cur = wheel_.at(index_[i]);
+            if (!wheel_.active(index_[i]) && cur.hash == e.hash && cur.station == e.station
+                && std::string_view(cur.code, cur.len) == std::string_view(e.code, e.len)) {
+                break;
+            }
+            i = (i + 1) & mask_;
+        }
+        if (index_[i] == Wheel::kInvalid) return;
+        size_t hole = i;
+        for (size_t j = (hole + 1) & mask_; index_[j] != Wheel::kInvalid; j = (j + 1) & mask_) {
+            size_t home = wheel_.at(index_[j]).hash & mask_;
+            bool movable = (hole <= j) ? (home <= hole || home > j) : (home <= hole && home > j);
+            if (movable) {
+                index_[hole] = index_[j];
+                hole = j;
+            }
+        }
+        index_[hole] = Wheel::kInvalid;
+        live_.store(wheel_.size(), std::memory_order_relaxed);
+    }
+
+    int64_t windowMs_;
+    Wheel wheel_;
+    std::vector<Wheel::Handle> index_;
+    size_t mask_ = 0;
+    std::atomic<uint64_t> suppressed_{ 0 };
+    std::atomic<uint64_t> overflow_{ 0 };
+    std::atomic<size_t> live_{ 0 };
+};
+
+#endif // SCANDEDUP_H
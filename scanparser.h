@@ -0,0 +1,157 @@
+#ifndef SCANPARSER_H
+#define SCANPARSER_H
+
+// 读码平台报文解析: "单号,重量(kg),供包台号", 例如 "JT5412345678901,1.25,3\r\n"
+// 全程在 string_view 上操作, 数字用 from_chars 解析, 不抛异常也不做堆分配
+// 只有 Empty/MissingField/BadStation 无法确定供包台; 单号或重量出错(EmptyCode/CodeTooLong/BadWeight)时 stationId 仍然有效,
+// 包裹已在供包台上, 调用方应照常上件并按异常件分拣
+
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include "simdscan.h"
+
+enum class ScanParseError {
+    Ok = 0,
+    Empty,              // 空报文
+    MissingField,       // 字段不足 3 个
+    EmptyCode,          // 单号为空
+    CodeTooLong,        // 单号超过 ScanRecord::kMaxCode
+    BadWeight,          // 重量不是非负小数
+    BadStation,         // 供包台号不是整数
+};
+
+inline const char* scanParseErrorName(ScanParseError e) {
+    switch (e) {
+    case ScanParseError::Ok: return "ok";
+    case ScanParseError::Empty: return "empty";
+    case ScanParseError::MissingField: return "missing field";
+    case ScanParseError::EmptyCode: return "empty code";
+    case ScanParseError::CodeTooLong: return "code too long";
+    case ScanParseError::BadWeight: return "bad weight";
+    case ScanParseError::BadStation: return "bad station";
+    }
+    return "unknown";
+}
+
+struct ScanRecord {
+    static constexpr size_t kMaxCode = 32;
+    char code[kMaxCode];
+    uint8_t codeLen = 0;
+    int32_t weightGrams = 0;            // 重量, 单位克
+    int stationId = -1;                 // 供包台号
+
+    std::string_view codeView() const { return std::string_view(code, codeLen); }
+};
+
+namespace scanparser_detail {
+
+inline std::string_view trim(std::string_view s) {
+    size_t b = 0, e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t')) ++b;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r' || s[e - 1] == '\n')) --e;
+    return s.substr(b, e - b);
+}
+
+// "1.25" -> 1250, 小数点后超过 3 位的部分截断; 空字段视为 0
+inline bool parseWeightGrams(std::string_view s, int32_t& out) {
+    s = trim(s);
+    out = 0;
+    if (s.empty()) return true;
+    const char* p = s.data();
+    const char* end = p + s.size();
+    int32_t kg = 0;
+    if (*p != '.') {
+        auto [next, ec] = std::from_chars(p, end, kg);
+        if (ec != std::errc() || kg < 0 || kg > 1000000) return false;
+        p = next;
+    }
+    int32_t frac = 0;
+    if (p != end) {
+        if (*p != '.') return false;
+        ++p;
+        int digits = 0;
+        for (; p != end; ++p) {
+            if (*p < '0' || *p > '9') return false;
+            if (digits < 3) {
+                frac = frac * 10 + (*p - '0');
+                ++digits;
+            }
+        }
+        for (; digits < 3; ++digits) frac *= 10;
+    }
+    out = kg * 1000 + frac;
+    return true;
+}
+
+} // namespace scanparser_detail
+
+inline ScanParseError parseScanMessage(std::string_view msg, ScanRecord& out) {
+    using namespace scanparser_detail;
+    out.codeLen = 0;
+    out.weightGrams = 0;
+    out.stationId = -1;
+    if (msg.empty()) return ScanParseError::Empty;
+
+    const char* p = msg.data();
+    const size_t n = msg.size();
+    size_t c1 = simdscan::find(p, n, ',');
+    if (c1 == n) return ScanParseError::MissingField;
+    size_t c2 = c1 + 1 + simdscan::find(p + c1 + 1, n - c1 - 1, ',');
+    if (c2 >= n) return ScanParseError::MissingField;
+    size_t stBegin = c2 + 1;
+    size_t stEnd = stBegin + simdscan::find2(p + stBegin, n - stBegin, ',', '\r');      // 第三个字段到下一个 ',' 或行尾
+
+    std::string_view station = trim(std::string_view(p + stBegin, stEnd - stBegin));
+    int stationId = -1;
+    auto [next, ec] = std::from_chars(station.data(), station.data() + station.size(), stationId);
+    if (station.empty() || ec != std::errc() || next != station.data() + station.size()) return ScanParseError::BadStation;
+    out.stationId = stationId;
+
+    std::string_view code(p, c1);
+    if (code.empty()) return ScanParseError::EmptyCode;
+    if (code.size() > ScanRecord::kMaxCode) return ScanParseError::CodeTooLong;
+    std::memcpy(out.code, code.data(), code.size());
+    out.codeLen = static_cast<uint8_t>(code.size());
+
+    if (!parseWeightGrams(std::string_view(p + c1 + 1, c2 - c1 - 1), out.weightGrams)) {      // 单号仍然有效
+        out.weightGrams = 0;
+        return ScanParseError::BadWeight;
+    }
+    return ScanParseError::Ok;
+}
+
+// 只取供包台号, 用于接收线程按供包台分发; 无法确定时返回 -1
+inline int peekScanStation(std::string_view msg) {
+    const char* p = msg.data();
+    const size_t n = msg.size();
+    size_t c1 = simdscan::find(p, n, ',');
+    if (c1 == n) return -1;
+    size_t c2 = c1 + 1 + simdscan::find(p + c1 + 1, n - c1 - 1, ',');
+    if (c2 >= n) return -1;
+    size_t stBegin = c2 + 1;
+    size_t stEnd = stBegin + simdscan::find2(p + stBegin, n - stBegin, ',', '\r');
+    std::string_view station = scanparser_detail::trim(std::string_view(p + stBegin, stEnd - stBegin));
+    int stationId = -1;
+    auto [next, ec] = std::from_chars(station.data(), station.data() + station.size(), stationId);
+    if (station.empty() || ec != std::errc() || next != station.data() + station.size()) return -1;
+    return stationId;
+}
+
+// 克 -> "1.25" 形式的公斤字符串(去掉末尾的 0), 写入调用方提供的缓冲区
+inline std::string_view formatWeightKg(int32_t grams, char (&buf)[24]) {
+    if (grams < 0) grams = 0;
+    auto [p, ec] = std::to_chars(buf, buf + sizeof(buf), grams / 1000);
+    int32_t frac = grams % 1000;
+    if (frac) {
+        *p++ = '.';
+        char digits[3] = { char('0' + frac / 100), char('0' + frac / 10 % 10), char('0' + frac % 10) };
+        int len = 3;
+        while (len > 0 && digits[len - 1] == '0') --len;
+        for (int i = 0; i < len; ++i) *p++ = digits[i];
+    }
+    return std::string_view(buf, static_cast<size_t>(p - buf));
+}
+
+#endif // SCANPARSER_H
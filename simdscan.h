@@ -0,0 +1,56 @@
+#ifndef SIMDSCAN_H
+#define SIMDSCAN_H
+
+// 字符查找辅助函数: x86-64 下使用 SSE2 每次比较 16 字节, 其他平台退化为逐字节查找
+// 用于读码报文的 ',' / '\r' 切分以及 PLC 报文的 '#' 切分
+
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SIMDSCAN_SSE2 1
+#endif
+
+namespace simdscan {
+
+// 返回 p[0..n) 中第一个等于 a 的位置, 没有则返回 n
+inline size_t find(const char* p, size_t n, char a) {
+    size_t i = 0;
+#ifdef SIMDSCAN_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, va)));
+        if (mask) return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+#endif
+    for (; i < n; ++i) {
+        if (p[i] == a) return i;
+    }
+    return n;
+}
+
+// 返回 p[0..n) 中第一个等于 a 或 b 的位置, 没有则返回 n
+inline size_t find2(const char* p, size_t n, char a, char b) {
+    size_t i = 0;
+#ifdef SIMDSCAN_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (mask) return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+#endif
+    for (; i < n; ++i) {
+        if (p[i] == a || p[i] == b) return i;
+    }
+    return n;
+}
+
+} // namespace simdscan
+
+#endif // SIMDSCAN_H
@@ -0,0 +1,97 @@
+#include "slotscheduler.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+
+SlotScheduler::~SlotScheduler() {
+    stop();
+}
+
+int64_t SlotScheduler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void SlotScheduler::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&SlotScheduler::run, this);
+}
+
+void SlotScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!running_.exchange(false)) return;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    size_t left = 0;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        left = heap_.size();
+        heap_.clear();
+    }
+    depth_.store(0, std::memory_order_relaxed);
+    if (left > 0) {
+        discarded_.fetch_add(left, std::memory_order_relaxed);
+        Logger::getInstance().Log("----[SlotScheduler] stop() discard unsent commands: [" + std::to_string(left) + "]");
+    }
+}
+
+bool SlotScheduler::submit(Command cmd) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (!running_.load(std::memory_order_relaxed)) return false;
+        cmd.seq = nextSeq_++;
+        heap_.push_back(std::move(cmd));
+        std::push_heap(heap_.begin(), heap_.end(), Later());
+        depth_.store(heap_.size(), std::memory_order_relaxed);
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void SlotScheduler::kick() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);                         //与发送线程检查 ready() 互斥, 唤醒不会丢失
+    }
+    cv_.notify_one();
+}
+
+void SlotScheduler::run() {
+    std::vector<Command> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this] {
+                if (!running_.load(std::memory_order_relaxed)) return true;
+                return !heap_.empty() && (!ready_ || ready_());         //写者有待发数据时继续在堆中积累
+            });
+            if (!running_.load(std::memory_order_relaxed)) return;
+            while (!heap_.empty()) {                                    //全部取出, 按截止时间从早到晚
+                std::pop_heap(heap_.begin(), heap_.end(), Later());
+                batch.push_back(std::move(heap_.back()));
+                heap_.pop_back();
+            }
+            depth_.store(0, std::memory_order_relaxed);
+        }
+        uint64_t n = batch.size();
+        uint64_t cur = maxDepth_.load(std::memory_order_relaxed);
+        while (n > cur && !maxDepth_.compare_exchange_weak(cur, n, std::memory_order_relaxed)) {}
+        uint64_t maxSeq = 0;
+        for (Command& cmd : batch) {
+            if (cmd.seq < maxSeq) reordered_.fetch_add(1, std::memory_order_relaxed);
+            maxSeq = std::max(maxSeq, cmd.seq);
+            bool sent = false;
+            try {
+                sent = send_ && send_(cmd);
+            }
+            catch (...) {}
+            if (onSent_) {
+                try {
+                    onSent_(cmd, sent, nowNs());
+                }
+                catch (...) {}
+            }
+        }
+        batch.clear();
+    }
+}
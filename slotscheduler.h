@@ -0,0 +1,85 @@
+#ifndef SLOTSCHEDULER_H
+#define SLOTSCHEDULER_H
+
+// GK 格口报文调度: 每条报文带截止时间(读码时间 + 该供包台到分拣口的时间), 按截止时间最早优先发送
+// submit() 可在任意线程调用, 报文进入按截止时间排序的最小堆; 发送线程只在下游写者空闲(ready() 为 true, 如 2062 连接
+// 没有待发字节)时把堆中全部报文按截止时间顺序取出并发送. 写者忙时报文留在堆中, 截止时间早的后到报文可以排到前面;
+// 写者写完后调用 kick() 唤醒发送线程. 迟到统计在报文实际写出时由调用方计算
+// 时间统一为系统时钟纳秒, 与读码接收时间 (UdpReceiver::wallNowNs) 同一基准
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+class SlotScheduler {
+public:
+    struct Command {
+        int64_t deadlineNs = 0;             // 截止时间, 0 为立即发送且不统计迟到
+        int64_t scanNs = 0;                 // 读码接收时间, 0 为未知
+        int stationId = 0;                  // 供包台号 1..stationCount, 0 为未知
+        std::string frame;                  // 完整报文, 含 '#'
+        uint64_t seq = 0;                   // 入队序号, 截止时间相同时先进先出, 由 submit 填写
+    };
+    // 在发送线程中调用, 返回 false 表示发送失败(如 PLC 未连接)
+    using SendFn = std::function<bool(const Command& cmd)>;
+    // 发送后在发送线程中回调, sentNs 为发送时间
+    using SentFn = std::function<void(const Command& cmd, bool sent, int64_t sentNs)>;
+    // 在发送线程中调用(持有内部锁, 不能阻塞), 返回 false 时报文留在堆中, 等 kick() 后再检查
+    using ReadyFn = std::function<bool()>;
+
+    SlotScheduler() = default;
+    ~SlotScheduler();
+    SlotScheduler(const SlotScheduler&) = delete;
+    SlotScheduler& operator=(const SlotScheduler&) = delete;
+
+    void setSend(SendFn fn) { send_ = std::move(fn); }      // 在 start() 之前设置
+    void setOnSent(SentFn fn) { onSent_ = std::move(fn); }
+    void setReady(ReadyFn fn) { ready_ = std::move(fn); }   // 在 start() 之前设置, 未设置时总是就绪
+
+    void start();
+    void stop();                                            // 未发送的报文丢弃并计数
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // 线程安全; 未启动时返回 false
+    bool submit(Command cmd);
+
+    // 线程安全; 下游写者变为空闲时调用, 唤醒发送线程重新检查 ready()
+    void kick();
+
+    static int64_t nowNs();
+
+    uint64_t depth() const { return depth_.load(std::memory_order_relaxed); }          // 等待发送的条数
+    uint64_t maxDepth() { return maxDepth_.exchange(0, std::memory_order_relaxed); }   // 本周期一次取出的最大条数, 读取后清零
+    uint64_t reordered() const { return reordered_.load(std::memory_order_relaxed); }  // 因截止时间更早而先于更早入队报文发送的条数
+    uint64_t discarded() const { return discarded_.load(std::memory_order_relaxed); }
+
+private:
+    struct Later {
+        bool operator()(const Command& a, const Command& b) const {
+            if (a.deadlineNs != b.deadlineNs) return a.deadlineNs > b.deadlineNs;
+            return a.seq > b.seq;
+        }
+    };
+    void run();
+
+    SendFn send_;
+    SentFn onSent_;
+    ReadyFn ready_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Command> heap_;             // 按 Later 组织的最小堆, 由 mutex_ 保护
+    uint64_t nextSeq_ = 0;
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<uint64_t> depth_{ 0 };
+    std::atomic<uint64_t> maxDepth_{ 0 };
+    std::atomic<uint64_t> reordered_{ 0 };
+    std::atomic<uint64_t> discarded_{ 0 };
+};
+
+#endif // SLOTSCHEDULER_H
@@ -0,0 +1,134 @@
+#include "spillqueue.h"
+#include "logger.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+SpillQueue::~SpillQueue() {
+    close();
+}
+
+bool SpillQueue::open(const std::string& path, size_t capacityBytes) {
+    close();
+    if (capacityBytes < 4096) capacityBytes = 4096;
+    try {
+        std::filesystem::path p(path);
+        if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+    }
+    catch (const std::filesystem::filesystem_error& e) {
+        Logger::getInstance().Log("----[SpillQueue] open() create directory failed: " + std::string(e.what()));
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        Logger::getInstance().Log("----[SpillQueue] open() CreateFile failed: [" + path + "] error: " + std::to_string(GetLastError()));
+        return false;
+    }
+    ULARGE_INTEGER size;
+    size.QuadPart = capacityBytes;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    if (!mapping) {
+        Logger::getInstance().Log("----[SpillQueue] open() CreateFileMapping failed: [" + path + "] error: " + std::to_string(GetLastError()));
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, capacityBytes);
+    if (!view) {
+        Logger::getInstance().Log("----[SpillQueue] open() MapViewOfFile failed: [" + path + "] error: " + std::to_string(GetLastError()));
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    base_ = static_cast<char*>(view);
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        Logger::getInstance().Log("----[SpillQueue] open() open failed: [" + path + "] " + std::strerror(errno));
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(capacityBytes)) != 0) {
+        Logger::getInstance().Log("----[SpillQueue] open() ftruncate failed: [" + path + "] " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    void* view = ::mmap(nullptr, capacityBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        Logger::getInstance().Log("----[SpillQueue] open() mmap failed: [" + path + "] " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    base_ = static_cast<char*>(view);
+#endif
+    capacity_ = capacityBytes;
+    readPos_ = writePos_ = used_ = 0;
+    Logger::getInstance().Log("----[SpillQueue] open() spill file: [" + path + "] capacity: [" + std::to_string(capacityBytes) + "]");
+    return true;
+}
+
+void SpillQueue::close() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!base_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    ::munmap(base_, capacity_);
+    ::close(fd_);
+    fd_ = -1;
+#endif
+    base_ = nullptr;
+    capacity_ = 0;
+    readPos_ = writePos_ = used_ = 0;
+    depth_.store(0, std::memory_order_release);
+    bytes_.store(0, std::memory_order_relaxed);
+}
+
+bool SpillQueue::append(const void* data, uint32_t len, const void* head, uint32_t headLen) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    uint32_t total = headLen + len;
+    size_t need = sizeof(uint32_t) + total;
+    bool fits = false;
+    bool wrap = false;
+    if (base_ && total < kWrapMark) {
+        if (writePos_ < readPos_) fits = need <= readPos_ - writePos_;              //已回绕, 写位置追着读位置
+        else if (writePos_ > readPos_ || used_ == 0) {
+            fits = need <= capacity_ - writePos_;
+            if (!fits && need <= readPos_) fits = wrap = true;                    //末尾放不下, 文件头已腾出足够空间
+        }
+    }
+    if (!fits) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (wrap) {
+        if (writePos_ + sizeof(uint32_t) <= capacity_) std::memcpy(base_ + writePos_, &kWrapMark, sizeof(kWrapMark));
+        used_ += capacity_ - writePos_;
+        writePos_ = 0;
+    }
+    char* p = base_ + writePos_;
+    std::memcpy(p, &total, sizeof(total));
+    p += sizeof(total);
+    if (headLen) std::memcpy(p, head, headLen);
+    if (len) std::memcpy(p + headLen, data, len);
+    writePos_ += need;
+    used_ += need;
+    bytes_.store(used_, std::memory_order_relaxed);
+    spilled_.fetch_add(1, std::memory_order_relaxed);
+    depth_.fetch_add(1, std::memory_order_release);
+    return true;
+}
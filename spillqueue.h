@@ -0,0 +1,111 @@
+#ifndef SPILLQUEUE_H
+#define SPILLQUEUE_H
+
+// ring 满时的溢出队列: 报文按 [长度(4字节)][内容] 追加到内存映射文件, 消费线程在 ring 为空后按顺序读回
+// 单生产者单消费者; 只有生产者会让队列从空变为非空, 因此 active() 为 false 时生产者可以直接写 ring
+// 非空期间生产者的新报文也必须写入这里, 保证整体先进先出
+// 文件是环形缓冲区: 读回的记录立即腾出空间, 持续积压时写位置追着读位置循环使用; 记录不跨越文件末尾,
+// 末尾放不下时写一个回绕标记(长度为 kWrapMark, 剩余不足 4 字节时省略)后从文件头继续
+// 积压达到文件大小后 append 返回 false, 由调用方计入丢弃
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+class SpillQueue {
+public:
+    SpillQueue() = default;
+    ~SpillQueue();
+    SpillQueue(const SpillQueue&) = delete;
+    SpillQueue& operator=(const SpillQueue&) = delete;
+
+    // 创建(截断)并映射文件, 失败返回 false, 此时 append 始终失败
+    bool open(const std::string& path, size_t capacityBytes);
+    void close();
+    bool isOpen() const { return base_ != nullptr; }
+
+    // 队列中是否还有报文, 生产者据此决定写 ring 还是继续写溢出文件
+    bool active() const { return depth_.load(std::memory_order_acquire) != 0; }
+
+    // 生产者追加一条报文, head/headLen 为可选的前缀(如接收时间), 文件已满或未打开返回 false
+    bool append(const void* data, uint32_t len, const void* head = nullptr, uint32_t headLen = 0);
+
+    // 消费者按顺序取出最多 maxRecords 条, 在锁外逐条调用 fn(const char* data, uint32_t len), 返回条数
+    template<typename Fn>
+    size_t drain(Fn&& fn, size_t maxRecords) {
+        size_t n = 0;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (used_ == 0) return 0;
+            drainBuf_.clear();
+            while (n < maxRecords && used_ > 0) {
+                uint32_t len = readPos_ + sizeof(uint32_t) <= capacity_ ? recordLen(readPos_) : kWrapMark;
+                if (len == kWrapMark) {                                         //回绕: 跳过文件末尾的空隙
+                    used_ -= capacity_ - readPos_;
+                    readPos_ = 0;
+                    continue;
+                }
+                size_t rec = sizeof(uint32_t) + len;
+                drainBuf_.insert(drainBuf_.end(), base_ + readPos_, base_ + readPos_ + rec);
+                readPos_ += rec;
+                used_ -= rec;
+                ++n;
+            }
+            if (used_ == 0) readPos_ = writePos_ = 0;                             //全部读回, 下一条从文件头开始
+            bytes_.store(used_, std::memory_order_relaxed);
+            depth_.fetch_sub(n, std::memory_order_release);
+        }
+        size_t off = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t len = 0;
+            std::memcpy(&len, drainBuf_.data() + off, sizeof(len));
+            off += sizeof(len);
+            fn(drainBuf_.data() + off, len);
+            off += len;
+        }
+        drained_.fetch_add(n, std::memory_order_relaxed);
+        return n;
+    }
+
+    // 统计
+    uint64_t depth() const { return depth_.load(std::memory_order_relaxed); }          //当前积压条数
+    uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }          //当前占用字节数(含回绕空隙)
+    uint64_t spilled() const { return spilled_.load(std::memory_order_relaxed); }      //累计写入条数
+    uint64_t drained() const { return drained_.load(std::memory_order_relaxed); }      //累计读回条数
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }    //文件已满被拒绝的条数
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr uint32_t kWrapMark = 0xFFFFFFFFu;
+
+    uint32_t recordLen(size_t pos) const {
+        uint32_t len = 0;
+        std::memcpy(&len, base_ + pos, sizeof(len));
+        return len;
+    }
+
+    std::mutex mutex_;
+    char* base_ = nullptr;
+    size_t capacity_ = 0;
+    size_t writePos_ = 0;
+    size_t readPos_ = 0;
+    size_t used_ = 0;                           //已占用字节数, 含回绕空隙; 读写位置相等时据此区分空和满
+    std::vector<char> drainBuf_;                //消费者读出的一批记录, 避免在锁内调用回调
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    std::atomic<uint64_t> depth_{ 0 };
+    std::atomic<uint64_t> bytes_{ 0 };
+    std::atomic<uint64_t> spilled_{ 0 };
+    std::atomic<uint64_t> drained_{ 0 };
+    std::atomic<uint64_t> rejected_{ 0 };
+};
+
+#endif // SPILLQUEUE_H
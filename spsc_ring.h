@@ -3,12 +3,44 @@
 
 #include <atomic>
 #include <cstdint>
+#include <string>
 #include <cassert>
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#endif
 
+// 消费者空闲时的等待方式
+//  BusySpin  : 一直自旋, 唤醒延迟最低, 独占一个核
+//  SpinYield : 自旋一段时间后 yield, 延迟低, 空闲时仍有 CPU 占用
+//  Blocking  : 自旋一段时间后在 std::atomic::wait 上休眠(Linux 为 futex, Windows 为 WaitOnAddress), 由生产者唤醒
+enum class RingWaitStrategy { BusySpin, SpinYield, Blocking };
+
+inline RingWaitStrategy parseRingWaitStrategy(const std::string& name) {
+    if (name == "spin") return RingWaitStrategy::BusySpin;
+    if (name == "yield") return RingWaitStrategy::SpinYield;
+    return RingWaitStrategy::Blocking;
+}
+
+inline void ringCpuRelax() {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// 单生产者单消费者环形队列
+//  - head/tail 各占一条缓存行, 生产者和消费者互不伪共享
+//  - 双方各自缓存对端下标, 只有在看起来满/空时才重新读取对端的原子变量
+//  - 槽位对象在构造时创建并循环复用, push/emplace 以移动赋值写入, 不拷贝 std::string / QByteArray
 template<typename T>
 class SpscRing {
 public:
+    static constexpr size_t kCacheLine = 64;
+
     explicit SpscRing(size_t capacity) {
         cap = nextPow2(std::max<size_t>(2, capacity));
         mask = cap - 1;
@@ -19,30 +51,127 @@ public:
     ~SpscRing() {
         delete[] buffer;
     }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
 
     // 非阻塞 push：成功返回 true，满则返回 false （调用方可统计丢弃）
     bool try_push(const T& item) {
-        uint64_t t = tail.load(std::memory_order_relaxed);
-        uint64_t h = head.load(std::memory_order_acquire);
-        if ((t - h) >= cap) return false; // full
-        buffer[t & mask] = item;
-        tail.store(t + 1, std::memory_order_release);
+        T* slot = producerSlot();
+        if (!slot) return false; // full
+        *slot = item;
+        publish(1);
+        return true;
+    }
+    bool try_push(T&& item) {
+        T* slot = producerSlot();
+        if (!slot) return false;
+        *slot = std::move(item);
+        publish(1);
         return true;
     }
+    // 用参数构造元素并移动进槽位
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        T* slot = producerSlot();
+        if (!slot) return false;
+        *slot = T(std::forward<Args>(args)...);
+        publish(1);
+        return true;
+    }
+
+    // 零拷贝生产: 取得最多 max_items 个空闲槽位的指针, 写完后调用 commit(n) 发布前 n 个
+    // 未 commit 的槽位下次 reserve 时会再次返回
+    size_t try_reserve_bulk(T** out, size_t max_items) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t free_slots = cap - (t - prodCachedHead);
+        if (free_slots < max_items) {
+            prodCachedHead = head.load(std::memory_order_acquire);
+            free_slots = cap - (t - prodCachedHead);
+        }
+        size_t n = static_cast<size_t>(std::min<uint64_t>(free_slots, max_items));
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = &buffer[(t + i) & mask];
+        }
+        return n;
+    }
+    void commit(size_t n) {
+        if (!n) return;
+        publish(n);
+    }
+
+    // 零拷贝消费: 取得最多 max_items 个可读槽位的指针, 处理完后调用 release(n) 归还给生产者
+    size_t peek_bulk(T** out, size_t max_items) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(consumerAvail(h, max_items), max_items));
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = &buffer[(h + i) & mask];
+        }
+        return n;
+    }
+    void release(size_t n) {
+        if (!n) return;
+        uint64_t h = head.load(std::memory_order_relaxed);
+        head.store(h + n, std::memory_order_release);
+    }
+
+    // 原地处理最多 max_items 个元素: fn(T&) 直接作用在槽位上, 处理完统一归还, 返回处理数量
+    template<typename Fn>
+    size_t consume(Fn&& fn, size_t max_items = SIZE_MAX) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(consumerAvail(h, max_items), max_items));
+        for (size_t i = 0; i < n; ++i) {
+            fn(buffer[(h + i) & mask]);
+        }
+        if (n) head.store(h + n, std::memory_order_release);
+        return n;
+    }
 
     // pop up to max_items, 返回实际 pop 的数量
     size_t pop_bulk(T* out, size_t max_items) {
         uint64_t h = head.load(std::memory_order_relaxed);
-        uint64_t t = tail.load(std::memory_order_acquire);
-        uint64_t avail = t - h;
-        size_t to_pop = static_cast<size_t>(std::min<uint64_t>(avail, max_items));
+        size_t to_pop = static_cast<size_t>(std::min<uint64_t>(consumerAvail(h, max_items), max_items));
         for (size_t i = 0; i < to_pop; ++i) {
-            out[i] = buffer[(h + i) & mask];
+            out[i] = std::move(buffer[(h + i) & mask]);
         }
         if (to_pop) head.store(h + to_pop, std::memory_order_release);
         return to_pop;
     }
 
+    // 等待方式, 需在消费线程启动前设置
+    void set_wait_strategy(RingWaitStrategy s) { strategy = s; }
+    RingWaitStrategy wait_strategy() const { return strategy; }
+
+    // 等待直到有数据或 running 变为 false, 然后同 peek_bulk / pop_bulk / consume
+    size_t wait_peek_bulk(T** out, size_t max_items, const std::atomic<bool>& running) {
+        if (!wait_readable(running)) return 0;
+        return peek_bulk(out, max_items);
+    }
+    size_t wait_pop_bulk(T* out, size_t max_items, const std::atomic<bool>& running) {
+        if (!wait_readable(running)) return 0;
+        return pop_bulk(out, max_items);
+    }
+    template<typename Fn>
+    size_t wait_consume(Fn&& fn, size_t max_items, const std::atomic<bool>& running) {
+        if (!wait_readable(running)) return 0;
+        return consume(std::forward<Fn>(fn), max_items);
+    }
+
+    // 让等待中(或下一次进入等待)的消费者立即返回 0, 用于停止线程或通知 ring 之外的数据(如溢出文件)
+    void wake() {
+        kicked.store(true, std::memory_order_release);
+        wakeSeq.fetch_add(1, std::memory_order_release);
+        wakeSeq.notify_all();
+    }
+
+    // 唤醒统计: 消费者从空闲到看到新数据的次数和耗时(纳秒), max 读取后清零
+    uint64_t wakeups() const { return wakeCount.load(std::memory_order_relaxed); }
+    uint64_t wake_latency_sum_ns() const { return wakeLatencySumNs.load(std::memory_order_relaxed); }
+    uint64_t take_wake_latency_max_ns() { return wakeLatencyMaxNs.exchange(0, std::memory_order_relaxed); }
+
+    // 容量与占用高水位(发布时的占用量, 以生产者缓存的 head 计算, 略偏大), 高水位读取后清零
+    size_t capacity() const { return cap; }
+    uint64_t take_high_water_mark() { return highWater.exchange(0, std::memory_order_relaxed); }
+
     // 方便监控：当前可用数量
     uint64_t size_approx() const {
         uint64_t h = head.load(std::memory_order_acquire);
@@ -51,12 +180,123 @@ public:
     }
 
 private:
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 生产者取得下一个空闲槽位, 满返回 nullptr
+    T* producerSlot() {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - prodCachedHead >= cap) {
+            prodCachedHead = head.load(std::memory_order_acquire);
+            if (t - prodCachedHead >= cap) return nullptr;
+        }
+        return &buffer[t & mask];
+    }
+
+    void publish(size_t n) {
+        uint64_t t = tail.load(std::memory_order_relaxed) + n;
+        tail.store(t, std::memory_order_release);
+        uint64_t used = t - prodCachedHead;
+        if (used > highWater.load(std::memory_order_relaxed)) highWater.store(used, std::memory_order_relaxed);
+        notifyConsumer();
+    }
+
+    // 消费者可读数量, 缓存的 tail 不够 want 时才重新读取
+    uint64_t consumerAvail(uint64_t h, size_t want) {
+        uint64_t avail = consCachedTail - h;
+        if (avail < want) {
+            consCachedTail = tail.load(std::memory_order_acquire);
+            avail = consCachedTail - h;
+        }
+        return avail;
+    }
+
+    bool readable() {
+        return consumerAvail(head.load(std::memory_order_relaxed), 1) != 0;
+    }
+
+    // 生产者发布后调用: 只有消费者处于空闲等待时才记录时间戳, Blocking 模式下才做系统调用唤醒
+    // 只有 Blocking 的消费者会休眠, 需要 seq_cst fence 保证"发布后看到 idle"与"置 idle 后看到数据"至少一方成立;
+    // BusySpin / SpinYield 的消费者一直在重查 readable(), 漏看 idle 只影响唤醒时延统计, 不付 fence 的代价
+    void notifyConsumer() {
+        if (strategy == RingWaitStrategy::Blocking) std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle.load(std::memory_order_relaxed)) {
+            int64_t expected = 0;
+            publishNs.compare_exchange_strong(expected, nowNs(), std::memory_order_relaxed);
+            if (strategy == RingWaitStrategy::Blocking) {
+                wakeSeq.fetch_add(1, std::memory_order_release);
+                wakeSeq.notify_one();
+            }
+        }
+    }
+
+    bool wait_readable(const std::atomic<bool>& running) {
+        if (readable()) return true;
+        const int spinLimit = (strategy == RingWaitStrategy::BusySpin) ? 0 : 2000;
+        for (int i = 0; i < spinLimit; ++i) {                                   // 短暂自旋, 突发流量下不进入休眠
+            if (readable()) return true;
+            ringCpuRelax();
+        }
+        publishNs.store(0, std::memory_order_relaxed);
+        idle.store(true, std::memory_order_relaxed);
+        if (strategy == RingWaitStrategy::Blocking) std::atomic_thread_fence(std::memory_order_seq_cst); // 与 notifyConsumer 中的 fence 配对
+        while (!readable() && running.load(std::memory_order_relaxed) && !kicked.load(std::memory_order_acquire)) {
+            switch (strategy) {
+            case RingWaitStrategy::BusySpin:
+                ringCpuRelax();
+                break;
+            case RingWaitStrategy::SpinYield:
+                std::this_thread::yield();
+                break;
+            case RingWaitStrategy::Blocking: {
+                uint32_t seq = wakeSeq.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (readable() || !running.load(std::memory_order_relaxed) || kicked.load(std::memory_order_acquire)) break;
+                wakeSeq.wait(seq, std::memory_order_acquire);
+                break;
+            }
+            }
+        }
+        idle.store(false, std::memory_order_relaxed);
+        kicked.store(false, std::memory_order_relaxed);
+        if (!readable()) return false;
+        int64_t published = publishNs.load(std::memory_order_relaxed);
+        if (published > 0) {
+            uint64_t latency = static_cast<uint64_t>(std::max<int64_t>(0, nowNs() - published));
+            wakeCount.fetch_add(1, std::memory_order_relaxed);
+            wakeLatencySumNs.fetch_add(latency, std::memory_order_relaxed);
+            uint64_t cur = wakeLatencyMaxNs.load(std::memory_order_relaxed);
+            while (latency > cur && !wakeLatencyMaxNs.compare_exchange_weak(cur, latency, std::memory_order_relaxed)) {}
+        }
+        return true;
+    }
+
     static size_t nextPow2(size_t v) { size_t p=1; while(p<v) p <<= 1; return p; }
-    T* buffer;
+
+    // 只读区: 构造后不再修改
+    alignas(kCacheLine) T* buffer;
     size_t cap;
     size_t mask;
-    std::atomic<uint64_t> head;
-    std::atomic<uint64_t> tail;
+    RingWaitStrategy strategy = RingWaitStrategy::Blocking;
+
+    // 生产者区
+    alignas(kCacheLine) std::atomic<uint64_t> tail;
+    uint64_t prodCachedHead = 0;                            // 生产者缓存的 head
+    std::atomic<uint64_t> highWater{ 0 };
+
+    // 消费者区
+    alignas(kCacheLine) std::atomic<uint64_t> head;
+    uint64_t consCachedTail = 0;                            // 消费者缓存的 tail
+
+    // 唤醒区: 双方都会访问, 与上面的热点下标隔开
+    alignas(kCacheLine) std::atomic<bool> idle{ false };    // 消费者处于空闲等待
+    std::atomic<uint32_t> wakeSeq{ 0 };                     // Blocking 模式的等待地址
+    std::atomic<bool> kicked{ false };                      // wake() 请求消费者返回
+    std::atomic<int64_t> publishNs{ 0 };                    // 空闲期间第一次发布的时间
+    std::atomic<uint64_t> wakeCount{ 0 };
+    std::atomic<uint64_t> wakeLatencySumNs{ 0 };
+    std::atomic<uint64_t> wakeLatencyMaxNs{ 0 };
 };
 
 
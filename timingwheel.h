@@ -0,0 +1,134 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+// 固定容量的单层时间轮: 定时器节点来自预分配的节点池, 每个格子是一条侵入式双向链表
+// schedule/cancel 为 O(1), advance 每个 tick 只遍历到期格子; 超过一圈的延时用 rounds 计数
+// 非线程安全, 由单个线程持有
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+template<typename Payload>
+class TimingWheel {
+public:
+    using Handle = int32_t;
+    static constexpr Handle kInvalid = -1;
+
+    TimingWheel(size_t capacity, size_t wheelSlots, int64_t tickMs)
+        : nodes_(capacity), wheel_(std::max<size_t>(1, wheelSlots), kInvalid), tickMs_(std::max<int64_t>(1, tickMs))
+    {
+        for (size_t i = 0; i < capacity; ++i) {
+            nodes_[i].next = (i + 1 < capacity) ? static_cast<Handle>(i + 1) : kInvalid;
+        }
+        freeHead_ = capacity ? 0 : kInvalid;
+    }
+
+    // 在 nowMs + delayMs 时到期, 节点池已满返回 kInvalid
+    Handle schedule(int64_t nowMs, int64_t delayMs, const Payload& payload) {
+        if (freeHead_ == kInvalid) return kInvalid;
+        if (!started_) {
+            currentTick_ = nowMs / tickMs_;
+            started_ = true;
+        }
+        Handle h = freeHead_;
+        Node& n = nodes_[h];
+        freeHead_ = n.next;
+        int64_t ticks = std::max<int64_t>(1, (delayMs + tickMs_ - 1) / tickMs_);
+        int64_t target = std::max<int64_t>(nowMs / tickMs_, currentTick_) + ticks;
+        int64_t distance = target - currentTick_;
+        n.payload = payload;
+        n.slot = static_cast<uint32_t>(target % static_cast<int64_t>(wheel_.size()));
+        n.rounds = static_cast<uint32_t>((distance - 1) / static_cast<int64_t>(wheel_.size()));
+        n.active = true;
+        link(h);
+        ++size_;
+        return h;
+    }
+
+    // 取消未到期的定时器, 句柄失效
+    void cancel(Handle h) {
+        if (h < 0 || static_cast<size_t>(h) >= nodes_.size() || !nodes_[h].active) return;
+        unlink(h);
+        release(h);
+    }
+
+    // 推进到 nowMs, 对每个到期节点调用 onExpire(payload), 返回到期数量
+    template<typename Fn>
+    size_t advance(int64_t nowMs, Fn&& onExpire) {
+        if (!started_) return 0;
+        size_t expired = 0;
+        int64_t targetTick = nowMs / tickMs_;
+        while (currentTick_ < targetTick) {
+            ++currentTick_;
+            size_t slot = static_cast<size_t>(currentTick_ % static_cast<int64_t>(wheel_.size()));
+            Handle h = wheel_[slot];
+            while (h != kInvalid) {
+                Handle next = nodes_[h].next;
+                if (nodes_[h].rounds == 0) {
+                    unlink(h);
+                    Payload p = nodes_[h].payload;
+                    release(h);
+                    onExpire(p);
+                    ++expired;
+                }
+                else {
+                    --nodes_[h].rounds;
+                }
+                h = next;
+            }
+            if (size_ == 0) {                               // 空轮直接跳到目标 tick
+                currentTick_ = targetTick;
+            }
+        }
+        return expired;
+    }
+
+    Payload& at(Handle h) { return nodes_[h].payload; }
+    bool active(Handle h) const { return h >= 0 && static_cast<size_t>(h) < nodes_.size() && nodes_[h].active; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return nodes_.size(); }
+
+private:
+    struct Node {
+        Payload payload{};
+        Handle prev = kInvalid;
+        Handle next = kInvalid;
+        uint32_t slot = 0;
+        uint32_t rounds = 0;
+        bool active = false;
+    };
+
+    void link(Handle h) {
+        Node& n = nodes_[h];
+        n.prev = kInvalid;
+        n.next = wheel_[n.slot];
+        if (n.next != kInvalid) nodes_[n.next].prev = h;
+        wheel_[n.slot] = h;
+    }
+    void unlink(Handle h) {
+        Node& n = nodes_[h];
+        if (n.prev != kInvalid) nodes_[n.prev].next = n.next;
+        else wheel_[n.slot] = n.next;
+        if (n.next != kInvalid) nodes_[n.next].prev = n.prev;
+    }
+    void release(Handle h) {
+        Node& n = nodes_[h];
+        n.active = false;
+        n.prev = kInvalid;
+        n.next = freeHead_;
+        freeHead_ = h;
+        --size_;
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<Handle> wheel_;
+    int64_t tickMs_;
+    int64_t currentTick_ = 0;
+    bool started_ = false;
+    Handle freeHead_ = kInvalid;
+    size_t size_ = 0;
+};
+
+#endif // TIMINGWHEEL_H
@@ -0,0 +1,182 @@
+// PLC 报文编码基准: 旧的 ostringstream + setw/setfill 拼接(原样复制在下面) 与 plcframes.h 的 Frame::encode 对比
+// 台号/序列号/格口号随机, 与现场取值范围一致; 统计每帧的耗时和堆分配次数
+//
+// 用法: plc_frame_bench [--frames 100000] [--rounds 20] [--seed 1]
+//  --frames         报文条数, 每轮全部编码一遍
+//  --rounds         轮数, 输出各轮每帧耗时的最小值和中位数
+// 每种报文分两项: 旧拼接(含追加 '#' 得到发送用的 std::string), 新编码(含 '#', 写入栈上缓冲区)
+// 新编码另有一项 encode+string, 即 sendSupplyDataToPLC 复制成 std::string 入发送队列的实际工作量
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "plcframes.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{ 0 };
+
+// 与原 dataprocess.cpp 中 sendSupplyDataToPLC 的拼接相同
+std::string legacyStd(int supply_id, int supply_order)
+{
+    std::ostringstream oss;
+    oss << "STD"
+        << std::setw(2) << std::setfill('0') << supply_id
+        << "ID"
+        << std::setw(4) << std::setfill('0') << supply_order
+        << "00000";
+    std::string message = oss.str();
+    return message + "#";
+}
+
+// 与原 dataprocess.cpp 中 sendSlotToPLC (数据库取序列号分支) 的拼接相同
+std::string legacyGk(int supply_id, int supply_order, int slot_id)
+{
+    std::ostringstream oss;
+    oss << "GKD"
+        << std::setw(2) << std::setfill('0') << supply_id
+        << "ID"
+        << std::setw(4) << std::setfill('0') << supply_order
+        << "G"
+        << std::to_string(slot_id);
+    std::string message = oss.str();
+    return message + "#";
+}
+
+struct Options {
+    size_t frames = 100000;
+    int rounds = 20;
+    uint32_t seed = 1;
+};
+
+struct Fields {
+    int station;
+    int order;
+    int slot;
+};
+
+std::vector<Fields> makeFields(const Options& opt) {
+    std::mt19937 rng(opt.seed);
+    std::uniform_int_distribution<int> station(1, 12);
+    std::uniform_int_distribution<int> order(1, 9999);
+    std::uniform_int_distribution<int> slot(1, 300);
+    std::vector<Fields> out;
+    out.reserve(opt.frames);
+    for (size_t i = 0; i < opt.frames; ++i) out.push_back(Fields{ station(rng), order(rng), slot(rng) });
+    return out;
+}
+
+struct Result {
+    double minNs = 0;
+    double medianNs = 0;
+    double allocsPerFrame = 0;
+    uint64_t checksum = 0;              // 防止被优化掉; 同种报文的各项为帧长与末字节之和, 应相同
+};
+
+template<typename Fn>
+Result run(const std::vector<Fields>& fields, int rounds, Fn fn) {
+    std::vector<double> perFrame;
+    Result r;
+    uint64_t allocs = 0;
+    for (int round = 0; round < rounds; ++round) {
+        uint64_t sum = 0;
+        uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+        auto t0 = std::chrono::steady_clock::now();
+        for (const Fields& f : fields) sum += fn(f);
+        auto t1 = std::chrono::steady_clock::now();
+        allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+        perFrame.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(fields.size()));
+        r.checksum = sum;
+    }
+    std::sort(perFrame.begin(), perFrame.end());
+    r.minNs = perFrame.front();
+    r.medianNs = perFrame[perFrame.size() / 2];
+    r.allocsPerFrame = static_cast<double>(allocs) / static_cast<double>(fields.size()) / rounds;
+    return r;
+}
+
+void print(const char* name, const Result& r, double baseMedian) {
+    std::printf("%-24s min:%8.1f ns  median:%8.1f ns  allocs/frame:%5.2f  speedup:%6.1fx  checksum:%llu\n",
+                name, r.minNs, r.medianNs, r.allocsPerFrame, baseMedian / r.medianNs, static_cast<unsigned long long>(r.checksum));
+}
+
+uint64_t digest(std::string_view s) {
+    return s.size() + static_cast<unsigned char>(s.empty() ? 0 : s.back());
+}
+
+} // namespace
+
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--frames") opt.frames = static_cast<size_t>(std::max(1ll, std::atoll(next())));
+        else if (a == "--rounds") opt.rounds = std::max(1, std::atoi(next()));
+        else if (a == "--seed") opt.seed = static_cast<uint32_t>(std::atoi(next()));
+        else {
+            std::fprintf(stderr, "usage: plc_frame_bench [--frames N] [--rounds N] [--seed S]\n");
+            return 1;
+        }
+    }
+    std::vector<Fields> fields = makeFields(opt);
+    std::printf("frames:%zu rounds:%d\n", fields.size(), opt.rounds);
+
+    for (const Fields& f : fields) {                                    //两种编码结果必须逐字节相同
+        plcframes::StdFrame s;
+        plcframes::GkFrame g;
+        if (!s.encode(true, f.station, f.order) || s.view() != legacyStd(f.station, f.order)
+            || !g.encode(true, f.station, f.order, f.slot) || g.view() != legacyGk(f.station, f.order, f.slot)) {
+            std::fprintf(stderr, "mismatch: station %d order %d slot %d\n", f.station, f.order, f.slot);
+            return 1;
+        }
+    }
+
+    Result stdLegacy = run(fields, opt.rounds, [](const Fields& f) -> uint64_t {
+        return digest(legacyStd(f.station, f.order));
+    });
+    Result stdFrame = run(fields, opt.rounds, [](const Fields& f) -> uint64_t {
+        plcframes::StdFrame frame;
+        frame.encode(true, f.station, f.order);
+        return digest(frame.view());
+    });
+    Result stdString = run(fields, opt.rounds, [](const Fields& f) -> uint64_t {
+        plcframes::StdFrame frame;
+        frame.encode(true, f.station, f.order);
+        std::string send_msg(frame.view());
+        return digest(send_msg);
+    });
+    Result gkLegacy = run(fields, opt.rounds, [](const Fields& f) -> uint64_t {
+        return digest(legacyGk(f.station, f.order, f.slot));
+    });
+    Result gkFrame = run(fields, opt.rounds, [](const Fields& f) -> uint64_t {
+        plcframes::GkFrame frame;
+        frame.encode(true, f.station, f.order, f.slot);
+        return digest(frame.view());
+    });
+    print("STD ostringstream", stdLegacy, stdLegacy.medianNs);
+    print("STD StdFrame", stdFrame, stdLegacy.medianNs);
+    print("STD encode+string", stdString, stdLegacy.medianNs);
+    print("GK ostringstream", gkLegacy, gkLegacy.medianNs);
+    print("GK GkFrame", gkFrame, gkLegacy.medianNs);
+    return 0;
+}
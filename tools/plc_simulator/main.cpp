@@ -0,0 +1,583 @@
+// PLC 模拟器: 在 2061-2064 上监听, 按现场 PLC 的报文格式与 loopline_houjie 通信, 用于无线体时的压测和延时测量
+//  2061 供包: 收 STD<台2>ID<序4>00000#, 回 AKD<台2>ID<序4>00000#, 同时包裹按供包台上线, 开始计时
+//  2062 格口: 收 GKD<台2>ID<序4>G<格口>#, 回 AKD<台2>ID<序4>G<格口>#, 记录是否赶在包裹到达分拣口之前
+//  2063 下件: 包裹到达分拣口时发 SU<小车3>D<台2>ID<序4>G<格口>#, 未收到格口或模拟失败时发 FA..., 程序逐帧原样回复
+//  2064 格口状态: 按 --status-rate 发 SS<格口4>S<状态1>#, 程序只记录日志
+// 每个端口只保留最新的一个连接; 单线程 poll 循环, 不依赖 Qt
+//
+// 用法: plc_simulator [--port 2061] [--divert-ms 3000] [--station-step-ms 200] [--jitter-ms 100]
+//                     [--fa-rate 0.0] [--unload-rate 0] [--status-rate 0] [--ack-drop 0.0] [--ack-delay-ms 0]
+//                     [--echo-heartbeat] [--report-s 10] [--csv parcels.csv] [--duration-s 0]
+//  --divert-ms        供包台 1 从上件(收到 STD)到分拣口的时间
+//  --station-step-ms  每往后一个供包台增加的时间, 供包台 n 为 divert-ms + (n-1) * station-step-ms
+//  --jitter-ms        到达时间的随机抖动 [0, jitter-ms)
+//  --fa-rate          已收到格口的包裹仍下件失败(FA)的比例
+//  --unload-rate      每秒额外发送的下件报文数(不对应任何包裹, 用于压测下件通道)
+//  --status-rate      每秒发送的格口状态报文数
+//  --ack-drop         不回复 AK 的比例, 用于验证超时重发
+//  --ack-delay-ms     回复 AK 前的延时
+//  --echo-heartbeat   收到 "0000000000000000#" 心跳时原样回传 (对应 plc_heartbeat_echo)
+//  --csv              每个包裹一行: 供包台,序列号,STD接收时间,GK接收时间,到达分拣口时间(均为系统时钟微秒),是否及时,格口
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "plcframedecoder.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using sock_t = SOCKET;
+static const sock_t kInvalidSock = INVALID_SOCKET;
+#define poll WSAPoll
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+using sock_t = int;
+static const sock_t kInvalidSock = -1;
+#endif
+
+namespace {
+
+int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t wallUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void closeSock(sock_t s) {
+    if (s == kInvalidSock) return;
+#ifdef _WIN32
+    closesocket(s);
+#else
+    ::close(s);
+#endif
+}
+
+void setNonBlocking(sock_t s) {
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    fcntl(s, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+sock_t listenOn(uint16_t port) {
+    sock_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalidSock) return s;
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (::bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(s, 4) != 0) {
+        closeSock(s);
+        return kInvalidSock;
+    }
+    setNonBlocking(s);
+    return s;
+}
+
+struct Options {
+    uint16_t basePort = 2061;
+    int divertMs = 3000;
+    int stationStepMs = 200;
+    int jitterMs = 100;
+    double faRate = 0.0;
+    double unloadRate = 0.0;
+    double statusRate = 0.0;
+    double ackDrop = 0.0;
+    int ackDelayMs = 0;
+    bool echoHeartbeat = false;
+    int reportSec = 10;
+    int durationSec = 0;
+    std::string csvPath;
+};
+
+const char* kHeartbeat = "0000000000000000";
+
+enum Port { Supply = 0, SendSlot, Unload, SlotStatus, PortCount };
+const char* kPortName[PortCount] = { "supply", "send slot", "unload", "slot status" };
+
+struct Link {
+    sock_t listenSock = kInvalidSock;
+    sock_t sock = kInvalidSock;
+    PlcFrameDecoder decoder;
+    std::string outBuf;
+    uint64_t framesIn = 0;
+    uint64_t framesOut = 0;
+};
+
+struct Parcel {
+    int64_t stdUs = 0;              // steady, 收到 STD
+    int64_t gkUs = 0;               // steady, 收到 GK, 0 为未收到
+    int64_t divertUs = 0;           // steady, 到达分拣口
+    int64_t stdWallUs = 0;
+    int64_t gkWallUs = 0;
+    int slot = 0;
+    bool diverted = false;
+};
+
+struct Timer {
+    int64_t atUs;
+    int kind;                       // 0 到达分拣口, 1 延时回复 AK
+    uint32_t key;
+    int port;
+    std::string frame;
+    bool operator>(const Timer& o) const { return atUs > o.atUs; }
+};
+
+struct Stats {
+    uint64_t stdFrames = 0;
+    uint64_t gkFrames = 0;
+    uint64_t acksSent = 0;
+    uint64_t acksDropped = 0;
+    uint64_t heartbeats = 0;
+    uint64_t parcels = 0;
+    uint64_t gkOnTime = 0;          // 到达分拣口前收到 GK
+    uint64_t gkLate = 0;            // 到达分拣口后才收到 GK
+    uint64_t gkMissing = 0;         // 到达分拣口时未收到 GK(之后也可能到)
+    uint64_t gkUnknown = 0;         // 找不到对应 STD 的 GK
+    uint64_t suSent = 0;
+    uint64_t faSent = 0;
+    uint64_t unloadEchoed = 0;
+    uint64_t unloadEchoSumUs = 0;
+    uint64_t unloadEchoMaxUs = 0;
+    uint64_t statusSent = 0;
+    int64_t gkSlackSumUs = 0;       // 及时的 GK 距离到达分拣口的余量
+    int64_t gkSlackMinUs = INT64_MAX;
+};
+
+class Simulator {
+public:
+    explicit Simulator(const Options& opt) : opt_(opt), rng_(std::random_device{}()) {}
+
+    bool open() {
+        for (int i = 0; i < PortCount; ++i) {
+            links_[i].listenSock = listenOn(static_cast<uint16_t>(opt_.basePort + i));
+            if (links_[i].listenSock == kInvalidSock) {
+                std::fprintf(stderr, "listen on port %d failed\n", opt_.basePort + i);
+                return false;
+            }
+            std::printf("listening %s on port %d\n", kPortName[i], opt_.basePort + i);
+        }
+        if (!opt_.csvPath.empty()) {
+            csv_ = std::fopen(opt_.csvPath.c_str(), "w");
+            if (!csv_) {
+                std::fprintf(stderr, "open %s failed\n", opt_.csvPath.c_str());
+                return false;
+            }
+            std::fprintf(csv_, "station,order,std_wall_us,gk_wall_us,divert_wall_us,on_time,slot\n");
+        }
+        return true;
+    }
+
+    void run() {
+        int64_t start = steadyUs();
+        int64_t nextReport = start + static_cast<int64_t>(opt_.reportSec) * 1000000;
+        int64_t nextUnload = start;
+        int64_t nextStatus = start;
+        std::vector<pollfd> fds;
+        std::vector<int> owner;                     // fds[i] 对应的端口, 负数为监听套接字
+        while (opt_.durationSec <= 0 || steadyUs() - start < static_cast<int64_t>(opt_.durationSec) * 1000000) {
+            int64_t now = steadyUs();
+            runTimers(now);
+            if (opt_.unloadRate > 0 && now >= nextUnload) {
+                sendSyntheticUnload();
+                nextUnload += static_cast<int64_t>(1e6 / opt_.unloadRate);
+                if (nextUnload < now) nextUnload = now;
+            }
+            if (opt_.statusRate > 0 && now >= nextStatus) {
+                sendSlotStatus();
+                nextStatus += static_cast<int64_t>(1e6 / opt_.statusRate);
+                if (nextStatus < now) nextStatus = now;
+            }
+            if (opt_.reportSec > 0 && now >= nextReport) {
+                report();
+                nextReport += static_cast<int64_t>(opt_.reportSec) * 1000000;
+            }
+            fds.clear();
+            owner.clear();
+            for (int i = 0; i < PortCount; ++i) {
+                pollfd p{};
+                p.fd = links_[i].listenSock;
+                p.events = POLLIN;
+                fds.push_back(p);
+                owner.push_back(-1 - i);
+                if (links_[i].sock != kInvalidSock) {
+                    p.fd = links_[i].sock;
+                    p.events = POLLIN;
+                    if (!links_[i].outBuf.empty()) p.events |= POLLOUT;
+                    fds.push_back(p);
+                    owner.push_back(i);
+                }
+            }
+            int n = ::poll(fds.data(), static_cast<unsigned>(fds.size()), nextWaitMs(steadyUs(), nextUnload, nextStatus, nextReport));
+            if (n <= 0) continue;
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (!fds[i].revents) continue;
+                if (owner[i] < 0) accept(-1 - owner[i]);
+                else {
+                    if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) readLink(owner[i]);
+                    if (fds[i].revents & POLLOUT) flush(owner[i]);
+                }
+            }
+        }
+        report();
+        if (csv_) std::fclose(csv_);
+    }
+
+private:
+    static uint32_t makeKey(int station, int order) { return static_cast<uint32_t>(station) * 10000u + static_cast<uint32_t>(order); }
+
+    static bool parseKey(std::string_view f, int& station, int& order) {       // D<台2>ID<序4>
+        size_t d = f.find('D');
+        if (d == std::string_view::npos || d + 9 > f.size() || f.compare(d + 3, 2, "ID") != 0) return false;
+        station = std::atoi(std::string(f.substr(d + 1, 2)).c_str());
+        order = std::atoi(std::string(f.substr(d + 5, 4)).c_str());
+        return station > 0 && order > 0;
+    }
+
+    bool chance(double p) {
+        if (p <= 0) return false;
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < p;
+    }
+
+    int nextWaitMs(int64_t now, int64_t nextUnload, int64_t nextStatus, int64_t nextReport) const {
+        int64_t next = now + 100000;
+        if (!timers_.empty()) next = std::min(next, timers_.top().atUs);
+        if (opt_.unloadRate > 0) next = std::min(next, nextUnload);
+        if (opt_.statusRate > 0) next = std::min(next, nextStatus);
+        if (opt_.reportSec > 0) next = std::min(next, nextReport);
+        return static_cast<int>(std::max<int64_t>(0, (next - now + 999) / 1000));
+    }
+
+    void accept(int port) {
+        Link& l = links_[port];
+        sock_t s = ::accept(l.listenSock, nullptr, nullptr);
+        if (s == kInvalidSock) return;
+        if (l.sock != kInvalidSock) {                                   // 只保留最新的连接
+            closeSock(l.sock);
+            std::printf("[%s] replaced by new connection\n", kPortName[port]);
+        }
+        int flag = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
+        setNonBlocking(s);
+        l.sock = s;
+        l.decoder.reset();
+        l.outBuf.clear();
+        std::printf("[%s] client connected\n", kPortName[port]);
+    }
+
+    void drop(int port, const char* why) {
+        Link& l = links_[port];
+        closeSock(l.sock);
+        l.sock = kInvalidSock;
+        l.outBuf.clear();
+        std::printf("[%s] client %s\n", kPortName[port], why);
+    }
+
+    void readLink(int port) {
+        Link& l = links_[port];
+        char buf[8192];
+        int n = ::recv(l.sock, buf, static_cast<int>(sizeof(buf)), 0);
+        if (n == 0) {
+            drop(port, "closed");
+            return;
+        }
+        if (n < 0) {
+#ifdef _WIN32
+            if (WSAGetLastError() == WSAEWOULDBLOCK) return;
+#else
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+#endif
+            drop(port, "recv failed");
+            return;
+        }
+        l.decoder.feed(buf, static_cast<size_t>(n), [this, port](std::string_view f) { onFrame(port, f); });
+    }
+
+    void onFrame(int port, std::string_view f) {
+        ++links_[port].framesIn;
+        size_t hbLen = std::strlen(kHeartbeat);
+        while (f.size() >= hbLen && f.compare(0, hbLen, kHeartbeat) == 0) {      // 心跳以'#'结尾时是独立的一帧; 旧版本不带'#'的心跳会粘在下一帧前面
+            ++stats_.heartbeats;
+            f.remove_prefix(hbLen);
+            if (f.empty() && opt_.echoHeartbeat) write(port, std::string(kHeartbeat) + "#");
+        }
+        if (f.empty()) return;
+        int64_t now = steadyUs();
+        switch (port) {
+        case Supply: onStd(f, now); break;
+        case SendSlot: onGk(f, now); break;
+        case Unload: onUnloadEcho(f, now); break;
+        default: break;
+        }
+    }
+
+    void reply(int port, std::string_view f) {                          // AK + 去掉 2/3 字母前缀的原报文
+        if (chance(opt_.ackDrop)) {
+            ++stats_.acksDropped;
+            return;
+        }
+        size_t d = f.find('D');
+        std::string ack = "AK" + std::string(f.substr(d == std::string_view::npos ? 0 : d)) + "#";
+        if (opt_.ackDelayMs > 0) {
+            timers_.push(Timer{ steadyUs() + static_cast<int64_t>(opt_.ackDelayMs) * 1000, 1, 0, port, ack });
+            return;
+        }
+        write(port, ack);
+        ++stats_.acksSent;
+    }
+
+    void onStd(std::string_view f, int64_t now) {
+        int station = 0;
+        int order = 0;
+        if (f.substr(0, 3) != "STD" || !parseKey(f, station, order)) return;
+        ++stats_.stdFrames;
+        reply(Supply, f);
+        uint32_t key = makeKey(station, order);
+        auto it = parcels_.find(key);
+        if (it != parcels_.end()) return;                               // 重发的 STD, 包裹已在线上
+        Parcel& p = parcels_[key];
+        p.stdUs = now;
+        p.stdWallUs = wallUs();
+        int64_t travelMs = opt_.divertMs + static_cast<int64_t>(station - 1) * opt_.stationStepMs;
+        int64_t jitterUs = opt_.jitterMs > 0 ? std::uniform_int_distribution<int64_t>(0, static_cast<int64_t>(opt_.jitterMs) * 1000 - 1)(rng_) : 0;
+        p.divertUs = now + travelMs * 1000 + jitterUs;
+        timers_.push(Timer{ p.divertUs, 0, key, Unload, std::string() });
+        ++stats_.parcels;
+    }
+
+    void onGk(std::string_view f, int64_t now) {
+        int station = 0;
+        int order = 0;
+        if (f.substr(0, 2) != "GK" || !parseKey(f, station, order)) return;
+        ++stats_.gkFrames;
+        reply(SendSlot, f);
+        auto it = parcels_.find(makeKey(station, order));
+        if (it == parcels_.end()) {
+            ++stats_.gkUnknown;
+            return;
+        }
+        Parcel& p = it->second;
+        if (p.gkUs != 0) return;                                        // 重发的 GK
+        p.gkUs = now;
+        p.gkWallUs = wallUs();
+        size_t g = f.rfind('G');
+        p.slot = (g != std::string_view::npos && g > 0) ? std::atoi(std::string(f.substr(g + 1)).c_str()) : 0;
+        if (p.diverted) {
+            ++stats_.gkLate;
+            --stats_.gkMissing;
+            writeCsv(it->first, p, false);
+            parcels_.erase(it);
+            return;
+        }
+        ++stats_.gkOnTime;
+        int64_t slack = p.divertUs - now;
+        stats_.gkSlackSumUs += slack;
+        stats_.gkSlackMinUs = std::min(stats_.gkSlackMinUs, slack);
+    }
+
+    void onUnloadEcho(std::string_view f, int64_t now) {
+        auto it = unloadSentUs_.find(std::string(f));
+        if (it == unloadSentUs_.end()) return;
+        uint64_t us = static_cast<uint64_t>(now - it->second);
+        unloadSentUs_.erase(it);
+        ++stats_.unloadEchoed;
+        stats_.unloadEchoSumUs += us;
+        stats_.unloadEchoMaxUs = std::max(stats_.unloadEchoMaxUs, us);
+    }
+
+    void runTimers(int64_t now) {
+        while (!timers_.empty() && timers_.top().atUs <= now) {
+            Timer t = timers_.top();
+            timers_.pop();
+            if (t.kind == 1) {
+                write(t.port, t.frame);
+                ++stats_.acksSent;
+                continue;
+            }
+            auto it = parcels_.find(t.key);
+            if (it == parcels_.end()) continue;
+            Parcel& p = it->second;
+            p.diverted = true;
+            bool ok = p.gkUs != 0 && !chance(opt_.faRate);
+            sendUnload(ok, t.key, p.slot);
+            if (p.gkUs != 0) {
+                writeCsv(t.key, p, true);
+                parcels_.erase(it);
+            }
+            else {
+                ++stats_.gkMissing;                                     // 保留记录, 之后到达的 GK 计为迟到
+            }
+        }
+        if (parcels_.size() > 100000) {                                 // 从未收到 GK 的包裹, 防止无限增长
+            for (auto it = parcels_.begin(); it != parcels_.end();) {
+                if (it->second.diverted && now - it->second.divertUs > 60000000) {
+                    writeCsv(it->first, it->second, false);
+                    it = parcels_.erase(it);
+                }
+                else ++it;
+            }
+        }
+    }
+
+    void sendUnload(bool ok, uint32_t key, int slot) {
+        char frame[64];
+        int cart = std::uniform_int_distribution<int>(1, 999)(rng_);
+        std::snprintf(frame, sizeof(frame), "%s%03dD%02uID%04uG%d", ok ? "SU" : "FA", cart, key / 10000, key % 10000, slot);
+        unloadSentUs_[frame] = steadyUs();
+        if (unloadSentUs_.size() > 100000) unloadSentUs_.clear();     // 程序不回复时防止无限增长
+        write(Unload, std::string(frame) + "#");
+        if (ok) ++stats_.suSent;
+        else ++stats_.faSent;
+    }
+
+    void sendSyntheticUnload() {                                        // 供包台 99 不会与真实包裹冲突
+        int order = static_cast<int>(syntheticOrder_++ % 9999) + 1;
+        int slot = std::uniform_int_distribution<int>(1, 2000)(rng_);
+        sendUnload(!chance(opt_.faRate), makeKey(99, order), slot);
+    }
+
+    void sendSlotStatus() {
+        char frame[32];
+        int slot = std::uniform_int_distribution<int>(1, 2000)(rng_);
+        std::snprintf(frame, sizeof(frame), "SS%04dS%d#", slot, std::uniform_int_distribution<int>(0, 1)(rng_));
+        write(SlotStatus, frame);
+        ++stats_.statusSent;
+    }
+
+    void write(int port, const std::string& data) {
+        Link& l = links_[port];
+        if (l.sock == kInvalidSock) return;
+        l.outBuf += data;
+        ++l.framesOut;
+        flush(port);
+    }
+
+    void flush(int port) {
+        Link& l = links_[port];
+        while (!l.outBuf.empty()) {
+            int n = ::send(l.sock, l.outBuf.data(), static_cast<int>(l.outBuf.size()), 0);
+            if (n > 0) {
+                l.outBuf.erase(0, static_cast<size_t>(n));
+                continue;
+            }
+#ifdef _WIN32
+            if (n < 0 && WSAGetLastError() == WSAEWOULDBLOCK) return;
+#else
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+#endif
+            drop(port, "send failed");
+            return;
+        }
+    }
+
+    void writeCsv(uint32_t key, const Parcel& p, bool onTime) {
+        if (!csv_) return;
+        int64_t divertWall = p.stdWallUs + (p.divertUs - p.stdUs);
+        std::fprintf(csv_, "%u,%u,%lld,%lld,%lld,%d,%d\n", key / 10000, key % 10000, static_cast<long long>(p.stdWallUs),
+                     static_cast<long long>(p.gkWallUs), static_cast<long long>(divertWall), onTime ? 1 : 0, p.slot);
+    }
+
+    void report() {
+        const Stats& s = stats_;
+        uint64_t decided = s.gkOnTime + s.gkMissing + s.gkLate;      // 已到达分拣口的包裹
+        std::printf("parcels:%llu gk_on_time:%llu gk_missing:%llu gk_late:%llu gk_unknown:%llu on_time_pct:%.2f slack_avg_ms:%.1f slack_min_ms:%.1f\n",
+                    static_cast<unsigned long long>(s.parcels), static_cast<unsigned long long>(s.gkOnTime),
+                    static_cast<unsigned long long>(s.gkMissing), static_cast<unsigned long long>(s.gkLate),
+                    static_cast<unsigned long long>(s.gkUnknown), decided ? 100.0 * static_cast<double>(s.gkOnTime) / static_cast<double>(decided) : 0.0,
+                    s.gkOnTime ? static_cast<double>(s.gkSlackSumUs) / static_cast<double>(s.gkOnTime) / 1000.0 : 0.0,
+                    s.gkSlackMinUs == INT64_MAX ? 0.0 : static_cast<double>(s.gkSlackMinUs) / 1000.0);
+        std::printf("  std:%llu gk:%llu acks:%llu acks_dropped:%llu heartbeats:%llu su:%llu fa:%llu unload_echoed:%llu echo_avg_us:%llu echo_max_us:%llu status:%llu\n",
+                    static_cast<unsigned long long>(s.stdFrames), static_cast<unsigned long long>(s.gkFrames),
+                    static_cast<unsigned long long>(s.acksSent), static_cast<unsigned long long>(s.acksDropped),
+                    static_cast<unsigned long long>(s.heartbeats), static_cast<unsigned long long>(s.suSent),
+                    static_cast<unsigned long long>(s.faSent), static_cast<unsigned long long>(s.unloadEchoed),
+                    static_cast<unsigned long long>(s.unloadEchoed ? s.unloadEchoSumUs / s.unloadEchoed : 0),
+                    static_cast<unsigned long long>(s.unloadEchoMaxUs), static_cast<unsigned long long>(s.statusSent));
+        std::fflush(stdout);
+        if (csv_) std::fflush(csv_);
+    }
+
+    Options opt_;
+    std::mt19937_64 rng_;
+    Link links_[PortCount];
+    std::unordered_map<uint32_t, Parcel> parcels_;
+    std::unordered_map<std::string, int64_t> unloadSentUs_;             // 下件报文发送时间, 用于统计程序逐帧回复的时延
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t syntheticOrder_ = 0;
+    Stats stats_;
+    FILE* csv_ = nullptr;
+};
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--port") opt.basePort = static_cast<uint16_t>(std::atoi(next()));
+        else if (a == "--divert-ms") opt.divertMs = std::atoi(next());
+        else if (a == "--station-step-ms") opt.stationStepMs = std::atoi(next());
+        else if (a == "--jitter-ms") opt.jitterMs = std::atoi(next());
+        else if (a == "--fa-rate") opt.faRate = std::atof(next());
+        else if (a == "--unload-rate") opt.unloadRate = std::atof(next());
+        else if (a == "--status-rate") opt.statusRate = std::atof(next());
+        else if (a == "--ack-drop") opt.ackDrop = std::atof(next());
+        else if (a == "--ack-delay-ms") opt.ackDelayMs = std::atoi(next());
+        else if (a == "--echo-heartbeat") opt.echoHeartbeat = true;
+        else if (a == "--report-s") opt.reportSec = std::atoi(next());
+        else if (a == "--duration-s") opt.durationSec = std::atoi(next());
+        else if (a == "--csv") opt.csvPath = next();
+        else {
+            std::fprintf(stderr, "unknown option: %s\n", a.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::fprintf(stderr, "WSAStartup failed\n");
+        return 1;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    Simulator sim(opt);
+    if (!sim.open()) return 1;
+    sim.run();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
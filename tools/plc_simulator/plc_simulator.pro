@@ -0,0 +1,14 @@
+TEMPLATE = app
+CONFIG += console c++20
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../plcframedecoder.h \
+    ../../simdscan.h
+
+win32: LIBS += -lws2_32
@@ -0,0 +1,367 @@
+// SPSC 环形队列基准: 改造前的 SpscRing(原样复制在下面的 legacy 命名空间) 与 spsc_ring.h 的 SpscRing 对比
+// 一个生产者线程 try_push, 一个消费者线程 wait_pop_bulk, 两边使用同样的接口和等待方式
+//
+// 用法: ring_bench [--items 2000000] [--rounds 5] [--capacity 1024] [--batch 64] [--payload 48]
+//                  [--pings 20000] [--gap-us 50] [--strategy all|spin|yield|block]
+//  --items          吞吐测试每轮传递的元素数
+//  --rounds         吞吐测试轮数, 输出各轮吞吐的中位数
+//  --capacity       环形队列槽位数
+//  --batch          消费者每次 pop 的最大数量
+//  --payload        字符串元素的长度, 超过 SSO 时每条都有堆分配, 旧实现复制、新实现移动
+//  --pings          时延测试的元素数, 生产者每发一条等待 gap-us 再发下一条, 消费者统计发布到取出的单向时延
+//  --gap-us         时延测试的发送间隔, 大于消费者自旋时间时 Blocking 模式会进入休眠, 测到的是唤醒时延
+//  --strategy       只测一种等待方式, 默认三种都测
+// 注意: 生产者在队列满和发送间隔内 yield; BusySpin 消费者需要独占一个核, 单核机器上 spin 一项没有参考意义
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include "spsc_ring.h"
+
+namespace legacy {
+
+// 改造前的实现(40d43d2 之前的 spsc_ring.h), 只去掉了与新文件重复的 RingWaitStrategy / ringCpuRelax
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        cap = nextPow2(std::max<size_t>(2, capacity));
+        mask = cap - 1;
+        buffer = new T[cap];
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+    ~SpscRing() {
+        delete[] buffer;
+    }
+
+    // 非阻塞 push：成功返回 true，满则返回 false （调用方可统计丢弃）
+    bool try_push(const T& item) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        if ((t - h) >= cap) return false; // full
+        buffer[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        notifyConsumer();
+        return true;
+    }
+
+    // 零拷贝生产: 取得最多 max_items 个空闲槽位的指针, 写完后调用 commit(n) 发布前 n 个
+    // 未 commit 的槽位下次 reserve 时会再次返回
+    size_t try_reserve_bulk(T** out, size_t max_items) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        uint64_t free_slots = cap - (t - h);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(free_slots, max_items));
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = &buffer[(t + i) & mask];
+        }
+        return n;
+    }
+    void commit(size_t n) {
+        if (!n) return;
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        tail.store(t + n, std::memory_order_release);
+        notifyConsumer();
+    }
+
+    // 零拷贝消费: 取得最多 max_items 个可读槽位的指针, 处理完后调用 release(n) 归还给生产者
+    size_t peek_bulk(T** out, size_t max_items) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(t - h, max_items));
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = &buffer[(h + i) & mask];
+        }
+        return n;
+    }
+    void release(size_t n) {
+        if (!n) return;
+        uint64_t h = head.load(std::memory_order_relaxed);
+        head.store(h + n, std::memory_order_release);
+    }
+
+    // pop up to max_items, 返回实际 pop 的数量
+    size_t pop_bulk(T* out, size_t max_items) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        uint64_t avail = t - h;
+        size_t to_pop = static_cast<size_t>(std::min<uint64_t>(avail, max_items));
+        for (size_t i = 0; i < to_pop; ++i) {
+            out[i] = buffer[(h + i) & mask];
+        }
+        if (to_pop) head.store(h + to_pop, std::memory_order_release);
+        return to_pop;
+    }
+
+    // 等待方式, 需在消费线程启动前设置
+    void set_wait_strategy(RingWaitStrategy s) { strategy = s; }
+    RingWaitStrategy wait_strategy() const { return strategy; }
+
+    // 等待直到有数据或 running 变为 false, 然后同 peek_bulk / pop_bulk
+    size_t wait_peek_bulk(T** out, size_t max_items, const std::atomic<bool>& running) {
+        if (!wait_readable(running)) return 0;
+        return peek_bulk(out, max_items);
+    }
+    size_t wait_pop_bulk(T* out, size_t max_items, const std::atomic<bool>& running) {
+        if (!wait_readable(running)) return 0;
+        return pop_bulk(out, max_items);
+    }
+
+    // 停止消费线程时调用, 唤醒阻塞中的消费者使其重新检查 running
+    void wake() {
+        wakeSeq.fetch_add(1, std::memory_order_release);
+        wakeSeq.notify_all();
+    }
+
+    // 唤醒统计: 消费者从空闲到看到新数据的次数和耗时(纳秒), max 读取后清零
+    uint64_t wakeups() const { return wakeCount.load(std::memory_order_relaxed); }
+    uint64_t wake_latency_sum_ns() const { return wakeLatencySumNs.load(std::memory_order_relaxed); }
+    uint64_t take_wake_latency_max_ns() { return wakeLatencyMaxNs.exchange(0, std::memory_order_relaxed); }
+
+    // 方便监控：当前可用数量
+    uint64_t size_approx() const {
+        uint64_t h = head.load(std::memory_order_acquire);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        return t - h;
+    }
+
+private:
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool readable() const {
+        return tail.load(std::memory_order_acquire) != head.load(std::memory_order_relaxed);
+    }
+
+    // 生产者发布后调用: 只有消费者处于空闲等待时才记录时间戳, Blocking 模式下才做系统调用唤醒
+    void notifyConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle.load(std::memory_order_relaxed)) {
+            int64_t expected = 0;
+            publishNs.compare_exchange_strong(expected, nowNs(), std::memory_order_relaxed);
+            if (strategy == RingWaitStrategy::Blocking) {
+                wakeSeq.fetch_add(1, std::memory_order_release);
+                wakeSeq.notify_one();
+            }
+        }
+    }
+
+    bool wait_readable(const std::atomic<bool>& running) {
+        if (readable()) return true;
+        const int spinLimit = (strategy == RingWaitStrategy::BusySpin) ? 0 : 2000;
+        for (int i = 0; i < spinLimit; ++i) {                                   // 短暂自旋, 突发流量下不进入休眠
+            if (readable()) return true;
+            ringCpuRelax();
+        }
+        publishNs.store(0, std::memory_order_relaxed);
+        idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);                    // 与 notifyConsumer 中的 fence 配对
+        while (!readable() && running.load(std::memory_order_relaxed)) {
+            switch (strategy) {
+            case RingWaitStrategy::BusySpin:
+                ringCpuRelax();
+                break;
+            case RingWaitStrategy::SpinYield:
+                std::this_thread::yield();
+                break;
+            case RingWaitStrategy::Blocking: {
+                uint32_t seq = wakeSeq.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (readable() || !running.load(std::memory_order_relaxed)) break;
+                wakeSeq.wait(seq, std::memory_order_acquire);
+                break;
+            }
+            }
+        }
+        idle.store(false, std::memory_order_relaxed);
+        if (!readable()) return false;
+        int64_t published = publishNs.load(std::memory_order_relaxed);
+        if (published > 0) {
+            uint64_t latency = static_cast<uint64_t>(std::max<int64_t>(0, nowNs() - published));
+            wakeCount.fetch_add(1, std::memory_order_relaxed);
+            wakeLatencySumNs.fetch_add(latency, std::memory_order_relaxed);
+            uint64_t cur = wakeLatencyMaxNs.load(std::memory_order_relaxed);
+            while (latency > cur && !wakeLatencyMaxNs.compare_exchange_weak(cur, latency, std::memory_order_relaxed)) {}
+        }
+        return true;
+    }
+
+    static size_t nextPow2(size_t v) { size_t p=1; while(p<v) p <<= 1; return p; }
+    T* buffer;
+    size_t cap;
+    size_t mask;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+
+    RingWaitStrategy strategy = RingWaitStrategy::Blocking;
+    std::atomic<bool> idle{ false };                        // 消费者处于空闲等待
+    std::atomic<uint32_t> wakeSeq{ 0 };                     // Blocking 模式的等待地址
+    std::atomic<int64_t> publishNs{ 0 };                    // 空闲期间第一次发布的时间
+    std::atomic<uint64_t> wakeCount{ 0 };
+    std::atomic<uint64_t> wakeLatencySumNs{ 0 };
+    std::atomic<uint64_t> wakeLatencyMaxNs{ 0 };
+};
+
+} // namespace legacy
+
+namespace {
+
+struct Options {
+    size_t items = 2000000;
+    int rounds = 5;
+    size_t capacity = 1024;
+    size_t batch = 64;
+    size_t payload = 48;
+    size_t pings = 20000;
+    int gapUs = 50;
+    std::string strategy = "all";
+};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t itemValue(uint64_t v) { return v; }
+uint64_t itemValue(const std::string& s) { return static_cast<uint64_t>(static_cast<unsigned char>(s[0])) + s.size(); }
+
+uint64_t makeItem(uint64_t i, const uint64_t*, size_t) { return i; }
+std::string makeItem(uint64_t i, const std::string*, size_t payload) {
+    std::string s(payload, 'x');
+    s[0] = static_cast<char>('a' + i % 26);
+    return s;
+}
+
+// 返回每秒传递的元素数(百万)
+template<typename Ring, typename T>
+double throughputOnce(const Options& opt, RingWaitStrategy strategy, uint64_t& checksum) {
+    Ring ring(opt.capacity);
+    ring.set_wait_strategy(strategy);
+    std::atomic<bool> running{ true };
+    uint64_t sum = 0;
+    std::thread consumer([&]() {
+        std::vector<T> out(opt.batch);
+        size_t got = 0;
+        while (got < opt.items) {
+            size_t n = ring.wait_pop_bulk(out.data(), opt.batch, running);
+            for (size_t i = 0; i < n; ++i) sum += itemValue(out[i]);
+            got += n;
+        }
+    });
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < opt.items; ++i) {
+        T item = makeItem(i, static_cast<const T*>(nullptr), opt.payload);
+        while (!ring.try_push(std::move(item))) std::this_thread::yield();          // 满时让出, 单核上消费者才能运行
+    }
+    consumer.join();
+    auto t1 = std::chrono::steady_clock::now();
+    checksum = sum;
+    return static_cast<double>(opt.items) / std::chrono::duration<double, std::micro>(t1 - t0).count();
+}
+
+template<typename Ring, typename T>
+double throughput(const Options& opt, RingWaitStrategy strategy, uint64_t& checksum) {
+    std::vector<double> r;
+    for (int i = 0; i < opt.rounds; ++i) r.push_back(throughputOnce<Ring, T>(opt, strategy, checksum));
+    std::sort(r.begin(), r.end());
+    return r[r.size() / 2];
+}
+
+struct Latency {
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+};
+
+// 生产者写入发布时间, 消费者取出时计算单向时延
+template<typename Ring>
+Latency latency(const Options& opt, RingWaitStrategy strategy) {
+    Ring ring(opt.capacity);
+    ring.set_wait_strategy(strategy);
+    std::atomic<bool> running{ true };
+    std::vector<int64_t> samples;
+    samples.reserve(opt.pings);
+    std::thread consumer([&]() {
+        uint64_t out[64];
+        while (samples.size() < opt.pings) {
+            size_t n = ring.wait_pop_bulk(out, 64, running);
+            int64_t now = nowNs();
+            for (size_t i = 0; i < n; ++i) samples.push_back(now - static_cast<int64_t>(out[i]));
+        }
+    });
+    for (size_t i = 0; i < opt.pings; ++i) {
+        int64_t until = nowNs() + opt.gapUs * 1000LL;
+        while (!ring.try_push(static_cast<uint64_t>(nowNs()))) std::this_thread::yield();
+        while (nowNs() < until) std::this_thread::yield();
+    }
+    consumer.join();
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return static_cast<double>(samples[std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()))]); };
+    Latency l;
+    l.p50 = at(0.50);
+    l.p99 = at(0.99);
+    l.p999 = at(0.999);
+    l.max = static_cast<double>(samples.back());
+    return l;
+}
+
+const char* strategyName(RingWaitStrategy s) {
+    switch (s) {
+    case RingWaitStrategy::BusySpin: return "spin";
+    case RingWaitStrategy::SpinYield: return "yield";
+    case RingWaitStrategy::Blocking: return "block";
+    }
+    return "?";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--items") opt.items = static_cast<size_t>(std::atoll(next()));
+        else if (a == "--rounds") opt.rounds = std::max(1, std::atoi(next()));
+        else if (a == "--capacity") opt.capacity = static_cast<size_t>(std::atoll(next()));
+        else if (a == "--batch") opt.batch = std::max<size_t>(1, static_cast<size_t>(std::atoll(next())));
+        else if (a == "--payload") opt.payload = std::max<size_t>(1, static_cast<size_t>(std::atoll(next())));
+        else if (a == "--pings") opt.pings = std::max<size_t>(1, static_cast<size_t>(std::atoll(next())));
+        else if (a == "--gap-us") opt.gapUs = std::max(0, std::atoi(next()));
+        else if (a == "--strategy") opt.strategy = next();
+        else {
+            std::fprintf(stderr, "usage: ring_bench [--items N] [--rounds N] [--capacity N] [--batch N] [--payload N] [--pings N] [--gap-us N] [--strategy all|spin|yield|block]\n");
+            return 1;
+        }
+    }
+    std::vector<RingWaitStrategy> strategies;
+    if (opt.strategy == "all") strategies = { RingWaitStrategy::BusySpin, RingWaitStrategy::SpinYield, RingWaitStrategy::Blocking };
+    else strategies = { parseRingWaitStrategy(opt.strategy) };
+    std::printf("items:%zu rounds:%d capacity:%zu batch:%zu payload:%zu pings:%zu gap_us:%d cpus:%u\n",
+                opt.items, opt.rounds, opt.capacity, opt.batch, opt.payload, opt.pings, opt.gapUs, std::thread::hardware_concurrency());
+
+    for (RingWaitStrategy s : strategies) {
+        uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+        double oldInt = throughput<legacy::SpscRing<uint64_t>, uint64_t>(opt, s, c0);
+        double newInt = throughput<SpscRing<uint64_t>, uint64_t>(opt, s, c1);
+        double oldStr = throughput<legacy::SpscRing<std::string>, std::string>(opt, s, c2);
+        double newStr = throughput<SpscRing<std::string>, std::string>(opt, s, c3);
+        std::printf("[%-5s] throughput uint64  old:%8.2f M/s  new:%8.2f M/s  (%.2fx)  checksum:%s\n",
+                    strategyName(s), oldInt, newInt, newInt / oldInt, c0 == c1 ? "ok" : "MISMATCH");
+        std::printf("[%-5s] throughput string  old:%8.2f M/s  new:%8.2f M/s  (%.2fx)  checksum:%s\n",
+                    strategyName(s), oldStr, newStr, newStr / oldStr, c2 == c3 ? "ok" : "MISMATCH");
+        Latency lo = latency<legacy::SpscRing<uint64_t>>(opt, s);
+        Latency ln = latency<SpscRing<uint64_t>>(opt, s);
+        std::printf("[%-5s] latency ns  old p50:%8.0f p99:%8.0f p99.9:%8.0f max:%9.0f\n", strategyName(s), lo.p50, lo.p99, lo.p999, lo.max);
+        std::printf("[%-5s] latency ns  new p50:%8.0f p99:%8.0f p99.9:%8.0f max:%9.0f\n", strategyName(s), ln.p50, ln.p99, ln.p999, ln.max);
+    }
+    return 0;
+}
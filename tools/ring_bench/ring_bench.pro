@@ -0,0 +1,11 @@
+TEMPLATE = app
+CONFIG += console c++20
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../spsc_ring.h
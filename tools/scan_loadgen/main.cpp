@@ -0,0 +1,308 @@
+// 读码报文压测工具: 按供包台向 3011 端口发送 "单号,重量,供包台号" UDP 报文, 与读码平台格式一致(见 scanparser.h)
+// 配合 tools/plc_simulator 使用, 用于测量 onSupplyUDPServerRecv -> requestAndSendToPLC 每小时能处理的包裹数
+//
+// 用法: scan_loadgen [--host 192.168.2.98] [--port 3011] [--stations 12] [--rate 1.0] [--station-rate 3:2.5]...
+//                    [--profile steady|burst|ramp] [--burst-rate 5] [--burst-ms 2000] [--period-ms 10000]
+//                    [--ramp-to 10] [--dup-rate 0.0] [--bad-rate 0.0] [--duration-s 60] [--csv sends.csv] [--prefix JT5]
+//  --rate           每个供包台每秒的包裹数, --station-rate <台号>:<速率> 可单独覆盖某个供包台
+//  --profile        steady 恒定速率; burst 每 period-ms 中前 burst-ms 以 burst-rate 倍速率发送;
+//                   ramp 速率在 duration-s 内从 rate 线性升到 ramp-to (各台按 station-rate 同比例放大)
+//  --dup-rate       重复发送上一条单号的比例(程序应在去重窗口内丢弃)
+//  --bad-rate       发送格式错误报文的比例(缺字段/重量非法/空单号/台号非法轮流出现);
+//                   缺字段和台号非法被程序丢弃(kind=bad), 重量非法和空单号照常上件并分到异常格(kind=exception)
+//  --csv            每条报文一行: send_wall_us,station,code,kind,expected_order
+//                   kind 为 ok/dup/bad/exception; expected_order 为程序按供包台顺序分配的序列号(程序刚启动时从 1 开始, 9999 后回到 1),
+//                   可与 plc_simulator --csv 的 (station, order) 关联, 计算读码到 STD/GK/下件的端到端时延
+// 发送时间为系统时钟微秒, 与 plc_simulator 同一基准
+
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using sock_t = SOCKET;
+static const sock_t kInvalidSock = INVALID_SOCKET;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+using sock_t = int;
+static const sock_t kInvalidSock = -1;
+#endif
+
+namespace {
+
+int64_t wallUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+    std::string host = "192.168.2.98";
+    uint16_t port = 3011;
+    int stations = 12;
+    double rate = 1.0;
+    std::vector<std::pair<int, double>> stationRates;
+    std::string profile = "steady";
+    double burstRate = 5.0;             // burst 期间的速率倍数
+    int burstMs = 2000;
+    int periodMs = 10000;
+    double rampTo = 10.0;
+    double dupRate = 0.0;
+    double badRate = 0.0;
+    int durationSec = 60;
+    int reportSec = 5;
+    std::string csvPath;
+    std::string prefix = "JT5";
+};
+
+struct Station {
+    int id = 0;
+    double baseRate = 0;                // 每秒包裹数
+    double nextUs = 0;                  // 下一次发送时间(相对开始)
+    uint32_t expectedOrder = 0;         // 程序侧最近一次分配的序列号
+    std::string lastCode;
+    uint64_t ok = 0;
+    uint64_t dup = 0;
+    uint64_t bad = 0;
+};
+
+class LoadGen {
+public:
+    explicit LoadGen(const Options& opt) : opt_(opt), rng_(std::random_device{}()) {}
+
+    bool open() {
+        sock_ = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock_ == kInvalidSock) {
+            std::fprintf(stderr, "create udp socket failed\n");
+            return false;
+        }
+        std::memset(&dest_, 0, sizeof(dest_));
+        dest_.sin_family = AF_INET;
+        dest_.sin_port = htons(opt_.port);
+        if (inet_pton(AF_INET, opt_.host.c_str(), &dest_.sin_addr) != 1) {
+            std::fprintf(stderr, "bad host: %s\n", opt_.host.c_str());
+            return false;
+        }
+        if (!opt_.csvPath.empty()) {
+            csv_ = std::fopen(opt_.csvPath.c_str(), "w");
+            if (!csv_) {
+                std::fprintf(stderr, "open %s failed\n", opt_.csvPath.c_str());
+                return false;
+            }
+            std::setvbuf(csv_, nullptr, _IOFBF, 1 << 20);
+            std::fprintf(csv_, "send_wall_us,station,code,kind,expected_order\n");
+        }
+        runId_ = static_cast<uint64_t>(wallUs() / 1000000) % 100000;    // 单号中带运行编号, 避免与上一次压测的单号重复
+        stations_.resize(static_cast<size_t>(std::max(1, opt_.stations)));
+        for (size_t i = 0; i < stations_.size(); ++i) {
+            Station& s = stations_[i];
+            s.id = static_cast<int>(i) + 1;
+            s.baseRate = opt_.rate;
+            for (const auto& r : opt_.stationRates) {
+                if (r.first == s.id) s.baseRate = r.second;
+            }
+            s.nextUs = std::uniform_real_distribution<double>(0.0, s.baseRate > 0 ? 1e6 / s.baseRate : 0.0)(rng_);   // 各台错开起始时间
+        }
+        return true;
+    }
+
+    void run() {
+        auto start = std::chrono::steady_clock::now();
+        double durationUs = static_cast<double>(opt_.durationSec) * 1e6;
+        double nextReportUs = static_cast<double>(opt_.reportSec) * 1e6;
+        while (true) {
+            Station* next = nullptr;
+            for (Station& s : stations_) {
+                if (s.baseRate <= 0) continue;
+                if (!next || s.nextUs < next->nextUs) next = &s;
+            }
+            if (!next || next->nextUs >= durationUs) break;
+            std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<int64_t>(next->nextUs)));
+            sendOne(*next);
+            double rate = next->baseRate * multiplier(next->nextUs);
+            next->nextUs += rate > 0 ? 1e6 / rate : 1e5;
+            if (opt_.reportSec > 0 && next->nextUs >= nextReportUs) {
+                report(nextReportUs / 1e6);
+                nextReportUs += static_cast<double>(opt_.reportSec) * 1e6;
+            }
+        }
+        report(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if (csv_) std::fclose(csv_);
+    }
+
+    void close() {
+        if (sock_ == kInvalidSock) return;
+#ifdef _WIN32
+        closesocket(sock_);
+#else
+        ::close(sock_);
+#endif
+        sock_ = kInvalidSock;
+    }
+
+private:
+    double multiplier(double tUs) const {                              // 当前时刻相对基础速率的倍数
+        if (opt_.profile == "burst") {
+            int64_t inPeriod = static_cast<int64_t>(tUs / 1000) % std::max(1, opt_.periodMs);
+            return inPeriod < opt_.burstMs ? opt_.burstRate : 1.0;
+        }
+        if (opt_.profile == "ramp" && opt_.rate > 0 && opt_.durationSec > 0) {
+            double f = tUs / (static_cast<double>(opt_.durationSec) * 1e6);
+            return 1.0 + f * (opt_.rampTo / opt_.rate - 1.0);
+        }
+        return 1.0;
+    }
+
+    bool chance(double p) {
+        if (p <= 0) return false;
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < p;
+    }
+
+    void sendOne(Station& s) {
+        char msg[128];
+        int len = 0;
+        const char* kind = "ok";
+        std::string code;
+        if (!s.lastCode.empty() && chance(opt_.dupRate)) {              // 重复读码, 程序不分配新序列号
+            kind = "dup";
+            code = s.lastCode;
+            len = std::snprintf(msg, sizeof(msg), "%s,%.2f,%d\r\n", code.c_str(), weight(), s.id);
+            ++s.dup;
+        }
+        else if (chance(opt_.badRate)) {
+            kind = "bad";
+            code = nextCode();
+            switch (badSeq_++ % 4) {
+            case 0: len = std::snprintf(msg, sizeof(msg), "%s,%.2f\r\n", code.c_str(), weight()); break;
+            case 1: len = std::snprintf(msg, sizeof(msg), "%s,abc,%d\r\n", code.c_str(), s.id); kind = "exception"; break;
+            case 2: len = std::snprintf(msg, sizeof(msg), ",%.2f,%d\r\n", weight(), s.id); kind = "exception"; break;
+            default: len = std::snprintf(msg, sizeof(msg), "%s,%.2f,x%d\r\n", code.c_str(), weight(), s.id); break;
+            }
+            ++s.bad;
+            if (std::strcmp(kind, "exception") == 0) s.expectedOrder = s.expectedOrder >= 9999 ? 1 : s.expectedOrder + 1;
+        }
+        else {
+            code = nextCode();
+            len = std::snprintf(msg, sizeof(msg), "%s,%.2f,%d\r\n", code.c_str(), weight(), s.id);
+            s.lastCode = code;
+            s.expectedOrder = s.expectedOrder >= 9999 ? 1 : s.expectedOrder + 1;
+            ++s.ok;
+        }
+        int64_t sentUs = wallUs();
+        int n = ::sendto(sock_, msg, len, 0, reinterpret_cast<const sockaddr*>(&dest_), sizeof(dest_));
+        if (n != len) ++sendErrors_;
+        if (csv_) {
+            std::fprintf(csv_, "%lld,%d,%s,%s,%u\n", static_cast<long long>(sentUs), s.id, code.c_str(), kind,
+                         std::strcmp(kind, "ok") == 0 || std::strcmp(kind, "exception") == 0 ? s.expectedOrder : 0u);
+        }
+    }
+
+    std::string nextCode() {
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "%s%05llu%07llu", opt_.prefix.c_str(), static_cast<unsigned long long>(runId_),
+                      static_cast<unsigned long long>(++codeSeq_ % 10000000));
+        return buf;
+    }
+
+    double weight() {
+        return std::uniform_real_distribution<double>(0.1, 5.0)(rng_);
+    }
+
+    void report(double elapsedSec) {
+        uint64_t ok = 0, dup = 0, bad = 0;
+        for (const Station& s : stations_) {
+            ok += s.ok;
+            dup += s.dup;
+            bad += s.bad;
+        }
+        double perHour = elapsedSec > 0 ? static_cast<double>(ok) / elapsedSec * 3600.0 : 0.0;
+        std::printf("t:%.1fs parcels:%llu dup:%llu bad:%llu send_errors:%llu parcels_per_hour:%.0f\n", elapsedSec,
+                    static_cast<unsigned long long>(ok), static_cast<unsigned long long>(dup), static_cast<unsigned long long>(bad),
+                    static_cast<unsigned long long>(sendErrors_), perHour);
+        std::fflush(stdout);
+    }
+
+    Options opt_;
+    std::mt19937_64 rng_;
+    sock_t sock_ = kInvalidSock;
+    sockaddr_in dest_{};
+    std::vector<Station> stations_;
+    uint64_t runId_ = 0;
+    uint64_t codeSeq_ = 0;
+    uint64_t badSeq_ = 0;
+    uint64_t sendErrors_ = 0;
+    FILE* csv_ = nullptr;
+};
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--host") opt.host = next();
+        else if (a == "--port") opt.port = static_cast<uint16_t>(std::atoi(next()));
+        else if (a == "--stations") opt.stations = std::atoi(next());
+        else if (a == "--rate") opt.rate = std::atof(next());
+        else if (a == "--station-rate") {
+            std::string v = next();
+            size_t colon = v.find(':');
+            if (colon == std::string::npos) {
+                std::fprintf(stderr, "--station-rate expects <station>:<rate>\n");
+                return false;
+            }
+            opt.stationRates.emplace_back(std::atoi(v.substr(0, colon).c_str()), std::atof(v.substr(colon + 1).c_str()));
+        }
+        else if (a == "--profile") opt.profile = next();
+        else if (a == "--burst-rate") opt.burstRate = std::atof(next());
+        else if (a == "--burst-ms") opt.burstMs = std::atoi(next());
+        else if (a == "--period-ms") opt.periodMs = std::atoi(next());
+        else if (a == "--ramp-to") opt.rampTo = std::atof(next());
+        else if (a == "--dup-rate") opt.dupRate = std::atof(next());
+        else if (a == "--bad-rate") opt.badRate = std::atof(next());
+        else if (a == "--duration-s") opt.durationSec = std::atoi(next());
+        else if (a == "--report-s") opt.reportSec = std::atoi(next());
+        else if (a == "--csv") opt.csvPath = next();
+        else if (a == "--prefix") opt.prefix = next();
+        else {
+            std::fprintf(stderr, "unknown option: %s\n", a.c_str());
+            return false;
+        }
+    }
+    if (opt.profile != "steady" && opt.profile != "burst" && opt.profile != "ramp") {
+        std::fprintf(stderr, "unknown profile: %s\n", opt.profile.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::fprintf(stderr, "WSAStartup failed\n");
+        return 1;
+    }
+#endif
+    LoadGen gen(opt);
+    if (!gen.open()) return 1;
+    gen.run();
+    gen.close();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
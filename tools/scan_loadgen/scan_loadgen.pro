@@ -0,0 +1,8 @@
+TEMPLATE = app
+CONFIG += console c++20
+CONFIG -= app_bundle qt
+
+SOURCES += \
+    main.cpp
+
+win32: LIBS += -lws2_32
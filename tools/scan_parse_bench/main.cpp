@@ -0,0 +1,177 @@
+// 读码报文解析基准: 旧的 splitUdpMessage(stringstream + getline + stoi, 原样复制在下面) 与 scanparser.h 的 parseScanMessage 对比
+// 报文与读码平台格式一致, 单号/重量/台号随机, 可混入格式错误的报文; 统计每条报文的耗时和堆分配次数
+//
+// 用法: scan_parse_bench [--messages 100000] [--rounds 20] [--bad-rate 0.0] [--seed 1]
+//  --messages       报文条数, 每轮全部解析一遍
+//  --rounds         轮数, 输出各轮每条耗时的最小值和中位数
+//  --bad-rate       格式错误报文(缺字段/重量非法/空单号/台号非法)的比例
+// 新解析器分两项: 只解析(parse), 解析后校验单号并格式化重量字符串(parse+code+weight, 即 ingestSupplyMessage 的实际工作量)
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <vector>
+#include <tuple>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "scanparser.h"
+#include "waybillcode.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{ 0 };
+
+// 与原 otherfunction.cpp 中的实现相同, 只去掉了异常时的日志
+std::tuple<std::string, std::string, int> splitUdpMessage(const std::string& msg)
+{
+    std::stringstream ss(msg);
+    std::string item;
+    std::vector<std::string> parts;
+
+    while (std::getline(ss, item, ','))
+    {
+        parts.push_back(item);
+    }
+    try
+    {
+        if (parts.size() >= 3)
+        {
+            std::string code = parts[0];
+            std::string weight = parts[1];
+            int supply_id = std::stoi(parts[2]);
+            return std::make_tuple(code, weight, supply_id);
+        }
+    }
+    catch (const std::exception&)
+    {
+    }
+    return std::make_tuple("", "", -1);
+}
+
+struct Options {
+    size_t messages = 100000;
+    int rounds = 20;
+    double badRate = 0.0;
+    uint32_t seed = 1;
+};
+
+std::vector<std::string> makeMessages(const Options& opt) {
+    std::mt19937 rng(opt.seed);
+    std::uniform_int_distribution<int> station(1, 12);
+    std::uniform_int_distribution<int> grams(50, 30000);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<std::string> out;
+    out.reserve(opt.messages);
+    char buf[96];
+    uint64_t serial = 5400000000000ull;
+    for (size_t i = 0; i < opt.messages; ++i) {
+        int g = grams(rng);
+        int st = station(rng);
+        int len;
+        if (u(rng) < opt.badRate) {
+            switch (i % 4) {
+            case 0: len = std::snprintf(buf, sizeof(buf), "JT%llu,%d.%03d\r\n", static_cast<unsigned long long>(serial++), g / 1000, g % 1000); break;
+            case 1: len = std::snprintf(buf, sizeof(buf), "JT%llu,abc,%d\r\n", static_cast<unsigned long long>(serial++), st); break;
+            case 2: len = std::snprintf(buf, sizeof(buf), ",%d.%03d,%d\r\n", g / 1000, g % 1000, st); break;
+            default: len = std::snprintf(buf, sizeof(buf), "JT%llu,%d.%03d,x%d\r\n", static_cast<unsigned long long>(serial++), g / 1000, g % 1000, st); break;
+            }
+        }
+        else {
+            len = std::snprintf(buf, sizeof(buf), "JT%llu,%d.%03d,%d\r\n", static_cast<unsigned long long>(serial++), g / 1000, g % 1000, st);
+        }
+        out.emplace_back(buf, static_cast<size_t>(len));
+    }
+    return out;
+}
+
+struct Result {
+    double minNs = 0;
+    double medianNs = 0;
+    double allocsPerMsg = 0;
+    uint64_t checksum = 0;              // 防止被优化掉; 前两项为台号与单号长度之和, 应相同
+};
+
+template<typename Fn>
+Result run(const std::vector<std::string>& msgs, int rounds, Fn fn) {
+    std::vector<double> perMsg;
+    Result r;
+    uint64_t allocs = 0;
+    for (int round = 0; round < rounds; ++round) {
+        uint64_t sum = 0;
+        uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+        auto t0 = std::chrono::steady_clock::now();
+        for (const std::string& m : msgs) sum += fn(std::string_view(m));
+        auto t1 = std::chrono::steady_clock::now();
+        allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+        perMsg.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(msgs.size()));
+        r.checksum = sum;
+    }
+    std::sort(perMsg.begin(), perMsg.end());
+    r.minNs = perMsg.front();
+    r.medianNs = perMsg[perMsg.size() / 2];
+    r.allocsPerMsg = static_cast<double>(allocs) / static_cast<double>(msgs.size()) / rounds;
+    return r;
+}
+
+void print(const char* name, const Result& r, double baseMedian) {
+    std::printf("%-24s min:%8.1f ns  median:%8.1f ns  allocs/msg:%5.2f  speedup:%6.1fx  checksum:%llu\n",
+                name, r.minNs, r.medianNs, r.allocsPerMsg, baseMedian / r.medianNs, static_cast<unsigned long long>(r.checksum));
+}
+
+} // namespace
+
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--messages") opt.messages = static_cast<size_t>(std::atoll(next()));
+        else if (a == "--rounds") opt.rounds = std::max(1, std::atoi(next()));
+        else if (a == "--bad-rate") opt.badRate = std::atof(next());
+        else if (a == "--seed") opt.seed = static_cast<uint32_t>(std::atoi(next()));
+        else {
+            std::fprintf(stderr, "usage: scan_parse_bench [--messages N] [--rounds N] [--bad-rate R] [--seed S]\n");
+            return 1;
+        }
+    }
+    std::vector<std::string> msgs = makeMessages(opt);
+    std::printf("messages:%zu rounds:%d bad_rate:%.2f\n", msgs.size(), opt.rounds, opt.badRate);
+
+    Result legacy = run(msgs, opt.rounds, [](std::string_view m) -> uint64_t {
+        auto [code, weight, supply_id] = splitUdpMessage(std::string(m));          //原调用方式: 先复制成 std::string
+        return static_cast<uint64_t>(supply_id > 0 ? supply_id : 0) + code.size();
+    });
+    Result parse = run(msgs, opt.rounds, [](std::string_view m) -> uint64_t {
+        ScanRecord scan;
+        parseScanMessage(m, scan);
+        return static_cast<uint64_t>(scan.stationId > 0 ? scan.stationId : 0) + scan.codeLen;
+    });
+    Result full = run(msgs, opt.rounds, [](std::string_view m) -> uint64_t {
+        ScanRecord scan;
+        parseScanMessage(m, scan);
+        WaybillCode code;
+        WaybillCode::parse(scan.codeView(), code);
+        char weightBuf[24];
+        std::string_view weight = formatWeightKg(scan.weightGrams, weightBuf);
+        return static_cast<uint64_t>(scan.stationId > 0 ? scan.stationId : 0) + code.size() + weight.size();
+    });
+    print("splitUdpMessage", legacy, legacy.medianNs);
+    print("parseScanMessage", parse, legacy.medianNs);
+    print("parse+code+weight", full, legacy.medianNs);
+    return 0;
+}
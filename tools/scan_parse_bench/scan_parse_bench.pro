@@ -0,0 +1,13 @@
+TEMPLATE = app
+CONFIG += console c++20
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../scanparser.h \
+    ../../simdscan.h \
+    ../../waybillcode.h
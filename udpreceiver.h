@@ -13,6 +13,9 @@
 #include <string>
 #include <mutex>
 #include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
 #include "Logger.h"
 
 #ifdef _WIN32
@@ -25,6 +28,7 @@ static const sock_t INVALID_SOCK = INVALID_SOCKET;
 #else
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <unistd.h>
@@ -42,6 +46,27 @@ public:
     // callback: (dataBytes, remoteIp, remotePort)
     using Callback = std::function<void(const std::vector<uint8_t>&, const std::string&, uint16_t)>;
 
+    // 批量接收模式下的单个报文, data 指向接收线程内预分配的缓冲区, 仅在回调期间有效
+    struct Datagram {
+        const uint8_t* data;
+        size_t len;
+        sockaddr_in src;
+        int64_t rxNs = 0;       // 接收时间(系统时钟, 纳秒), 开启内核时间戳时为内核收包时间
+    };
+    // batch callback: 每次系统调用收到的全部报文只回调一次
+    using BatchCallback = std::function<void(const Datagram* msgs, size_t count)>;
+
+    // 直接写入外部槽位(如 SpscRing 的槽位)的接收方式, 接收线程不再做任何拷贝和分配
+    struct RecvSlot {
+        uint8_t* data;          // 槽位缓冲区
+        size_t cap;             // 缓冲区大小, 超长报文会被丢弃
+        uint32_t* len;          // 接收线程写入报文长度, 0 表示该槽位无效
+        int64_t* rxNs = nullptr; // 可选, 接收线程写入接收时间, 同 Datagram::rxNs
+    };
+    using ReserveFn = std::function<size_t(RecvSlot* recvSlots, size_t max)>;         // 返回可用槽位数
+    using CommitFn = std::function<void(size_t n)>;                                // 发布前 n 个槽位
+    using OverflowFn = std::function<void(const Datagram* msgs, size_t count)>;   // 槽位不足时收到的报文
+
     UdpReceiver(uint16_t port = 3011, const std::string& bindIp = "0.0.0.0")
         : port_(port), bindIp_(bindIp), sock_(INVALID_SOCK), running_(false)
     {
@@ -80,6 +105,17 @@ public:
         setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
 #endif
 
+        // 内核收包时间戳, 通过 recvmmsg 的控制消息取回; 不支持时退回到用户态取时间
+        if (rxTimestamps_) {
+#ifdef SO_TIMESTAMPNS
+            if (setsockopt(sock_, SOL_SOCKET, SO_TIMESTAMPNS, &yes, sizeof(yes)) != 0) {
+                printLastError("setsockopt(SO_TIMESTAMPNS)");
+            }
+#else
+            Logger::getInstance().Log("----[UdpReceiver] start() SO_TIMESTAMPNS is not supported, use user space receive time");
+#endif
+        }
+
         // allow broadcast by default (so sendBroadcast works without extra sockopt later)
 #ifdef _WIN32
         setsockopt(sock_, SOL_SOCKET, SO_BROADCAST, (const char*)&yes, sizeof(yes));
@@ -122,10 +158,9 @@ public:
         if (!running_) return;
         running_ = false;
 
-        // closing socket will cause select/recvfrom to error/return
-        closeSocket();
-
+        // receive loops wake up at least every 500ms, join first so the socket is not closed under them
         if (workerThread_.joinable()) workerThread_.join();
+        closeSocket();
         cleanupWinsockIfNeeded();
     }
 
@@ -134,6 +169,42 @@ public:
         callback_ = std::move(cb);
     }
 
+    // 绑定前开启 SO_TIMESTAMPNS, 批量/零拷贝模式下 Datagram::rxNs 和 RecvSlot::rxNs 为内核收包时间
+    // 未开启或平台不支持时为接收线程读到报文的时间; 必须在 start() 之前调用
+    void setRxTimestamps(bool on) { rxTimestamps_ = on; }
+
+    // 系统时钟(纳秒), 与内核时间戳同一时钟, 可直接相减
+    static int64_t wallNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // 开启批量接收: Linux 下使用 recvmmsg 一次最多取 batchSize 个报文, 其他平台用非阻塞 recvfrom 排空
+    // 必须在 start() 之前调用; maxDatagram 为单个报文缓冲区大小, 超长报文会被丢弃
+    void setBatchCallback(BatchCallback cb, size_t batchSize = 32, size_t maxDatagram = 2048) {
+        std::lock_guard<std::mutex> lg(cbMutex_);
+        batchCallback_ = std::move(cb);
+        batchSize_ = std::max<size_t>(1, batchSize);
+        maxDatagram_ = std::max<size_t>(64, maxDatagram);
+    }
+
+    // 开启零拷贝接收: 每批先 reserve 槽位, recvmmsg 直接写入槽位, 再 commit
+    // reserve 返回 0 时报文读入内部缓冲区并交给 overflow(未设置则只计数丢弃)
+    // 必须在 start() 之前调用
+    void setSlotSink(ReserveFn reserve, CommitFn commit, OverflowFn overflow = nullptr, size_t batchSize = 32) {
+        std::lock_guard<std::mutex> lg(cbMutex_);
+        reserveFn_ = std::move(reserve);
+        commitFn_ = std::move(commit);
+        overflowFn_ = std::move(overflow);
+        batchSize_ = std::max<size_t>(1, batchSize);
+    }
+
+    // 批量模式统计
+    uint64_t batchCount() const { return batchCount_.load(std::memory_order_relaxed); }
+    uint64_t datagramCount() const { return datagramCount_.load(std::memory_order_relaxed); }
+    uint64_t truncatedCount() const { return truncatedCount_.load(std::memory_order_relaxed); }
+    uint64_t sinkFullCount() const { return sinkFullCount_.load(std::memory_order_relaxed); }
+    uint64_t kernelTimestampCount() const { return kernelTsCount_.load(std::memory_order_relaxed); }
+
     // Join IPv4 multicast group (simple helper). Return true on success.
     bool joinMulticastGroup(const std::string& mcastAddr) {
         if (sock_ == INVALID_SOCK) {
@@ -238,6 +309,21 @@ public:
 
 private:
     void runLoop() {
+        bool batched = false;
+        bool direct = false;
+        {
+            std::lock_guard<std::mutex> lg(cbMutex_);
+            batched = static_cast<bool>(batchCallback_);
+            direct = reserveFn_ && commitFn_;
+        }
+        if (direct) {
+            runSlotLoop();
+            return;
+        }
+        if (batched) {
+            runBatchLoop();
+            return;
+        }
         const int BUF_SIZE = 65536;
         std::vector<uint8_t> buffer(BUF_SIZE);
 
@@ -318,6 +404,290 @@ private:
         }
     }
 
+    // 批量接收循环: 缓冲区在循环开始前一次性分配, 每批只取一次回调、只记录一次最后发送方
+    void runBatchLoop() {
+        BatchCallback cb;
+        size_t batch = 0;
+        size_t maxLen = 0;
+        {
+            std::lock_guard<std::mutex> lg(cbMutex_);
+            cb = batchCallback_;
+            batch = batchSize_;
+            maxLen = maxDatagram_;
+        }
+        std::vector<uint8_t> storage(batch * maxLen);
+        std::vector<Datagram> msgs(batch);
+        Logger::getInstance().Log("----[UdpReceiver] runBatchLoop() batch size = [" + std::to_string(batch) + "]");
+
+#ifdef __linux__
+        // SO_RCVTIMEO 代替 select, recvmmsg + MSG_WAITFORONE 在至少收到一个报文后立即返回
+        timeval rcvTimeout{ 0, 500000 };
+        setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, sizeof(rcvTimeout));
+        std::vector<mmsghdr> hdrs(batch);
+        std::vector<iovec> iovs(batch);
+        std::vector<sockaddr_in> srcs(batch);
+        std::vector<CmsgBuf> ctrls(batch);
+
+        while (running_) {
+            for (size_t i = 0; i < batch; ++i) {
+                iovs[i].iov_base = storage.data() + i * maxLen;
+                iovs[i].iov_len = maxLen;
+                std::memset(&hdrs[i], 0, sizeof(mmsghdr));
+                hdrs[i].msg_hdr.msg_iov = &iovs[i];
+                hdrs[i].msg_hdr.msg_iovlen = 1;
+                hdrs[i].msg_hdr.msg_name = &srcs[i];
+                hdrs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                setControl(hdrs[i].msg_hdr, ctrls[i]);
+            }
+            int n = recvmmsg(sock_, hdrs.data(), static_cast<unsigned int>(batch), MSG_WAITFORONE, nullptr);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;        // 超时, 检查 running_
+                printLastError("recvmmsg()");
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            size_t count = 0;
+            int64_t userNs = wallNowNs();
+            for (int i = 0; i < n; ++i) {
+                if (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC) {                                  // 超长报文, 丢弃
+                    truncatedCount_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                msgs[count].data = storage.data() + static_cast<size_t>(i) * maxLen;
+                msgs[count].len = hdrs[i].msg_len;
+                msgs[count].src = srcs[i];
+                msgs[count].rxNs = rxTime(hdrs[i].msg_hdr, userNs);
+                ++count;
+            }
+            deliverBatch(cb, msgs.data(), count);
+        }
+#else
+        // 非 Linux: select 等待可读, 然后用非阻塞 recvfrom 一次排空最多 batch 个报文
+        setNonBlocking(true);
+        while (running_) {
+            fd_set readfds;
+            FD_ZERO(&readfds);
+            FD_SET(sock_, &readfds);
+            timeval tv{ 0, 500000 };
+#ifdef _WIN32
+            int sel = select(0, &readfds, nullptr, nullptr, &tv);
+#else
+            int sel = select(sock_ + 1, &readfds, nullptr, nullptr, &tv);
+#endif
+            if (sel < 0) {
+                printLastError("select()");
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (sel == 0) continue;
+            size_t count = 0;
+            while (count < batch) {
+                sockaddr_in src{};
+                socklen_t srclen = sizeof(src);
+                uint8_t* slot = storage.data() + count * maxLen;
+                int n = recvfrom(sock_, reinterpret_cast<char*>(slot), static_cast<int>(maxLen), 0,
+                                 reinterpret_cast<sockaddr*>(&src), &srclen);
+                if (n < 0) {
+#ifdef _WIN32
+                    if (WSAGetLastError() == WSAEMSGSIZE) {
+                        truncatedCount_.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+#endif
+                    break;                                                                  // EWOULDBLOCK: 已排空
+                }
+                msgs[count].data = slot;
+                msgs[count].len = static_cast<size_t>(n);
+                msgs[count].src = src;
+                msgs[count].rxNs = wallNowNs();
+                ++count;
+            }
+            deliverBatch(cb, msgs.data(), count);
+        }
+#endif
+    }
+
+    // 零拷贝接收循环: 报文直接落入 reserve 得到的槽位
+    void runSlotLoop() {
+        ReserveFn reserve;
+        CommitFn commit;
+        OverflowFn overflow;
+        size_t batch = 0;
+        {
+            std::lock_guard<std::mutex> lg(cbMutex_);
+            reserve = reserveFn_;
+            commit = commitFn_;
+            overflow = overflowFn_;
+            batch = batchSize_;
+        }
+        std::vector<RecvSlot> recvSlots(batch);
+        std::vector<uint32_t> scratchLens(batch);
+        std::vector<uint8_t> scratch(batch * maxDatagram_);
+        std::vector<Datagram> msgs(batch);
+        Logger::getInstance().Log("----[UdpReceiver] runSlotLoop() batch size = [" + std::to_string(batch) + "]");
+#ifdef __linux__
+        timeval rcvTimeout{ 0, 500000 };
+        setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &rcvTimeout, sizeof(rcvTimeout));
+        std::vector<mmsghdr> hdrs(batch);
+        std::vector<iovec> iovs(batch);
+        std::vector<sockaddr_in> srcs(batch);
+        std::vector<CmsgBuf> ctrls(batch);
+#else
+        setNonBlocking(true);
+#endif
+        while (running_) {
+            size_t avail = reserve(recvSlots.data(), batch);
+            bool toScratch = (avail == 0);
+            if (toScratch) {                                                        // 槽位已满, 读入内部缓冲区避免内核缓冲区堆积
+                for (size_t i = 0; i < batch; ++i) {
+                    recvSlots[i] = RecvSlot{ scratch.data() + i * maxDatagram_, maxDatagram_, &scratchLens[i] };
+                }
+                avail = batch;
+            }
+            size_t got = 0;
+#ifdef __linux__
+            for (size_t i = 0; i < avail; ++i) {
+                iovs[i].iov_base = recvSlots[i].data;
+                iovs[i].iov_len = recvSlots[i].cap;
+                std::memset(&hdrs[i], 0, sizeof(mmsghdr));
+                hdrs[i].msg_hdr.msg_iov = &iovs[i];
+                hdrs[i].msg_hdr.msg_iovlen = 1;
+                hdrs[i].msg_hdr.msg_name = &srcs[i];
+                hdrs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                setControl(hdrs[i].msg_hdr, ctrls[i]);
+            }
+            int n = recvmmsg(sock_, hdrs.data(), static_cast<unsigned int>(avail), MSG_WAITFORONE, nullptr);
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    printLastError("recvmmsg()");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+                continue;
+            }
+            int64_t userNs = wallNowNs();
+            for (int i = 0; i < n; ++i) {
+                bool truncated = (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+                if (truncated) truncatedCount_.fetch_add(1, std::memory_order_relaxed);
+                *recvSlots[i].len = truncated ? 0 : hdrs[i].msg_len;
+                msgs[i] = Datagram{ recvSlots[i].data, *recvSlots[i].len, srcs[i], rxTime(hdrs[i].msg_hdr, userNs) };
+                if (recvSlots[i].rxNs) *recvSlots[i].rxNs = msgs[i].rxNs;
+            }
+            got = static_cast<size_t>(n);
+#else
+            fd_set readfds;
+            FD_ZERO(&readfds);
+            FD_SET(sock_, &readfds);
+            timeval tv{ 0, 500000 };
+#ifdef _WIN32
+            int sel = select(0, &readfds, nullptr, nullptr, &tv);
+#else
+            int sel = select(sock_ + 1, &readfds, nullptr, nullptr, &tv);
+#endif
+            if (sel < 0) {
+                printLastError("select()");
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (sel == 0) continue;
+            while (got < avail) {
+                sockaddr_in src{};
+                socklen_t srclen = sizeof(src);
+                int n = recvfrom(sock_, reinterpret_cast<char*>(recvSlots[got].data), static_cast<int>(recvSlots[got].cap), 0,
+                                 reinterpret_cast<sockaddr*>(&src), &srclen);
+                if (n < 0) {
+#ifdef _WIN32
+                    if (WSAGetLastError() == WSAEMSGSIZE) {
+                        truncatedCount_.fetch_add(1, std::memory_order_relaxed);
+                        *recvSlots[got].len = 0;
+                        msgs[got] = Datagram{ recvSlots[got].data, 0, src, wallNowNs() };
+                        if (recvSlots[got].rxNs) *recvSlots[got].rxNs = msgs[got].rxNs;
+                        ++got;
+                        continue;
+                    }
+#endif
+                    break;
+                }
+                *recvSlots[got].len = static_cast<uint32_t>(n);
+                msgs[got] = Datagram{ recvSlots[got].data, static_cast<size_t>(n), src, wallNowNs() };
+                if (recvSlots[got].rxNs) *recvSlots[got].rxNs = msgs[got].rxNs;
+                ++got;
+            }
+#endif
+            if (got == 0) continue;
+            batchCount_.fetch_add(1, std::memory_order_relaxed);
+            datagramCount_.fetch_add(got, std::memory_order_relaxed);
+            recordLastSender(msgs[got - 1].src);
+            if (toScratch) {
+                sinkFullCount_.fetch_add(got, std::memory_order_relaxed);
+                if (overflow) overflow(msgs.data(), got);
+            }
+            else {
+                commit(got);
+            }
+        }
+    }
+
+#ifdef __linux__
+    // 每个报文的控制消息缓冲区, 只用于取 SCM_TIMESTAMPNS
+    struct CmsgBuf {
+        alignas(cmsghdr) char data[CMSG_SPACE(sizeof(timespec))];
+    };
+    void setControl(msghdr& hdr, CmsgBuf& buf) {
+        if (!rxTimestamps_) return;
+        hdr.msg_control = buf.data;
+        hdr.msg_controllen = sizeof(buf.data);
+    }
+    // 取内核收包时间, 没有时间戳控制消息时返回 fallbackNs
+    int64_t rxTime(msghdr& hdr, int64_t fallbackNs) {
+        if (!rxTimestamps_) return fallbackNs;
+        for (cmsghdr* c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec ts;
+                std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                kernelTsCount_.fetch_add(1, std::memory_order_relaxed);
+                return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+            }
+        }
+        return fallbackNs;
+    }
+#endif
+
+    void deliverBatch(const BatchCallback& cb, const Datagram* msgs, size_t count) {
+        if (count == 0) return;
+        batchCount_.fetch_add(1, std::memory_order_relaxed);
+        datagramCount_.fetch_add(count, std::memory_order_relaxed);
+        recordLastSender(msgs[count - 1].src);
+        try {
+            cb(msgs, count);
+        }
+        catch (const std::exception& e) {
+            Logger::getInstance().Log(std::string("Batch callback threw: ") + e.what());
+        }
+        catch (...) {
+            Logger::getInstance().Log("Batch callback threw unknown exception");
+        }
+    }
+
+    void recordLastSender(const sockaddr_in& src) {
+        std::lock_guard<std::mutex> lg(lastSrcMutex_);
+        lastSrcAddr_ = src;
+        lastSrcValid_ = true;
+        char ipbuf[INET_ADDRSTRLEN] = { 0 };
+        inet_ntop(AF_INET, &src.sin_addr, ipbuf, sizeof(ipbuf));
+        lastSrcIp_ = std::string(ipbuf);
+        lastSrcPort_ = ntohs(src.sin_port);
+    }
+
+    void setNonBlocking(bool on) {
+#ifdef _WIN32
+        u_long mode = on ? 1 : 0;
+        ioctlsocket(sock_, FIONBIO, &mode);
+#else
+        int flags = fcntl(sock_, F_GETFL, 0);
+        fcntl(sock_, F_SETFL, on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+    }
+
     std::string addrToString(const sockaddr_in& a) {
         char buf[INET_ADDRSTRLEN] = { 0 };
         const char* res = inet_ntop(AF_INET, (const void*)&a.sin_addr, buf, INET_ADDRSTRLEN);
@@ -355,9 +725,21 @@ private:
     std::string bindIp_;
     sock_t sock_;
     std::atomic<bool> running_;
+    bool rxTimestamps_ = false;
     std::thread workerThread_;
     std::mutex cbMutex_;
     Callback callback_;
+    BatchCallback batchCallback_;
+    size_t batchSize_ = 32;
+    size_t maxDatagram_ = 2048;
+    std::atomic<uint64_t> batchCount_{ 0 };
+    std::atomic<uint64_t> datagramCount_{ 0 };
+    std::atomic<uint64_t> truncatedCount_{ 0 };
+    std::atomic<uint64_t> sinkFullCount_{ 0 };
+    std::atomic<uint64_t> kernelTsCount_{ 0 };
+    ReserveFn reserveFn_;
+    CommitFn commitFn_;
+    OverflowFn overflowFn_;
     std::mutex startStopMutex_;
 
     // last sender info
@@ -0,0 +1,96 @@
+#ifndef UNLOADPARSER_H
+#define UNLOADPARSER_H
+
+// PLC 下件报文解析: "SU213D04ID0001G2008" -> (SU, 小车 213, 供包台 4, 序列号 1, 格口 2008)
+// 一次遍历得到类型化的记录, 不做堆分配; 多帧合并的数据("...#...#")用 simdscan 查找 '#' 逐帧解析
+// 标准格式按 plcframes::kUnload 严格解码, 不符合时退回宽松规则: 第一个 D<台2>ID<序4> 为序列号键, 其后 'G' 后的数字为格口
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include "plcframes.h"
+#include "simdscan.h"
+
+struct UnloadRecord {
+    enum Status : uint8_t { Unknown = 0, Su, Fa };
+    Status status = Unknown;
+    int cart = -1;                      // 小车号, 宽松解析时为 -1
+    int station = -1;                   // 供包台号
+    int order = -1;                     // 供包台序列号
+    int slot = -1;                      // 格口号, 没有时为 -1
+
+    bool hasKey() const { return station > 0 && order > 0; }
+};
+
+inline const char* unloadStatusName(UnloadRecord::Status s) {
+    switch (s) {
+    case UnloadRecord::Su: return "SU";
+    case UnloadRecord::Fa: return "FA";
+    default: return "unknown";
+    }
+}
+
+// 解析一帧(不含 '#'), 找到序列号键返回 true
+inline bool parseUnloadRecord(std::string_view f, UnloadRecord& out) {
+    out = UnloadRecord();
+    int v[5];
+    if (plcframes::decode(plcframes::kUnload, f, v, 5) == f.size() && !f.empty()) {
+        out.status = v[0] == plcframes::Su ? UnloadRecord::Su : UnloadRecord::Fa;
+        out.cart = v[1];
+        out.station = v[2];
+        out.order = v[3];
+        out.slot = v[4];
+        return out.hasKey();
+    }
+    if (f.size() >= 2 && f[0] == 'S' && f[1] == 'U') out.status = UnloadRecord::Su;
+    else if (f.size() >= 2 && f[0] == 'F' && f[1] == 'A') out.status = UnloadRecord::Fa;
+    for (size_t d = f.find('D'); d != std::string_view::npos; d = f.find('D', d + 1)) {
+        int key[2];
+        size_t n = plcframes::decode(plcframes::kKey, f.substr(d), key, 2);
+        if (!n) continue;
+        out.station = key[0];
+        out.order = key[1];
+        size_t g = f.find('G', d + n);
+        if (g != std::string_view::npos) {
+            int slot = 0;
+            size_t i = g + 1;
+            for (; i < f.size() && i < g + 6 && f[i] >= '0' && f[i] <= '9'; ++i) slot = slot * 10 + (f[i] - '0');
+            if (i > g + 1) out.slot = slot;
+        }
+        return out.hasKey();
+    }
+    return false;
+}
+
+// 按 '#' 切分合并的多帧数据, 对每一帧调用 fn(const UnloadRecord&, std::string_view frame), 返回帧数
+// 解析失败的帧同样回调(hasKey() 为 false), 由调用方决定是否记录
+template<typename Fn>
+inline size_t forEachUnloadRecord(std::string_view data, Fn&& fn) {
+    size_t count = 0;
+    const char* p = data.data();
+    size_t n = data.size();
+    size_t start = 0;
+    while (start < n) {
+        size_t hash = start + simdscan::find(p + start, n - start, '#');
+        if (hash > start) {
+            std::string_view f(p + start, hash - start);
+            UnloadRecord r;
+            parseUnloadRecord(f, r);
+            fn(static_cast<const UnloadRecord&>(r), f);
+            ++count;
+        }
+        start = hash + 1;
+    }
+    return count;
+}
+
+// 解析到调用方提供的定长数组, 超过 max 的帧忽略, 返回写入的记录数
+inline size_t parseUnloadRecords(std::string_view data, UnloadRecord* out, size_t max) {
+    size_t k = 0;
+    forEachUnloadRecord(data, [&](const UnloadRecord& r, std::string_view) {
+        if (k < max) out[k++] = r;
+    });
+    return k;
+}
+
+#endif // UNLOADPARSER_H
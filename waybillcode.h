@@ -0,0 +1,101 @@
+#ifndef WAYBILLCODE_H
+#define WAYBILLCODE_H
+
+// 运单号值类型: 内联定长存储(最多 32 字符), 构造时校验字符集并算好哈希, 复制和跨线程传递都不做堆分配
+// 允许的字符为数字、字母和 '-', 不合法或超长时 parse() 返回 false, 由调用方决定丢弃并记录
+// 只在边界转换: str() 给数据库接口, toQString()/fromQString() 给 HTTP 请求和接口返回
+// 哈希为 64 位 FNV-1a, 包裹状态按它分片, InflightTable 的单号索引也用它
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#ifdef QT_CORE_LIB
+#include <QString>
+#include <QMetaType>
+#endif
+
+class WaybillCode {
+public:
+    static constexpr size_t kMaxLen = 32;
+
+    WaybillCode() = default;
+
+    static constexpr bool isValidChar(char c) {
+        return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '-';
+    }
+
+    static constexpr uint64_t hashOf(std::string_view s) {
+        uint64_t h = 1469598103934665603ull;
+        for (char c : s) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // 校验并写入 out, 不合法时 out 不变
+    static bool parse(std::string_view s, WaybillCode& out) {
+        if (s.empty() || s.size() > kMaxLen) return false;
+        for (char c : s) {
+            if (!isValidChar(c)) return false;
+        }
+        std::memcpy(out.data_, s.data(), s.size());
+        out.len_ = static_cast<uint8_t>(s.size());
+        out.hash_ = hashOf(s);
+        return true;
+    }
+
+    // 不合法时返回空单号
+    static WaybillCode from(std::string_view s) {
+        WaybillCode c;
+        parse(s, c);
+        return c;
+    }
+
+#ifdef QT_CORE_LIB
+    // 逐字符取 ASCII, 不经过 QByteArray
+    static WaybillCode fromQString(const QString& s) {
+        if (s.isEmpty() || s.size() > static_cast<int>(kMaxLen)) return WaybillCode();
+        char buf[kMaxLen];
+        size_t n = static_cast<size_t>(s.size());
+        for (size_t i = 0; i < n; ++i) {
+            char16_t u = s.at(static_cast<int>(i)).unicode();
+            if (u > 0x7f) return WaybillCode();
+            buf[i] = static_cast<char>(u);
+        }
+        return from(std::string_view(buf, n));
+    }
+    QString toQString() const { return QString::fromLatin1(data_, len_); }
+#endif
+
+    std::string str() const { return std::string(data_, len_); }
+    std::string_view view() const { return std::string_view(data_, len_); }
+    const char* data() const { return data_; }
+    size_t size() const { return len_; }
+    bool empty() const { return len_ == 0; }
+    uint64_t hash() const { return hash_; }
+
+    friend bool operator==(const WaybillCode& a, const WaybillCode& b) { return a.hash_ == b.hash_ && a.view() == b.view(); }
+    friend bool operator!=(const WaybillCode& a, const WaybillCode& b) { return !(a == b); }
+
+private:
+    char data_[kMaxLen] = {};
+    uint8_t len_ = 0;
+    uint64_t hash_ = 0;
+};
+
+namespace std {
+template<>
+struct hash<WaybillCode> {
+    size_t operator()(const WaybillCode& c) const noexcept { return static_cast<size_t>(c.hash()); }
+};
+}
+
+#ifdef QT_CORE_LIB
+Q_DECLARE_METATYPE(WaybillCode)
+#endif
+
+#endif // WAYBILLCODE_H